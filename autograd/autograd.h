@@ -0,0 +1,185 @@
+#ifndef INCLUDED_AUTOGRAD
+#define INCLUDED_AUTOGRAD
+
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "../tensor/tensor.h"
+
+namespace autodiff::autograd
+{
+    inline constexpr size_t none = std::numeric_limits<size_t>::max();
+
+    enum class Op
+    {
+        Leaf,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Max,
+        Min,
+        Pow,
+        Matmul,
+        Concat,
+        Sum,
+    };
+
+    // Live range of one gradient buffer in backward steps (step 0 handles
+    // the output node) and its size in elements.
+    struct Interval
+    {
+        size_t first;
+        size_t last;
+        size_t size;
+    };
+
+    // Offsets into one slab such that intervals live at the same step never
+    // overlap. Intervals with size 0 get offset none.
+    struct GradientPlan
+    {
+        std::vector<size_t> offsets;
+        size_t              size = 0;           // slab elements
+    };
+
+    GradientPlan plan_gradients(std::vector<Interval> const &intervals);
+
+    class Tape;
+
+    // Handle to a node recorded on a tape. The tape must outlive it.
+    class Var
+    {
+        Tape  *d_tape;
+        size_t d_index;
+
+    public:
+        Var(Tape &tape, size_t index);
+
+        Tape  &tape()  const;
+        size_t index() const;
+
+        Tensor const &value() const;
+        Tensor const &grad()  const;            // see Tape::grad
+    };
+
+    // Records the forward pass of Var operations and runs reverse mode
+    // over it. Gradients of intermediate nodes live in one slab laid out by
+    // plan_gradients, so a backward pass allocates nothing per node and the
+    // slab is reused by later passes on the same tape.
+    //
+    // With checkpointing only the values of leaves and segment boundaries
+    // are kept; the values inside a segment are released when the segment
+    // is closed and recomputed from its inputs when backward() reaches it.
+    class Tape
+    {
+    public:
+        struct Node
+        {
+            Op     op;
+            size_t lhs    = none;
+            size_t rhs    = none;               // none for scalar operands
+            double scalar = 0;                  // scalar operand or exponent
+            bool   scalar_lhs = false;          // scalar op var instead of var op scalar
+            size_t axis   = 0;                  // concatenate
+            bool   flatten = false;             // concatenate without axis
+            bool   requires_grad = false;
+            bool   boundary = false;            // value kept by checkpointing
+            Dims   shape{};                     // of the value
+            std::optional<Tensor> value{};      // empty while released
+        };
+
+    private:
+        std::deque<Node>                    d_nodes;    // stable addresses
+        std::vector<std::optional<Tensor>>  d_grads;
+        std::vector<bool>                   d_ready;
+        std::shared_ptr<memory::Buffer>     d_slab;
+        GradientPlan                        d_plan;
+        std::vector<size_t>                 d_recomputed;
+        size_t                              d_segment = 0;  // first node of the open segment
+        bool                                d_automatic = false;
+
+    public:
+        Var variable(Tensor const &value);      // leaf that receives a gradient
+        Var constant(Tensor const &value);      // leaf that does not
+
+        // Appends a node, computing its value unless it is given; used by
+        // the Var operations
+        Var record(Node node);
+
+        // Closes the open segment at boundary: the values recorded since
+        // the previous boundary are released, except those of leaves.
+        void checkpoint(Var const &boundary);
+
+        // Closes a segment whenever it holds about sqrt(size()) nodes,
+        // which keeps O(sqrt(N)) values alive for a chain of N nodes.
+        void checkpoint_automatically(bool enable = true);
+
+        // Gradients of every node the output depends on, seeded with ones.
+        // Overwrites the gradients of a previous pass.
+        void backward(Var const &output);
+
+        // Gradient of a variable() leaf after backward()
+        Tensor const &grad(Var const &var) const;
+
+        // Drops the recorded nodes, keeps the gradient slab
+        void clear();
+
+        // Value of a node, recomputed if checkpointing released it
+        Tensor const &value(size_t index);
+
+        size_t size() const;
+        size_t resident() const;                // elements of the values held
+        Node const &node(size_t index) const;
+        GradientPlan const &plan() const;       // of the last backward()
+
+    private:
+        Tensor forward(Node const &node);
+        void release(size_t index);
+        void release_recomputed(size_t above);
+
+        void propagate(size_t index);
+
+        template <typename E>
+        void contribute(size_t index, E const &value);
+        void contribute_matmul(Node const &node, Tensor const &grad);
+        void contribute_concat(Node const &node, Tensor const &grad);
+    };
+
+    Var operator+(Var const &lhs, Var const &rhs);
+    Var operator+(Var const &lhs, double rhs);
+    Var operator+(double lhs, Var const &rhs);
+
+    Var operator-(Var const &lhs, Var const &rhs);
+    Var operator-(Var const &lhs, double rhs);
+    Var operator-(double lhs, Var const &rhs);
+
+    Var operator*(Var const &lhs, Var const &rhs);
+    Var operator*(Var const &lhs, double rhs);
+    Var operator*(double lhs, Var const &rhs);
+
+    Var operator/(Var const &lhs, Var const &rhs);
+    Var operator/(Var const &lhs, double rhs);
+    Var operator/(double lhs, Var const &rhs);
+
+    Var maximum(Var const &lhs, Var const &rhs);
+    Var maximum(Var const &lhs, double rhs);
+    Var maximum(double lhs, Var const &rhs);
+
+    Var minimum(Var const &lhs, Var const &rhs);
+    Var minimum(Var const &lhs, double rhs);
+    Var minimum(double lhs, Var const &rhs);
+
+    Var power(Var const &base, double exponent);
+
+    // operands of rank 1 and 2 only, others throw invalid_argument
+    Var matmul(Var const &lhs, Var const &rhs);
+    Var concatenate(Var const &lhs, Var const &rhs, std::optional<size_t> axis = 0);
+
+    Var sum(Var const &var);                    // shape {1}
+}
+
+#endif
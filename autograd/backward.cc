@@ -0,0 +1,245 @@
+#include "autograd.ih"
+
+namespace autodiff::autograd
+{
+    namespace
+    {
+        // update<Assign> writes a broadcast expression into a tensor
+        struct Assign
+        {
+            static void run(double const *, double const *values, double *res, size_t size)
+            {
+                copy(values, values + size, res);
+            }
+
+            static void run(double const *, double value, double *res, size_t size)
+            {
+                fill_n(res, size, value);
+            }
+        };
+
+        // dest (+)= src summed over the axes along which dest broadcasts
+        void reduce_into(Tensor const &src, Tensor &dest, bool accumulate)
+        {
+            if (not accumulate)
+                fill(dest.data(), dest.data() + dest.size(), 0.0);
+
+            BroadcastIterator iter{src.shape(), expr::broadcast_strides(dest, src.shape()),
+                                   src.strides(), Dims(src.rank())};
+
+            double *out      = dest.data();
+            double const *in = src.data();
+            for (size_t run = 0; run < iter.runs(); ++run, iter.next())
+                for (size_t i = 0; i < iter.length(); ++i)
+                    out[iter.res() + i * iter.res_step()] += in[iter.lhs() + i * iter.lhs_step()];
+        }
+    }
+
+    // Adds value to the gradient of a node, or initialises it with the first
+    // contribution. Values of the shape of the node, or broadcasting into it,
+    // are written in one fused pass; broadcast operands are reduced.
+    template <typename E>
+    void Tape::contribute(size_t index, E const &value)
+    {
+        if (not d_nodes[index].requires_grad)
+            return;
+
+        Tensor &grad = *d_grads[index];
+        if (expr::broadcast_shape(grad.shape(), value.shape()) == grad.shape())
+        {
+            if (d_ready[index])
+                grad += value;
+            else
+                expr::update<Assign>(grad, expr::wrap(value));
+        }
+        else
+            reduce_into(Tensor{value}, grad, d_ready[index]);
+
+        d_ready[index] = true;
+    }
+
+    void Tape::propagate(size_t index)
+    {
+        Node const &node = d_nodes[index];
+        Tensor const &grad = *d_grads[index];
+        double const c     = node.scalar;
+        bool const scalar  = node.rhs == none;
+
+        switch (node.op)
+        {
+            case Op::Add:
+                contribute(node.lhs, grad);
+                if (not scalar)
+                    contribute(node.rhs, grad);
+            break;
+
+            case Op::Sub:
+                if (scalar and node.scalar_lhs)
+                    contribute(node.lhs, grad * -1.0);
+                else
+                    contribute(node.lhs, grad);
+                if (not scalar)
+                    contribute(node.rhs, grad * -1.0);
+            break;
+
+            case Op::Mul:
+                if (scalar)
+                    contribute(node.lhs, grad * c);
+                else
+                {
+                    Tensor const &lhs = value(node.lhs);
+                    Tensor const &rhs = value(node.rhs);
+                    contribute(node.lhs, grad * rhs);
+                    contribute(node.rhs, grad * lhs);
+                }
+            break;
+
+            case Op::Div:
+                if (scalar and node.scalar_lhs)             // c / x
+                {
+                    Tensor const &lhs = value(node.lhs);
+                    contribute(node.lhs, grad * -c / (lhs * lhs));
+                }
+                else if (scalar)
+                    contribute(node.lhs, grad / c);
+                else
+                {
+                    Tensor const &lhs = value(node.lhs);
+                    Tensor const &rhs = value(node.rhs);
+                    contribute(node.lhs, grad / rhs);
+                    contribute(node.rhs, grad * lhs / (rhs * rhs) * -1.0);
+                }
+            break;
+
+            // ties go to the second operand, as in ops::Max and ops::Min;
+            // the masks are fused into the contributions
+            case Op::Max:
+                if (scalar)
+                {
+                    Tensor const &lhs = value(node.lhs);
+                    if (node.scalar_lhs)
+                        contribute(node.lhs, grad * (1.0 - (c > lhs)));
+                    else
+                        contribute(node.lhs, grad * (lhs > c));
+                }
+                else
+                {
+                    Tensor const mask{value(node.lhs) > value(node.rhs)};
+                    contribute(node.lhs, grad * mask);
+                    contribute(node.rhs, grad * (1.0 - mask));
+                }
+            break;
+
+            case Op::Min:
+                if (scalar)
+                {
+                    Tensor const &lhs = value(node.lhs);
+                    if (node.scalar_lhs)
+                        contribute(node.lhs, grad * (1.0 - (c < lhs)));
+                    else
+                        contribute(node.lhs, grad * (lhs < c));
+                }
+                else
+                {
+                    Tensor const mask{value(node.lhs) < value(node.rhs)};
+                    contribute(node.lhs, grad * mask);
+                    contribute(node.rhs, grad * (1.0 - mask));
+                }
+            break;
+
+            case Op::Pow:
+                contribute(node.lhs, grad * expr::make<ops::Pow>(value(node.lhs), c - 1) * c);
+            break;
+
+            case Op::Matmul:
+                contribute_matmul(node, grad);
+            break;
+
+            case Op::Concat:
+                contribute_concat(node, grad);
+            break;
+
+            case Op::Sum:
+                contribute(node.lhs, grad);
+            break;
+
+            case Op::Leaf:
+            break;
+        }
+    }
+
+    // For a (m x k) * b (k x n), rank-1 operands taken as a single row of a
+    // or column of b: da = g * b^T and db = a^T * g, with the transposes
+    // expressed through gemm's strides
+    void Tape::contribute_matmul(Node const &node, Tensor const &grad)
+    {
+        Tensor const &a = value(node.lhs);
+        Tensor const &b = value(node.rhs);
+        if (a.rank() > 2 or b.rank() > 2)
+            throw invalid_argument("matmul backward supports operands of rank 1 and 2");
+
+        size_t const m    = a.rank() == 2 ? a.shape()[0]   : 1;
+        size_t const k    = a.shape().back();
+        size_t const n    = b.rank() == 2 ? b.shape()[1]   : 1;
+        size_t const a_rs = a.rank() == 2 ? a.strides()[0] : 0;
+        size_t const a_cs = a.strides().back();
+        size_t const b_rs = b.strides()[0];
+        size_t const b_cs = b.rank() == 2 ? b.strides()[1] : 0;
+        double const *g   = grad.data();
+
+        auto into = [this](size_t index, auto const &product) {
+            if (not d_nodes[index].requires_grad)
+                return;
+
+            Tensor &target = *d_grads[index];
+            if (d_ready[index])
+            {
+                Tensor partial{target.shape(), uninitialized};
+                product(partial.data());
+                target += partial;
+            }
+            else
+                product(target.data());
+            d_ready[index] = true;
+        };
+
+        into(node.lhs, [&](double *da) {
+            gemm(m, k, n, g, n, 1, b.data(), b_cs, b_rs, da, k, 1);
+        });
+        into(node.rhs, [&](double *db) {
+            gemm(k, n, m, a.data(), a_cs, a_rs, g, n, 1, db, n, 1);
+        });
+    }
+
+    // Each input owns a slice of every row of the output along the axis
+    void Tape::contribute_concat(Node const &node, Tensor const &grad)
+    {
+        Dims const &a = d_nodes[node.lhs].shape;
+        Dims const &b = d_nodes[node.rhs].shape;
+
+        size_t outer = 1;
+        if (not node.flatten)
+            for (size_t axis = 0; axis < node.axis; ++axis)
+                outer *= a[axis];
+
+        size_t const a_inner = elements(a) / outer;
+        size_t const b_inner = elements(b) / outer;
+        size_t const row     = a_inner + b_inner;
+
+        auto into = [&](size_t index, size_t first, size_t inner) {
+            if (not d_nodes[index].requires_grad)
+                return;
+
+            double *target  = d_grads[index]->data();
+            double const *g = grad.data() + first;
+            for (size_t o = 0; o < outer; ++o)
+                for (size_t i = 0; i < inner; ++i)
+                    target[o * inner + i] = (d_ready[index] ? target[o * inner + i] : 0.0)
+                                          + g[o * row + i];
+            d_ready[index] = true;
+        };
+
+        into(node.lhs, 0, a_inner);
+        into(node.rhs, a_inner, b_inner);
+    }
+}
@@ -0,0 +1,67 @@
+#include "autograd.ih"
+
+namespace autodiff::autograd
+{
+    namespace
+    {
+        // x op c, or c op x for a scalar on the left
+        template <typename Op>
+        Tensor with_scalar(Tensor const &x, double c, bool scalar_lhs)
+        {
+            if (scalar_lhs)
+                return expr::make<Op>(c, x);
+            return expr::make<Op>(x, c);
+        }
+
+        template <typename Op>
+        Tensor elementwise(Tape &tape, Tape::Node const &node)
+        {
+            Tensor const &lhs = tape.value(node.lhs);
+            if (node.rhs == none)
+                return with_scalar<Op>(lhs, node.scalar, node.scalar_lhs);
+            return expr::make<Op>(lhs, tape.value(node.rhs));
+        }
+    }
+
+    // Value of a node from the values of its inputs; used when a node is
+    // recorded and again when checkpointing has released it.
+    Tensor Tape::forward(Node const &node)
+    {
+        switch (node.op)
+        {
+            case Op::Add:
+                return elementwise<ops::Add>(*this, node);
+            case Op::Sub:
+                return elementwise<ops::Sub>(*this, node);
+            case Op::Mul:
+                return elementwise<ops::Mul>(*this, node);
+            case Op::Div:
+                return elementwise<ops::Div>(*this, node);
+            case Op::Max:
+                return elementwise<ops::Max>(*this, node);
+            case Op::Min:
+                return elementwise<ops::Min>(*this, node);
+            case Op::Pow:
+                return expr::make<ops::Pow>(value(node.lhs), node.scalar);
+
+            case Op::Matmul:
+                return autodiff::matmul(value(node.lhs), value(node.rhs));
+
+            case Op::Concat:
+            {
+                optional<size_t> axis;
+                if (not node.flatten)
+                    axis = node.axis;
+                return autodiff::concatenate(value(node.lhs), value(node.rhs), axis);
+            }
+
+            case Op::Sum:
+                return Tensor{{1}, value(node.lhs).sum()};
+
+            case Op::Leaf:
+            break;
+        }
+
+        throw logic_error("the value of a leaf cannot be recomputed");
+    }
+}
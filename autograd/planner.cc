@@ -0,0 +1,71 @@
+#include "autograd.ih"
+
+namespace autodiff::autograd
+{
+    namespace
+    {
+        // blocks start on a cache line
+        size_t const align = 64 / sizeof(double);
+
+        struct Placed
+        {
+            size_t offset;
+            size_t size;
+            size_t last;
+        };
+    }
+
+    // Linear scan in step order: blocks whose last step has passed are
+    // released, and each new gradient takes the smallest gap between the
+    // live blocks that fits, or goes on top of them.
+    GradientPlan plan_gradients(vector<Interval> const &intervals)
+    {
+        GradientPlan plan;
+        plan.offsets.assign(intervals.size(), none);
+
+        vector<size_t> order;
+        for (size_t index = 0; index < intervals.size(); ++index)
+            if (intervals[index].size > 0)
+                order.push_back(index);
+
+        stable_sort(order.begin(), order.end(), [&intervals](size_t lhs, size_t rhs) {
+            return intervals[lhs].first < intervals[rhs].first;
+        });
+
+        vector<Placed> live;                    // sorted by offset
+        for (size_t index : order)
+        {
+            Interval const &current = intervals[index];
+            erase_if(live, [&current](Placed const &block) {
+                return block.last < current.first;
+            });
+
+            size_t const size = (current.size + align - 1) / align * align;
+
+            size_t best     = none;
+            size_t best_gap = none;
+            size_t start    = 0;
+            for (Placed const &block : live)
+            {
+                size_t const gap = block.offset - start;
+                if (gap >= size and gap < best_gap)
+                {
+                    best     = start;
+                    best_gap = gap;
+                }
+                start = block.offset + block.size;
+            }
+            if (best == none)
+                best = start;
+
+            auto const pos = upper_bound(live.begin(), live.end(), best,
+                [](size_t offset, Placed const &block) { return offset < block.offset; });
+            live.insert(pos, Placed{best, size, current.last});
+
+            plan.offsets[index] = best;
+            plan.size = max(plan.size, best + size);
+        }
+
+        return plan;
+    }
+}
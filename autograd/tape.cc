@@ -0,0 +1,204 @@
+#include "autograd.ih"
+
+namespace autodiff::autograd
+{
+    Var Tape::variable(Tensor const &value)
+    {
+        return record({.op = Op::Leaf, .requires_grad = true, .value = value});
+    }
+
+    Var Tape::constant(Tensor const &value)
+    {
+        return record({.op = Op::Leaf, .value = value});
+    }
+
+    Var Tape::record(Node node)
+    {
+        if (not node.value)
+            node.value = forward(node);
+        node.shape = node.value->shape();
+
+        bool const leaf = node.op == Op::Leaf;
+        d_nodes.push_back(std::move(node));
+        Var var{*this, d_nodes.size() - 1};
+
+        size_t const length = d_nodes.size() - d_segment;
+        if (d_automatic and not leaf and length * length >= d_nodes.size())
+            checkpoint(var);
+
+        return var;
+    }
+
+    void Tape::checkpoint(Var const &boundary)
+    {
+        size_t const index = boundary.index();
+        if (&boundary.tape() != this or index >= d_nodes.size())
+            throw invalid_argument("boundary is not recorded on this tape");
+
+        value(index);
+        d_nodes[index].boundary = true;
+
+        release_recomputed(0);
+        for (size_t node = d_segment; node < index; ++node)
+            release(node);
+        d_segment = max(d_segment, index + 1);
+    }
+
+    void Tape::checkpoint_automatically(bool enable)
+    {
+        d_automatic = enable;
+    }
+
+    Tensor const &Tape::value(size_t index)
+    {
+        Node &node = d_nodes[index];
+        if (not node.value)
+        {
+            node.value = forward(node);
+            d_recomputed.push_back(index);
+        }
+        return *node.value;
+    }
+
+    void Tape::release(size_t index)
+    {
+        Node &node = d_nodes[index];
+        if (node.op != Op::Leaf and not node.boundary)
+            node.value.reset();
+    }
+
+    // releases the recomputed values of nodes first and up
+    void Tape::release_recomputed(size_t first)
+    {
+        erase_if(d_recomputed, [this, first](size_t index) {
+            if (index < first)
+                return false;
+            release(index);
+            return true;
+        });
+    }
+
+    void Tape::backward(Var const &output)
+    {
+        size_t const out = output.index();
+        if (&output.tape() != this or out >= d_nodes.size())
+            throw invalid_argument("output is not recorded on this tape");
+        if (not d_nodes[out].requires_grad)
+            throw invalid_argument("output does not depend on a variable");
+
+        // the last consumer of a node is the first to write its gradient
+        vector<size_t> last_use(out + 1, none);
+        for (size_t index = 0; index <= out; ++index)
+        {
+            Node const &node = d_nodes[index];
+            if (not node.requires_grad)
+                continue;
+            if (node.lhs != none)
+                last_use[node.lhs] = index;
+            if (node.rhs != none)
+                last_use[node.rhs] = index;
+        }
+
+        // backward step s handles node out - s; the gradients of leaves are
+        // results and live outside the slab
+        vector<Interval> intervals(out + 1, Interval{0, 0, 0});
+        for (size_t index = 0; index <= out; ++index)
+        {
+            Node const &node = d_nodes[index];
+            bool const reached = index == out or last_use[index] != none;
+            if (node.requires_grad and reached and node.op != Op::Leaf)
+                intervals[index] = {
+                    out - (index == out ? out : last_use[index]),
+                    out - index,
+                    elements(node.shape),
+                };
+        }
+
+        d_plan = plan_gradients(intervals);
+        if (d_plan.size > 0 and (not d_slab or d_slab->size() < d_plan.size))
+            d_slab = memory::allocate(d_plan.size);
+
+        d_grads.resize(d_nodes.size());
+        d_ready.assign(d_nodes.size(), false);
+        for (size_t index = 0; index <= out; ++index)
+        {
+            Node const &node = d_nodes[index];
+            if (not node.requires_grad)
+                continue;
+
+            if (node.op == Op::Leaf)
+            {
+                if (not d_grads[index])
+                    d_grads[index].emplace(node.shape, uninitialized);
+            }
+            else if (intervals[index].size > 0)
+                d_grads[index].emplace(node.shape, d_slab, d_plan.offsets[index]);
+            else
+                d_grads[index].reset();
+        }
+
+        *d_grads[out] = 1.0;
+        d_ready[out]  = true;
+
+        // recomputed values are dropped again once backward has left the
+        // segments that need them
+        for (size_t index = out + 1; index-- > 0;)
+        {
+            if (d_nodes[index].boundary)
+                release_recomputed(index + 1);
+            if (d_ready[index] and d_nodes[index].op != Op::Leaf)
+                propagate(index);
+        }
+        release_recomputed(0);
+
+        for (size_t index = 0; index <= out; ++index)
+            if (d_nodes[index].op == Op::Leaf and d_nodes[index].requires_grad
+                    and not d_ready[index])
+                *d_grads[index] = 0.0;
+    }
+
+    Tensor const &Tape::grad(Var const &var) const
+    {
+        size_t const index = var.index();
+        if (index >= d_nodes.size() or d_nodes[index].op != Op::Leaf
+                or not d_nodes[index].requires_grad)
+            throw invalid_argument("gradients are kept for variable() leaves only");
+        if (index >= d_grads.size() or not d_grads[index])
+            throw invalid_argument("no gradient, call backward() first");
+
+        return *d_grads[index];
+    }
+
+    void Tape::clear()
+    {
+        d_nodes.clear();
+        d_grads.clear();
+        d_ready.clear();
+        d_recomputed.clear();
+        d_segment = 0;
+    }
+
+    size_t Tape::size() const
+    {
+        return d_nodes.size();
+    }
+
+    size_t Tape::resident() const
+    {
+        size_t elements = 0;
+        for (Node const &node : d_nodes)
+            if (node.value)
+                elements += node.value->size();
+        return elements;
+    }
+
+    Tape::Node const &Tape::node(size_t index) const
+    {
+        return d_nodes[index];
+    }
+
+    GradientPlan const &Tape::plan() const
+    {
+        return d_plan;
+    }
+}
@@ -0,0 +1,191 @@
+#include "autograd.ih"
+
+namespace autodiff::autograd
+{
+    namespace
+    {
+        Tape &same_tape(Var const &lhs, Var const &rhs)
+        {
+            if (&lhs.tape() != &rhs.tape())
+                throw invalid_argument("operands are recorded on different tapes");
+            return lhs.tape();
+        }
+
+        bool requires_grad(Var const &var)
+        {
+            return var.tape().node(var.index()).requires_grad;
+        }
+
+        Var binary(Op op, Var const &lhs, Var const &rhs)
+        {
+            return same_tape(lhs, rhs).record({
+                .op            = op,
+                .lhs           = lhs.index(),
+                .rhs           = rhs.index(),
+                .requires_grad = requires_grad(lhs) or requires_grad(rhs),
+            });
+        }
+
+        Var with_scalar(Op op, Var const &var, double scalar, bool scalar_lhs = false)
+        {
+            return var.tape().record({
+                .op            = op,
+                .lhs           = var.index(),
+                .scalar        = scalar,
+                .scalar_lhs    = scalar_lhs,
+                .requires_grad = requires_grad(var),
+            });
+        }
+    }
+
+    Var::Var(Tape &tape, size_t index)
+    :
+        d_tape(&tape),
+        d_index(index)
+    {}
+
+    Tape &Var::tape() const
+    {
+        return *d_tape;
+    }
+
+    size_t Var::index() const
+    {
+        return d_index;
+    }
+
+    Tensor const &Var::value() const
+    {
+        return d_tape->value(d_index);
+    }
+
+    Tensor const &Var::grad() const
+    {
+        return d_tape->grad(*this);
+    }
+
+    Var operator+(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Add, lhs, rhs);
+    }
+
+    Var operator+(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Add, lhs, rhs);
+    }
+
+    Var operator+(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Add, rhs, lhs, true);
+    }
+
+    Var operator-(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Sub, lhs, rhs);
+    }
+
+    Var operator-(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Sub, lhs, rhs);
+    }
+
+    Var operator-(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Sub, rhs, lhs, true);
+    }
+
+    Var operator*(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Mul, lhs, rhs);
+    }
+
+    Var operator*(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Mul, lhs, rhs);
+    }
+
+    Var operator*(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Mul, rhs, lhs, true);
+    }
+
+    Var operator/(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Div, lhs, rhs);
+    }
+
+    Var operator/(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Div, lhs, rhs);
+    }
+
+    Var operator/(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Div, rhs, lhs, true);
+    }
+
+    Var maximum(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Max, lhs, rhs);
+    }
+
+    Var maximum(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Max, lhs, rhs);
+    }
+
+    Var maximum(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Max, rhs, lhs, true);
+    }
+
+    Var minimum(Var const &lhs, Var const &rhs)
+    {
+        return binary(Op::Min, lhs, rhs);
+    }
+
+    Var minimum(Var const &lhs, double rhs)
+    {
+        return with_scalar(Op::Min, lhs, rhs);
+    }
+
+    Var minimum(double lhs, Var const &rhs)
+    {
+        return with_scalar(Op::Min, rhs, lhs, true);
+    }
+
+    Var power(Var const &base, double exponent)
+    {
+        return with_scalar(Op::Pow, base, exponent);
+    }
+
+    Var matmul(Var const &lhs, Var const &rhs)
+    {
+        // refused here rather than part-way through backward()
+        Tape &tape = same_tape(lhs, rhs);
+        if (tape.node(lhs.index()).shape.size() > 2 or tape.node(rhs.index()).shape.size() > 2)
+            throw invalid_argument("matmul records operands of rank 1 and 2 only");
+        return binary(Op::Matmul, lhs, rhs);
+    }
+
+    Var concatenate(Var const &lhs, Var const &rhs, optional<size_t> axis)
+    {
+        return same_tape(lhs, rhs).record({
+            .op            = Op::Concat,
+            .lhs           = lhs.index(),
+            .rhs           = rhs.index(),
+            .axis          = axis.value_or(0),
+            .flatten       = not axis.has_value(),
+            .requires_grad = requires_grad(lhs) or requires_grad(rhs),
+        });
+    }
+
+    Var sum(Var const &var)
+    {
+        return var.tape().record({
+            .op            = Op::Sum,
+            .lhs           = var.index(),
+            .requires_grad = requires_grad(var),
+        });
+    }
+}
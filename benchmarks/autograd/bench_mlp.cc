@@ -0,0 +1,74 @@
+#include "../bench.h"
+
+namespace
+{
+    using namespace autograd;
+
+    // The training loop of examples/main.cc: a two layer perceptron with a
+    // bias input appended to each layer, trained by SGD one sample at a time.
+    struct Mlp
+    {
+        Tensor w1;
+        Tensor w2;
+
+        Mlp(size_t inputs, size_t hidden, size_t outputs)
+        :
+            w1({hidden, inputs + 1}),
+            w2({outputs, hidden + 1})
+        {
+            // deterministic weights in [0, 1), as the example's
+            for (size_t i = 0; i < w1.size(); ++i)
+                w1.data()[i] = static_cast<double>(i * 7919 % 1000) / 1000.0;
+            for (size_t i = 0; i < w2.size(); ++i)
+                w2.data()[i] = static_cast<double>(i * 6271 % 1000) / 1000.0;
+        }
+
+        // one sample forward and backward, then the SGD update
+        double step(Tensor const &input, Tensor const &target, double lr)
+        {
+            Tape tape;
+            Var v1   = tape.variable(w1);
+            Var v2   = tape.variable(w2);
+            Var bias = tape.constant(Tensor{{1}, 1.0});
+
+            Var in      = concatenate(tape.constant(input), bias);
+            Var hidden  = concatenate(maximum(matmul(v1, in), 0.0), bias);
+            Var outputs = matmul(v2, hidden);
+            Var loss    = sum(power(outputs - tape.constant(target), 2)) * 0.5;
+
+            tape.backward(loss);
+            w1.axpy(-lr, v1.grad());
+            w2.axpy(-lr, v2.grad());
+            return loss.value().data()[0];
+        }
+    };
+
+    // One epoch over range(2) samples: range(0) inputs, range(1) hidden
+    // units and 3 outputs. {2, 8, 5} is the example as written.
+    void BM_MlpEpoch(benchmark::State &state)
+    {
+        size_t const inputs  = state.range(0);
+        size_t const hidden  = state.range(1);
+        size_t const samples = state.range(2);
+
+        Tensor x{{samples, inputs}};
+        Tensor y{{samples, 3}};
+        for (size_t i = 0; i < x.size(); ++i)
+            x.data()[i] = static_cast<double>(i % 17) / 17.0 - 0.5;
+        for (size_t i = 0; i < y.size(); ++i)
+            y.data()[i] = static_cast<double>(i % 5) - 2.0;
+
+        Mlp mlp{inputs, hidden, 3};
+        for (auto _ : state)
+        {
+            double loss = 0;
+            for (size_t sample = 0; sample < samples; ++sample)
+                loss += mlp.step(x[sample], y[sample], 1e-4);
+            benchmark::DoNotOptimize(loss);
+        }
+
+        state.SetItemsProcessed(state.iterations() * samples);
+    }
+}
+
+BENCHMARK(BM_MlpEpoch)->Args({2, 8, 5})->Args({64, 128, 32})->Args({256, 512, 32});
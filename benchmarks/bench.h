@@ -0,0 +1,16 @@
+#include "../tensor/tensor.h"
+#include "../tensor/basic_tensor.h"
+#include "../tensor/reader.h"
+#include "../linalg/linalg.h"
+#include "../simd/simd.h"
+#include "../parallel/parallel.h"
+#include "../memory/memory.h"
+#include "../autograd/autograd.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+using namespace autodiff;
+using namespace std;
@@ -0,0 +1,121 @@
+#include "../bench.h"
+
+namespace
+{
+    void BM_MatmulSquare(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n, n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(lhs, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * n * n * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    void BM_MatmulMatVec(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(lhs, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * n * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    // [m, k] x [k, n] with m, k, n = range(0..2): tall, wide and
+    // inner-product shaped layers
+    void BM_MatmulRectangular(benchmark::State &state)
+    {
+        size_t m = state.range(0);
+        size_t k = state.range(1);
+        size_t n = state.range(2);
+        Tensor lhs{{m, k}, 1.0};
+        Tensor rhs{{k, n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(lhs, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * m * k * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    // range(1) selects the transposed operands: 1 lhs, 2 rhs, 3 both
+    void BM_MatmulTransposed(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n, n}, 2.0};
+        Tensor const a = state.range(1) & 1 ? lhs.transpose() : lhs;
+        Tensor const b = state.range(1) & 2 ? rhs.transpose() : rhs;
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(a, b));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * n * n * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    // W^T x of a backward pass through a linear layer
+    void BM_MatmulTransposedMatVec(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n}, 2.0};
+        Tensor const a = state.range(1) ? lhs.transpose() : lhs;
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(a, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * n * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    // Same square product as BM_MatmulSquare with elements of type T
+    template <typename T>
+    void BM_MatmulDtype(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        BasicTensor<T> lhs{{n, n}, T{1.0f}};
+        BasicTensor<T> rhs{{n, n}, T{2.0f}};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(lhs, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * n * n * n * state.iterations(), benchmark::Counter::kIsRate);
+    }
+
+    // attention-style [B, H, S, S] product, range(1) is the thread count
+    void BM_MatmulBatched(benchmark::State &state)
+    {
+        size_t const previous = parallel::num_threads();
+        parallel::set_num_threads(state.range(1));
+
+        size_t s = state.range(0);
+        Tensor lhs{{4, 8, s, s}, 1.0};
+        Tensor rhs{{4, 8, s, s}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(matmul(lhs, rhs));
+
+        state.counters["flops"] = benchmark::Counter(
+            2.0 * 32 * s * s * s * state.iterations(), benchmark::Counter::kIsRate);
+        parallel::set_num_threads(previous);
+    }
+}
+
+BENCHMARK(BM_MatmulSquare)->RangeMultiplier(2)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MatmulRectangular)->Args({4096, 64, 64})->Args({64, 64, 4096})
+                                ->Args({64, 4096, 64})->Args({32, 784, 128});
+BENCHMARK(BM_MatmulMatVec)->RangeMultiplier(4)->Range(64, 4096);
+BENCHMARK(BM_MatmulTransposed)->ArgsProduct({{256, 1024}, {0, 1, 2, 3}})->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MatmulTransposedMatVec)->ArgsProduct({{1024, 4096}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_MatmulDtype, float)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MatmulDtype, bfloat16)->RangeMultiplier(4)->Range(64, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MatmulBatched)->ArgsProduct({{64, 128}, {1, 2, 4, 8}})->UseRealTime();
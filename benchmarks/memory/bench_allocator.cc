@@ -0,0 +1,82 @@
+#include "../bench.h"
+
+namespace
+{
+    // a small-layer step: every op allocates a result
+    double step(Tensor const &weights, Tensor const &input)
+    {
+        Tensor hidden = maximum(matmul(weights, input), Tensor{{weights.shape()[0]}, 0.0});
+        Tensor scaled = hidden * 0.5 + hidden;
+        return scaled.sum();
+    }
+
+    void run(benchmark::State &state, shared_ptr<memory::Allocator> allocator, bool arena)
+    {
+        memory::Scope outer{allocator};
+
+        Tensor weights{{16, 8}, 0.25};
+        Tensor input{{8}, 1.0};
+
+        for (auto _ : state)
+        {
+            if (arena)
+            {
+                memory::Scope scope{allocator};
+                benchmark::DoNotOptimize(step(weights, input));
+            }
+            else
+                benchmark::DoNotOptimize(step(weights, input));
+        }
+
+        memory::Stats stats = allocator->stats();
+        state.counters["fresh_bytes"]  = static_cast<double>(stats.fresh_bytes);
+        state.counters["reused_bytes"] = static_cast<double>(stats.reused_bytes);
+    }
+
+    void BM_SmallStepHeap(benchmark::State &state)
+    {
+        run(state, make_shared<memory::HeapAllocator>(), false);
+    }
+
+    void BM_SmallStepPool(benchmark::State &state)
+    {
+        run(state, make_shared<memory::PoolAllocator>(), false);
+    }
+
+    void BM_SmallStepArena(benchmark::State &state)
+    {
+        run(state, make_shared<memory::Arena>(), true);
+    }
+
+    // the pool with every buffer's origin recorded (the debug mode)
+    void BM_SmallStepTracked(benchmark::State &state)
+    {
+        memory::track_origins();
+        run(state, make_shared<memory::PoolAllocator>(), false);
+        memory::track_origins(false);
+    }
+
+    // a fresh 8 MiB buffer per iteration, written once by a parallel op:
+    // the cost of placing its pages (arg: memory::Placement)
+    void BM_FreshLargeBuffer(benchmark::State &state)
+    {
+        memory::set_placement(static_cast<memory::Placement>(state.range(0)));
+        memory::Scope scope{make_shared<memory::HeapAllocator>()};
+
+        Tensor const input{{size_t{1} << 20}, 1.0};
+        for (auto _ : state)
+        {
+            Tensor result = input * 2.0;
+            benchmark::DoNotOptimize(result.data());
+        }
+
+        memory::set_placement(memory::Placement::any);
+        state.SetBytesProcessed(state.iterations() * input.size() * sizeof(double));
+    }
+}
+
+BENCHMARK(BM_SmallStepHeap);
+BENCHMARK(BM_SmallStepPool);
+BENCHMARK(BM_SmallStepArena);
+BENCHMARK(BM_SmallStepTracked);
+BENCHMARK(BM_FreshLargeBuffer)->DenseRange(0, 2);
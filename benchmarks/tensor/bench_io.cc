@@ -0,0 +1,134 @@
+#include "../bench.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    // rows x columns weights written to a temporary file once per benchmark
+    struct Weights
+    {
+        string path;
+
+        Weights(size_t rows, size_t columns, string const &name)
+        :
+            path("/tmp/autodiff_bench_" + name)
+        {
+            Tensor t{{rows, columns}};
+            for (size_t i = 0; i < t.size(); ++i)
+                t.data()[i] = 1.0 / static_cast<double>(i + 1);
+            save(t, path);
+        }
+
+        ~Weights()
+        {
+            remove(path.c_str());
+        }
+    };
+
+    // the weights parsed from decimal text, as before the binary format
+    void BM_LoadText(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        string const path = "/tmp/autodiff_bench_text";
+        {
+            ofstream out{path};
+            out.precision(17);
+            for (size_t i = 0; i < n * n; ++i)
+                out << 1.0 / static_cast<double>(i + 1) << '\n';
+        }
+
+        for (auto _ : state)
+        {
+            ifstream in{path};
+            vector<double> values;
+            values.reserve(n * n);
+            for (double value; in >> value;)
+                values.push_back(value);
+            benchmark::DoNotOptimize(Tensor{{n, n}, std::move(values)});
+        }
+
+        remove(path.c_str());
+        state.SetBytesProcessed(state.iterations() * n * n * sizeof(double));
+    }
+
+    // the binary file read into freshly allocated memory
+    void BM_LoadRead(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Weights const weights{n, n, "read"};
+
+        for (auto _ : state)
+        {
+            streamsize const bytes = n * n * sizeof(double);
+            ifstream in{weights.path, ios::binary};
+            in.seekg(-bytes, ios::end);         // the payload ends the file
+            Tensor t{{n, n}, uninitialized};
+            in.read(reinterpret_cast<char *>(t.data()), bytes);
+            benchmark::DoNotOptimize(t);
+        }
+
+        state.SetBytesProcessed(state.iterations() * n * n * sizeof(double));
+    }
+
+    // load(): map the file and touch nothing but the header
+    void BM_LoadMapped(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Weights const weights{n, n, "mapped"};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(load(weights.path));
+
+        state.SetBytesProcessed(state.iterations() * n * n * sizeof(double));
+    }
+
+    size_t const stream_rows  = 16384;
+    size_t const stream_width = 256;
+    size_t const stream_batch = 512;
+
+    // one epoch of batches through a layer, reading each batch in between
+    void BM_StreamInline(benchmark::State &state)
+    {
+        Weights const data{stream_rows, stream_width, "inline"};
+        Tensor const layer{{stream_width, stream_width}, 0.01};
+
+        for (auto _ : state)
+        {
+            ifstream in{data.path, ios::binary};
+            in.seekg(-static_cast<streamsize>(stream_rows * stream_width * sizeof(double)), ios::end);
+            for (size_t first = 0; first < stream_rows; first += stream_batch)
+            {
+                Tensor batch{{stream_batch, stream_width}, uninitialized};
+                in.read(reinterpret_cast<char *>(batch.data()),
+                        stream_batch * stream_width * sizeof(double));
+                benchmark::DoNotOptimize(matmul(batch, layer));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * stream_rows);
+    }
+
+    // the same epoch from a BatchReader, which reads ahead on its thread
+    void BM_StreamPrefetch(benchmark::State &state)
+    {
+        Weights const data{stream_rows, stream_width, "prefetch"};
+        Tensor const layer{{stream_width, stream_width}, 0.01};
+
+        for (auto _ : state)
+        {
+            BatchReader reader{data.path, stream_batch};
+            while (optional<Tensor> batch = reader.next())
+                benchmark::DoNotOptimize(matmul(*batch, layer));
+        }
+
+        state.SetItemsProcessed(state.iterations() * stream_rows);
+    }
+}
+
+BENCHMARK(BM_LoadText)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadRead)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadMapped)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_StreamInline)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StreamPrefetch)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,390 @@
+#include "../bench.h"
+
+namespace
+{
+    // The previous implementation of operation(): every output offset is
+    // decomposed into coordinates with one div/mod per axis. Kept here as the
+    // baseline the broadcast iterator is measured against.
+    Tensor operation_divmod(Tensor const &lhs, Tensor const &rhs,
+                            function<double(double, double)> operator_)
+    {
+        BroadcastPlan plan = prepare_broadcast(lhs, rhs);
+
+        auto const &res_shape = plan.res_shape;
+        size_t rank     = res_shape.size();
+        size_t res_size = accumulate(res_shape.begin(), res_shape.end(), size_t{1},
+                                     multiplies<size_t>());
+
+        auto lhs_data = lhs.cbegin();
+        auto rhs_data = rhs.cbegin();
+
+        vector<double> res(res_size);
+        for (size_t i = 0; i < res_size; ++i)
+        {
+            size_t i_lhs = 0;
+            size_t i_rhs = 0;
+
+            size_t j = i;
+            for (size_t axis = 0; axis < rank; ++axis)
+            {
+                size_t coord = j / plan.res_strides[axis];
+                j = j % plan.res_strides[axis];
+
+                i_lhs += coord * plan.lhs_strides[axis];
+                i_rhs += coord * plan.rhs_strides[axis];
+            }
+
+            res[i] = operator_(lhs_data[i_lhs], rhs_data[i_rhs]);
+        }
+
+        return Tensor{res_shape, std::move(res)};
+    }
+
+    function<double(double, double)> const add = ops::Add{};
+
+    void BM_OperationDivmodSameShape(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n, n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation_divmod(lhs, rhs, add));
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    void BM_OperationSameShape(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n, n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, add));
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    void BM_OperationDivmodBroadcast(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{4, n, n}, 1.0};
+        Tensor rhs{{1, n, 1}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation_divmod(lhs, rhs, add));
+
+        state.SetItemsProcessed(state.iterations() * 4 * n * n);
+    }
+
+    void BM_OperationBroadcast(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{4, n, n}, 1.0};
+        Tensor rhs{{1, n, 1}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, add));
+
+        state.SetItemsProcessed(state.iterations() * 4 * n * n);
+    }
+
+    void BM_OperationFunction(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n}, 1.0};
+        Tensor rhs{{n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, add));
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    void BM_OperationTemplate(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n}, 1.0};
+        Tensor rhs{{n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, ops::Add{}));
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    // BM_OperationTemplate with elements of type T
+    template <typename T>
+    void BM_OperationDtype(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        BasicTensor<T> lhs{{n}, T{1.0f}};
+        BasicTensor<T> rhs{{n}, T{2.0f}};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(lhs + rhs);
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    // ((out - target) ^ 2).sum() through one operation() per step
+    void BM_ChainEager(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor out{{n}, 1.5};
+        Tensor target{{n}, 0.5};
+
+        for (auto _ : state)
+        {
+            Tensor diff = operation(out, target, ops::Sub{});
+            benchmark::DoNotOptimize(operation(diff, diff, ops::Mul{}).sum());
+        }
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    void BM_ChainLazy(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor out{{n}, 1.5};
+        Tensor target{{n}, 0.5};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize((out - target).power(2).sum());
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    // weights -= grad * lr, the update step of the training loop
+    void BM_OperationCompound(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor weights{{n, n}, 1.0};
+        Tensor grad{{n, n}, 2.0};
+
+        for (auto _ : state)
+        {
+            weights -= grad;
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    // a transposed operand: the inner run of the result is strided
+    void BM_OperationStrided(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor lhs{{n, n}, 1.0};
+        Tensor rhs{{n, n}, 2.0};
+        Tensor const transposed = rhs.transpose();
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, transposed, ops::Add{}));
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    // compound assignment of a scalar, in place
+    void BM_OperationScalar(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor weights{{n, n}, 1.0};
+
+        for (auto _ : state)
+        {
+            weights *= 0.5;
+            weights += 0.5;
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    // ReLU of n x n against a scalar zero (range(1) = 0), a column of zeros
+    // broadcast along the rows (1) and a materialised tensor of zeros (2)
+    void BM_Relu(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor values{{n, n}, -0.5};
+        Tensor column{{n, 1}, 0.0};
+
+        for (auto _ : state)
+        {
+            switch (state.range(1))
+            {
+                case 0:
+                    benchmark::DoNotOptimize(Tensor{maximum(values, 0.0)});
+                break;
+                case 1:
+                    benchmark::DoNotOptimize(Tensor{maximum(values, column)});
+                break;
+                default:
+                    benchmark::DoNotOptimize(Tensor{maximum(values, Tensor{values.shape(), 0.0})});
+                break;
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    // a small op with the profiler off (range(0) = 0) and recording
+    void BM_OperationProfiled(benchmark::State &state)
+    {
+        Tensor lhs{{16, 16}, 1.0};
+        Tensor rhs{{16, 16}, 2.0};
+
+        if (state.range(0))
+            profile::enable();
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, ops::Add{}));
+        profile::disable();
+
+        state.SetItemsProcessed(state.iterations() * lhs.size());
+    }
+
+    // Row views share the buffer, so indexing only builds shape and strides
+    void BM_TensorIndex(benchmark::State &state)
+    {
+        Tensor t{{64, 64, 4}, 1.0};
+
+        for (auto _ : state)
+            for (size_t row = 0; row < 64; ++row)
+                benchmark::DoNotOptimize(t(row, 3));
+
+        state.SetItemsProcessed(state.iterations() * 64);
+    }
+
+    // range(1) selects the simd::Isa, unsupported ones are skipped
+    void BM_OperationIsa(benchmark::State &state)
+    {
+        auto isa = static_cast<simd::Isa>(state.range(1));
+        if (isa > simd::detected_isa())
+        {
+            state.SkipWithError("instruction set not supported");
+            return;
+        }
+
+        simd::Isa const previous = simd::isa();
+        simd::use_isa(isa);
+
+        size_t n = state.range(0);
+        Tensor lhs{{n}, 1.0};
+        Tensor rhs{{n}, 2.0};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(operation(lhs, rhs, ops::Mul{}));
+
+        state.SetItemsProcessed(state.iterations() * n);
+        simd::use_isa(previous);
+    }
+
+    // a batch of range(0) samples of 256 values, stacked at once
+    void BM_Stack(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        vector<Tensor> samples(n, Tensor{{256}, 1.0});
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(stack(samples));
+
+        state.SetItemsProcessed(state.iterations() * n * 256);
+    }
+
+    // the same batch grown by chained pairwise concatenation
+    void BM_StackChained(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        vector<Tensor> samples(n, Tensor{{1, 256}, 1.0});
+
+        for (auto _ : state)
+        {
+            Tensor batch = samples[0];
+            for (size_t index = 1; index < n; ++index)
+                batch = concatenate(batch, samples[index]);
+            benchmark::DoNotOptimize(batch);
+        }
+
+        state.SetItemsProcessed(state.iterations() * n * 256);
+    }
+
+    // eight n x n tensors joined along axis range(1)
+    void BM_Concatenate(benchmark::State &state)
+    {
+        size_t n    = state.range(0);
+        size_t axis = state.range(1);
+        vector<Tensor> parts(8, Tensor{{n, n}, 1.0});
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(concatenate(parts, axis));
+
+        state.SetItemsProcessed(state.iterations() * 8 * n * n);
+    }
+
+    // the whole tensor summed, pairwise
+    void BM_Sum(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor t{{n}, 0.5};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(t.sum());
+
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    // n x n sum over range(1): 1 reduces contiguous rows, 0 columns
+    void BM_SumAxis(benchmark::State &state)
+    {
+        size_t n    = state.range(0);
+        size_t axis = state.range(1);
+        Tensor t{{n, n}, 0.5};
+
+        for (auto _ : state)
+            benchmark::DoNotOptimize(t.sum({axis}));
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+
+    // the same row sums as a scalar loop per row
+    void BM_SumAxisNaive(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor t{{n, n}, 0.5};
+
+        for (auto _ : state)
+        {
+            Tensor res{{n}, uninitialized};
+            for (size_t row = 0; row < n; ++row)
+                res.data()[row] = accumulate(t.data() + row * n, t.data() + (row + 1) * n, 0.0);
+            benchmark::DoNotOptimize(res);
+        }
+
+        state.SetItemsProcessed(state.iterations() * n * n);
+    }
+}
+
+BENCHMARK(BM_OperationDivmodSameShape)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationSameShape)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationDivmodBroadcast)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationBroadcast)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationFunction)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK(BM_OperationTemplate)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK_TEMPLATE(BM_OperationDtype, float)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK_TEMPLATE(BM_OperationDtype, bfloat16)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK(BM_ChainEager)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK(BM_ChainLazy)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK(BM_OperationCompound)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationStrided)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_OperationScalar)->RangeMultiplier(4)->Range(16, 1024);
+BENCHMARK(BM_Relu)->ArgsProduct({{64, 1024}, {0, 1, 2}});
+BENCHMARK(BM_OperationProfiled)->Arg(0)->Arg(1);
+BENCHMARK(BM_TensorIndex);
+BENCHMARK(BM_OperationIsa)->ArgsProduct({{1'000, 100'000, 10'000'000}, {0, 1, 2}});
+BENCHMARK(BM_SumAxis)->ArgsProduct({{64, 1024, 4096}, {0, 1}});
+BENCHMARK(BM_SumAxisNaive)->Arg(64)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_Sum)->RangeMultiplier(10)->Range(1'000, 10'000'000);
+BENCHMARK(BM_Concatenate)->ArgsProduct({{64, 1024}, {0, 1}});
+BENCHMARK(BM_Stack)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK(BM_StackChained)->RangeMultiplier(8)->Range(8, 512);
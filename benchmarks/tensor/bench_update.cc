@@ -0,0 +1,57 @@
+#include "../bench.h"
+
+namespace
+{
+    // weights -= grad * lr with the product materialized, as before
+    // expressions were lazy: a temporary, then a second pass
+    void BM_UpdateUnfused(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor weights{{n}, 1.0};
+        Tensor grad{{n}, 1e-9};
+
+        for (auto _ : state)
+        {
+            weights -= Tensor{grad * 0.1};
+            benchmark::ClobberMemory();
+        }
+
+        state.SetBytesProcessed(state.iterations() * n * 3 * sizeof(double));
+    }
+
+    void BM_UpdateAxpy(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor weights{{n}, 1.0};
+        Tensor grad{{n}, 1e-9};
+
+        for (auto _ : state)
+        {
+            weights.axpy(-0.1, grad);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetBytesProcessed(state.iterations() * n * 3 * sizeof(double));
+    }
+
+    void BM_UpdateAdam(benchmark::State &state)
+    {
+        size_t n = state.range(0);
+        Tensor weights{{n}, 1.0};
+        Tensor grad{{n}, 1e-9};
+        Tensor m{{n}}, v{{n}};
+
+        size_t step = 0;
+        for (auto _ : state)
+        {
+            adam_step(weights, grad, m, v, ++step);
+            benchmark::ClobberMemory();
+        }
+
+        state.SetBytesProcessed(state.iterations() * n * 7 * sizeof(double));
+    }
+}
+
+BENCHMARK(BM_UpdateUnfused)->RangeMultiplier(10)->Range(10'000, 10'000'000);
+BENCHMARK(BM_UpdateAxpy)->RangeMultiplier(10)->Range(10'000, 10'000'000);
+BENCHMARK(BM_UpdateAdam)->RangeMultiplier(10)->Range(10'000, 10'000'000);
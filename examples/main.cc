@@ -1,5 +1,6 @@
 #include "../tensor/tensor.h"
 #include "../linalg/linalg.h"
+#include "../autograd/autograd.h"
 #include <iostream>
 #include <vector>
 #include <random>
@@ -20,57 +21,24 @@ std::vector<double> generate_random_vector(size_t size, double min_val, double m
     return random_doubles;
 }
 
-Tensor ReLU(Tensor const &values)
-{
-    return maximum(values, Tensor{values.shape(), 0});
-}
-
-double ReLU_deriv(double val)
-{
-    return val <= 0 ? 0 : 1;
-}
-
+// one sample through a two layer perceptron with a bias input appended to
+// each layer; returns the outputs and the gradients of half the squared error
 vector<Tensor> epoch(Tensor &W_1, Tensor &W_2, Tensor const &inputs, Tensor const &targets)
 {
-    Tensor in = concatenate(inputs, Tensor{{1}, 1});
-
-    Tensor a = matmul(W_1, in);
-    Tensor z = ReLU(a);
-
-
-    z = concatenate(z, Tensor{{1}, 1});
-    a = concatenate(a, Tensor{{1}, 1});
-
-    Tensor outputs = matmul(W_2, z);
-
-    Tensor err_out = outputs - targets;
-    Tensor err_hid = Tensor{z.shape(), 0};
-
-    for (size_t j = 0; j < a.shape()[0]; ++j)
-    {
-        double err = 0;
-        for (size_t k = 0; k < outputs.shape()[0]; ++k)
-            err += err_out[k].scalar() * W_2(k, j).scalar();
-
-        err_hid[j] = err * ReLU_deriv(a[j].scalar());
-    }
-
-    //cout << err_hid;
-
-
-    Tensor grad_1 = Tensor{W_1.shape(), 0};
-    for (size_t j = 0; j < a.shape()[0] - 1; ++j)
-        grad_1[j] = in * err_hid[j];
+    using namespace autograd;
 
-    // cout << grad_1;
+    Tape tape;
+    Var w_1  = tape.variable(W_1);
+    Var w_2  = tape.variable(W_2);
+    Var bias = tape.constant(Tensor{{1}, 1});
 
-    Tensor grad_out = Tensor{W_2.shape(), 0};
-    for (size_t k = 0; k < outputs.shape()[0]; ++k)
-        grad_out[k] = z * err_out[k];
+    Var in      = concatenate(tape.constant(inputs), bias);
+    Var hidden  = concatenate(maximum(matmul(w_1, in), 0.0), bias);
+    Var outputs = matmul(w_2, hidden);
 
-    // cout << grad_out;
+    tape.backward(sum(power(outputs - tape.constant(targets), 2)) * 0.5);
 
-    return {outputs, grad_1, grad_out};
+    return {outputs.value(), w_1.grad(), w_2.grad()};
 }
 
 int main()
@@ -132,8 +100,8 @@ int main()
 
             loss += diff.sum();
 
-            weights_1 -= grad_1 * lr;
-            weights_2 -= grad_2 * lr;
+            weights_1.axpy(-lr, grad_1);
+            weights_2.axpy(-lr, grad_2);
         }
 
         result += "loss epoch " + to_string(i) + ": " + to_string(loss) + "\n";
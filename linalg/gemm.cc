@@ -0,0 +1,309 @@
+#include "linalg.ih"
+
+namespace autodiff
+{
+    namespace
+    {
+        // Block sizes in elements. A kc x nr sliver of packed b stays in L1
+        // while the micro-kernel streams it, the mc x kc packed block of a
+        // stays in L2 and the kc x nc packed panel of b in L3.
+        size_t const block_kc = 256;
+        size_t const block_mc = 96;
+        size_t const block_nc = 2048;
+
+        // largest mr x nr register tile of any micro-kernel
+        size_t const max_tile = 256;
+
+        // products of at least this many multiply-adds are split over threads
+        size_t const parallel_flops = size_t{1} << 18;
+        size_t const gemv_rows      = 64;
+        size_t const gemv_column_rows = 512;        // one page of each column
+
+        // Each packing routine walks the operand along its smaller stride,
+        // so row-major, column-major (transposed) and sliced operands are
+        // all read in storage order rather than across rows or pages.
+
+        // packs rows [0, m) x cols [0, k) of a into micro-panels of mr rows,
+        // each stored column by column, zero padding the last panel
+        template <typename T, typename Acc>
+        void pack_a(size_t m, size_t k, T const *a, size_t a_rs, size_t a_cs,
+                    size_t mr, Acc *packed)
+        {
+            if (a_rs < a_cs)                        // down the columns of the block
+            {
+                for (size_t p = 0; p < k; ++p)
+                {
+                    T const *col = a + p * a_cs;
+                    Acc *panel   = packed + p * mr;
+                    for (size_t row = 0; row < m; row += mr, panel += mr * k)
+                    {
+                        size_t const rows = min(mr, m - row);
+                        size_t i = 0;
+                        if (a_rs == 1)
+                            for (; i < rows; ++i)
+                                panel[i] = static_cast<Acc>(col[row + i]);
+                        else
+                            for (; i < rows; ++i)
+                                panel[i] = static_cast<Acc>(col[(row + i) * a_rs]);
+                        for (; i < mr; ++i)
+                            panel[i] = 0;
+                    }
+                }
+                return;
+            }
+
+            for (size_t row = 0; row < m; row += mr)
+            {
+                size_t const rows = min(mr, m - row);
+                for (size_t p = 0; p < k; ++p)
+                {
+                    T const *col = a + row * a_rs + p * a_cs;
+                    size_t i = 0;
+                    for (; i < rows; ++i)
+                        packed[i] = static_cast<Acc>(col[i * a_rs]);
+                    for (; i < mr; ++i)
+                        packed[i] = 0;
+                    packed += mr;
+                }
+            }
+        }
+
+        // packs rows [0, k) x cols [0, n) of b into micro-panels of nr
+        // columns, each stored row by row, zero padding the last panel
+        template <typename T, typename Acc>
+        void pack_b(size_t k, size_t n, T const *b, size_t b_rs, size_t b_cs,
+                    size_t nr, Acc *packed)
+        {
+            if (b_rs < b_cs)                        // down each column of the panel
+            {
+                for (size_t col = 0; col < n; col += nr, packed += nr * k)
+                {
+                    size_t const cols = min(nr, n - col);
+                    size_t j = 0;
+                    for (; j < cols; ++j)
+                    {
+                        T const *column = b + (col + j) * b_cs;
+                        if (b_rs == 1)
+                            for (size_t p = 0; p < k; ++p)
+                                packed[p * nr + j] = static_cast<Acc>(column[p]);
+                        else
+                            for (size_t p = 0; p < k; ++p)
+                                packed[p * nr + j] = static_cast<Acc>(column[p * b_rs]);
+                    }
+                    for (; j < nr; ++j)
+                        for (size_t p = 0; p < k; ++p)
+                            packed[p * nr + j] = 0;
+                }
+                return;
+            }
+
+            for (size_t col = 0; col < n; col += nr)
+            {
+                size_t const cols = min(nr, n - col);
+                for (size_t p = 0; p < k; ++p)
+                {
+                    T const *row = b + p * b_rs + col * b_cs;
+                    size_t j = 0;
+                    if (b_cs == 1)
+                        for (; j < cols; ++j)
+                            packed[j] = static_cast<Acc>(row[j]);
+                    else
+                        for (; j < cols; ++j)
+                            packed[j] = static_cast<Acc>(row[j * b_cs]);
+                    for (; j < nr; ++j)
+                        packed[j] = 0;
+                    packed += nr;
+                }
+            }
+        }
+
+        // c[mcur x ncur] += packed a block * packed b panel, tile by tile
+        template <typename Acc>
+        void macro_kernel(simd::BasicGemmKernel<Acc> const &kernel,
+                          size_t mcur, size_t ncur, size_t kcur,
+                          Acc const *packed_a, Acc const *packed_b, Acc *c, size_t c_rs)
+        {
+            size_t const mr = kernel.mr;
+            size_t const nr = kernel.nr;
+
+            // edge tiles are computed into a scratch tile and copied out
+            Acc tile[max_tile];
+
+            for (size_t jr = 0; jr < ncur; jr += nr)
+            {
+                size_t const cols = min(nr, ncur - jr);
+                Acc const *b_panel = packed_b + jr * kcur;
+
+                for (size_t ir = 0; ir < mcur; ir += mr)
+                {
+                    size_t const rows = min(mr, mcur - ir);
+                    Acc const *a_panel = packed_a + ir * kcur;
+                    Acc *c_tile = c + ir * c_rs + jr;
+
+                    if (rows == mr and cols == nr)
+                    {
+                        kernel.run(kcur, a_panel, b_panel, c_tile, c_rs);
+                        continue;
+                    }
+
+                    fill(tile, tile + mr * nr, Acc{});
+                    kernel.run(kcur, a_panel, b_panel, tile, nr);
+                    for (size_t i = 0; i < rows; ++i)
+                        for (size_t j = 0; j < cols; ++j)
+                            c_tile[i * c_rs + j] += tile[i * nr + j];
+                }
+            }
+        }
+
+        // c (m x 1) = a (m x k) * b (k x 1) for column-major a: the columns
+        // of a are scaled and summed, reading a in storage order
+        template <typename T, typename Acc>
+        void gemv_columns(size_t m, size_t k, T const *a, size_t a_cs,
+                          T const *b, size_t b_rs, Acc *c, size_t c_rs)
+        {
+            if constexpr (is_same_v<T, Acc>)
+                if (c_rs == 1)
+                {
+                    fill(c, c + m, Acc{});
+                    for (size_t p = 0; p < k; ++p)
+                        simd::axpby(b[p * b_rs], a + p * a_cs, Acc{1}, c, m);
+                    return;
+                }
+
+            for (size_t i = 0; i < m; ++i)
+                c[i * c_rs] = 0;
+            for (size_t p = 0; p < k; ++p)
+            {
+                Acc const value = static_cast<Acc>(b[p * b_rs]);
+                T const *col    = a + p * a_cs;
+                for (size_t i = 0; i < m; ++i)
+                    c[i * c_rs] += value * static_cast<Acc>(col[i]);
+            }
+        }
+
+        // c (m x 1) = a (m x k) * b (k x 1)
+        template <typename T, typename Acc>
+        void gemv(size_t m, size_t k, T const *a, size_t a_rs, size_t a_cs,
+                  T const *b, size_t b_rs, Acc *c, size_t c_rs)
+        {
+            for (size_t i = 0; i < m; ++i)
+            {
+                T const *row = a + i * a_rs;
+                Acc sum = 0;
+                if (a_cs == 1 and b_rs == 1)
+                {
+                    // independent partial sums break the add dependency chain
+                    Acc partial[8] = {};
+                    size_t p = 0;
+                    for (; p + 8 <= k; p += 8)
+                        for (size_t lane = 0; lane < 8; ++lane)
+                            partial[lane] += static_cast<Acc>(row[p + lane])
+                                           * static_cast<Acc>(b[p + lane]);
+                    for (; p < k; ++p)
+                        sum += static_cast<Acc>(row[p]) * static_cast<Acc>(b[p]);
+                    for (Acc value : partial)
+                        sum += value;
+                }
+                else
+                    for (size_t p = 0; p < k; ++p)
+                        sum += static_cast<Acc>(row[p * a_cs]) * static_cast<Acc>(b[p * b_rs]);
+                c[i * c_rs] = sum;
+            }
+        }
+
+        template <typename Acc>
+        simd::BasicGemmKernel<Acc> micro_kernel()
+        {
+            if constexpr (is_same_v<Acc, float>)
+                return simd::gemm_kernel_f32();
+            else
+                return simd::gemm_kernel();
+        }
+    }
+
+    template <typename T>
+    void gemm(size_t m, size_t n, size_t k,
+              T const *a, size_t a_rs, size_t a_cs,
+              T const *b, size_t b_rs, size_t b_cs,
+              accumulate_t<T> *c, size_t c_rs, size_t c_cs)
+    {
+        using Acc = accumulate_t<T>;
+
+        bool const parallel = m * n * k >= parallel_flops;
+
+        if (n == 1)
+        {
+            // column-major a is walked a page of rows per column at a time
+            bool const columns = a_rs == 1 and a_cs > 1;
+            size_t const grain = not parallel ? m : columns ? gemv_column_rows : gemv_rows;
+            return parallel::parallel_for(0, m, grain, [&](size_t first, size_t last) {
+                if (columns)
+                    gemv_columns(last - first, k, a + first, a_cs, b, b_rs, c + first * c_rs, c_rs);
+                else
+                    gemv(last - first, k, a + first * a_rs, a_rs, a_cs, b, b_rs, c + first * c_rs, c_rs);
+            });
+        }
+        if (m == 1)                                 // c^T = b^T a^T
+            return gemm(n, 1, k, b, b_cs, b_rs, a, a_cs, a_rs, c, c_cs, c_rs);
+
+        assert(c_cs == 1 and "gemm writes row-major output");
+
+        simd::BasicGemmKernel<Acc> const kernel = micro_kernel<Acc>();
+        assert(kernel.mr * kernel.nr <= max_tile);
+
+        size_t const mc = block_mc / kernel.mr * kernel.mr;
+        size_t const nc = block_nc / kernel.nr * kernel.nr;
+
+        // The packed b panel is shared read-only by the threads working on
+        // a and belongs to this call: a thread waiting in the parallel_for
+        // below may run another gemm (a batch of matmul) in the meantime,
+        // which must not repack it. Packed a is only used between two
+        // waits, so it can stay per thread.
+        size_t const panel_cols = min(nc, (n + kernel.nr - 1) / kernel.nr * kernel.nr);
+        auto const panel = make_unique_for_overwrite<Acc[]>(min(block_kc, k) * panel_cols);
+        Acc *packed_b = panel.get();
+
+        for (size_t i = 0; i < m; ++i)
+            fill(c + i * c_rs, c + i * c_rs + n, Acc{});
+
+        size_t const blocks = (m + mc - 1) / mc;
+
+        for (size_t jc = 0; jc < n; jc += nc)
+        {
+            size_t const ncur = min(nc, n - jc);
+
+            for (size_t pc = 0; pc < k; pc += block_kc)
+            {
+                size_t const kcur = min(block_kc, k - pc);
+                pack_b(kcur, ncur, b + pc * b_rs + jc * b_cs, b_rs, b_cs, kernel.nr, packed_b);
+
+                // every mc block of rows is computed the same way on any
+                // thread, so the result does not depend on the split
+                parallel::parallel_for(0, blocks, parallel ? 1 : blocks,
+                    [&](size_t first, size_t last) {
+                        thread_local vector<Acc> packed_a;
+                        packed_a.resize(mc * block_kc);
+
+                        for (size_t block = first; block < last; ++block)
+                        {
+                            size_t const ic   = block * mc;
+                            size_t const mcur = min(mc, m - ic);
+                            pack_a(mcur, kcur, a + ic * a_rs + pc * a_cs, a_rs, a_cs, kernel.mr,
+                                   packed_a.data());
+                            macro_kernel(kernel, mcur, ncur, kcur, packed_a.data(),
+                                         packed_b, c + ic * c_rs + jc, c_rs);
+                        }
+                    });
+            }
+        }
+    }
+
+    template void gemm(size_t, size_t, size_t, double const *, size_t, size_t,
+                       double const *, size_t, size_t, double *, size_t, size_t);
+    template void gemm(size_t, size_t, size_t, float const *, size_t, size_t,
+                       float const *, size_t, size_t, float *, size_t, size_t);
+    template void gemm(size_t, size_t, size_t, bfloat16 const *, size_t, size_t,
+                       bfloat16 const *, size_t, size_t, float *, size_t, size_t);
+    template void gemm(size_t, size_t, size_t, float16 const *, size_t, size_t,
+                       float16 const *, size_t, size_t, float *, size_t, size_t);
+}
@@ -2,22 +2,33 @@
 
 namespace autodiff
 {
-    MatmulBroadcastPlan prepare_matmul_broadcast(Tensor const &lhs, Tensor const &rhs)
+    namespace
     {
-        auto const &lhs_shape   = lhs.shape();
-        auto const &lhs_strides = lhs.strides();
-        auto const &rhs_shape   = rhs.shape();
-        auto const &rhs_strides = rhs.strides();
+        // multiply-adds per chunk of batches handed to one thread
+        size_t const batch_parallel_flops = size_t{1} << 18;
+
+        // strides of a contiguous tensor of shape, as BasicTensors are
+        Dims row_major(Dims const &shape)
+        {
+            Dims strides(shape.size(), 1);
+            for (size_t axis = shape.size(); axis-- > 1;)
+                strides[axis - 1] = strides[axis] * shape[axis];
+            return strides;
+        }
+    }
 
-        size_t const rhs_rank = rhs.rank();
-        size_t const lhs_rank = lhs.rank();
+    MatmulBroadcastPlan prepare_matmul_broadcast(Dims const &lhs_shape, Dims const &lhs_strides,
+                                                 Dims const &rhs_shape, Dims const &rhs_strides)
+    {
+        size_t const rhs_rank = rhs_shape.size();
+        size_t const lhs_rank = lhs_shape.size();
 
         size_t const max_rank = max(lhs_rank, rhs_rank);
         size_t const res_rank = lhs_rank == 1 or rhs_rank == 1
             ? max_rank - 1
             : max_rank;
 
-        vector<size_t> b_lhs_strides(max_rank, 1), b_rhs_strides(max_rank, 1),
+        Dims b_lhs_strides(max_rank, 1), b_rhs_strides(max_rank, 1),
                        result_shape(res_rank), b_res_strides(max_rank, 1);
 
         size_t stride_acc, rows, cols, batch_size;
@@ -29,7 +40,9 @@ namespace autodiff
                 throw runtime_error("Incompatible shapes");
 
             b_lhs_strides[max_rank - 2] = 0;
+            b_lhs_strides[max_rank - 1] = lhs_strides[0];
             b_rhs_strides[max_rank - 2] = rhs_strides[rhs_rank - 2];
+            b_rhs_strides[max_rank - 1] = rhs_strides[rhs_rank - 1];
             b_res_strides[max_rank - 2] = 0;
 
             result_shape[res_rank - 1] = stride_acc = rhs_shape[rhs_rank - 1];
@@ -43,6 +56,8 @@ namespace autodiff
                 throw runtime_error("Incompatible shapes");
 
             b_lhs_strides[max_rank - 2] = lhs_strides[lhs_rank - 2];
+            b_lhs_strides[max_rank - 1] = lhs_strides[lhs_rank - 1];
+            b_rhs_strides[max_rank - 2] = rhs_strides[0];
             b_rhs_strides[max_rank - 1] = 0;
             b_res_strides[max_rank - 1] = 0;
 
@@ -57,7 +72,9 @@ namespace autodiff
                 throw runtime_error("Incompatible shapes");
 
             b_lhs_strides[max_rank - 2] = lhs_strides[lhs_rank - 2];
+            b_lhs_strides[max_rank - 1] = lhs_strides[lhs_rank - 1];
             b_rhs_strides[max_rank - 2] = rhs_strides[rhs_rank - 2];
+            b_rhs_strides[max_rank - 1] = rhs_strides[rhs_rank - 1];
             b_res_strides[max_rank - 2] = rhs_shape[rhs_rank - 1];
 
             result_shape[res_rank - 2] = lhs_shape[lhs_rank - 2];
@@ -109,68 +126,165 @@ namespace autodiff
         return out;
     }
 
+    MatmulBroadcastPlan prepare_matmul_broadcast(Tensor const &lhs, Tensor const &rhs)
+    {
+        return prepare_matmul_broadcast(lhs.shape(), lhs.strides(), rhs.shape(), rhs.strides());
+    }
+
     Tensor matmul(Tensor const &lhs, Tensor const &rhs)
     {
-        MatmulBroadcastPlan plan = prepare_matmul_broadcast(lhs, rhs);
+        profile::Record record{"matmul"};
 
-        auto const &lhs_data = lhs.cbegin();
-        auto const &rhs_data = rhs.cbegin();
+        MatmulBroadcastPlan plan = prepare_matmul_broadcast(lhs, rhs);
 
         auto const &lhs_strides = plan.lhs_strides;
         auto const &rhs_strides = plan.rhs_strides;
         auto const &res_strides = plan.res_strides;
 
-        vector<double> res(accumulate(plan.res_shape.begin(),
-                                        plan.res_shape.end(),
-                                        1, multiplies<size_t>()));
-
-        const size_t num_batches = plan.batch_size == 1 ? 1 : res.size() / plan.batch_size;
+        Tensor res{plan.res_shape, uninitialized};
+
+        const size_t num_batches = res.size() / plan.batch_size;
+        if (record)
+            record.describe({lhs.shape(), rhs.shape()}, {
+                .elements      = res.size(),
+                .flops         = 2 * num_batches * plan.rows * plan.cols * plan.shared,
+                .bytes_read    = (lhs.size() + rhs.size()) * sizeof(double),
+                .bytes_written = res.size() * sizeof(double),
+            });
+
+        size_t const row_axis = plan.max_rank - 2;
+        size_t const col_axis = plan.max_rank - 1;
+
+        // batches write disjoint slices of res; with fewer batches than
+        // threads gemm splits each product over row blocks instead
+        size_t const batch_work = plan.rows * plan.cols * plan.shared;
+        size_t const grain      = num_batches >= parallel::num_threads()
+                                  ? max<size_t>(1, batch_parallel_flops / max<size_t>(batch_work, 1))
+                                  : num_batches;
+
+        parallel::parallel_for(0, num_batches, grain, [&](size_t first, size_t last) {
+            for (size_t batch = first; batch < last; ++batch)
+            {
+                size_t res_offset = batch * plan.batch_size;
+                size_t lhs_offset = 0;
+                size_t rhs_offset = 0;
 
-        for (size_t batch = 0; batch < num_batches; ++batch)
-        {
-            size_t res_offset = batch * plan.batch_size;
-            size_t lhs_offset = 0;
-            size_t rhs_offset = 0;
+                size_t remaining  = res_offset;
+                for (size_t dim = 0; dim < row_axis; ++dim)
+                {
+                    size_t coord = remaining / res_strides[dim];
 
-            size_t remaining  = res_offset;
-            for (size_t dim = 0; dim < plan.max_rank - 2; ++dim)
-            {
-                size_t coord = remaining / res_strides[dim];
+                    lhs_offset += coord * lhs_strides[dim];
+                    rhs_offset += coord * rhs_strides[dim];
 
-                lhs_offset += coord * lhs_strides[dim];
-                rhs_offset += coord * rhs_strides[dim];
+                    remaining %= res_strides[dim];
+                }
 
-                remaining %= res_strides[dim];
+                gemm(plan.rows, plan.cols, plan.shared,
+                     lhs.data() + lhs_offset, lhs_strides[row_axis], lhs_strides[col_axis],
+                     rhs.data() + rhs_offset, rhs_strides[row_axis], rhs_strides[col_axis],
+                     res.data() + res_offset, res_strides[row_axis], res_strides[col_axis]);
             }
+        });
 
-            for (size_t row = 0; row < plan.rows; ++row)
-            {
-                for (size_t col = 0; col < plan.cols; ++col)
-                {
-                    size_t i_res = res_offset
-                                   + row * res_strides[plan.max_rank - 2]
-                                   + col * res_strides[plan.max_rank - 1];
-                    double sum = 0;
-                    for (size_t shd = 0; shd < plan.shared; ++shd)
+        return res;
+    }
+
+
+    // As matmul of Tensors, batches included. gemm widens 16-bit operands
+    // while packing them and the float result is rounded once; products of
+    // int32 tensors accumulate in int64.
+    template <typename T>
+    BasicTensor<T> matmul(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+    {
+        using Acc = accumulate_t<T>;
+
+        MatmulBroadcastPlan const plan = prepare_matmul_broadcast(
+            lhs.shape(), row_major(lhs.shape()),
+            rhs.shape(), row_major(rhs.shape()));
+
+        auto const &lhs_strides = plan.lhs_strides;
+        auto const &rhs_strides = plan.rhs_strides;
+        auto const &res_strides = plan.res_strides;
+
+        size_t const row_axis = plan.max_rank - 2;
+        size_t const col_axis = plan.max_rank - 1;
+
+        BasicTensor<T> result{plan.res_shape, uninitialized};
+
+        // 16-bit and int32 products are accumulated apart and rounded once
+        vector<Acc> wide;
+        Acc *c = nullptr;
+        if constexpr (is_same_v<T, Acc>)
+            c = result.data();
+        else
+        {
+            wide.assign(result.size(), Acc{});
+            c = wide.data();
+        }
+
+        auto product = [&](T const *a, T const *b, Acc *res) {
+            size_t const a_rs = lhs_strides[row_axis];
+            size_t const a_cs = lhs_strides[col_axis];
+            size_t const b_rs = rhs_strides[row_axis];
+            size_t const b_cs = rhs_strides[col_axis];
+            size_t const c_rs = res_strides[row_axis];
+            size_t const c_cs = res_strides[col_axis];
+
+            if constexpr (is_integral_v<T>)
+                for (size_t i = 0; i < plan.rows; ++i)
+                    for (size_t p = 0; p < plan.shared; ++p)
                     {
-                        size_t i_lhs = lhs_offset
-                                       + row * lhs_strides[plan.max_rank - 2]
-                                       + shd * lhs_strides[plan.max_rank - 1];
-                        size_t i_rhs = rhs_offset
-                                       + shd * rhs_strides[plan.max_rank - 2]
-                                       + col * rhs_strides[plan.max_rank - 1];
-
-                        sum += lhs_data[i_lhs] * rhs_data[i_rhs];
+                        Acc const value = a[i * a_rs + p * a_cs];
+                        for (size_t j = 0; j < plan.cols; ++j)
+                            res[i * c_rs + j * c_cs] += value * b[p * b_rs + j * b_cs];
                     }
+            else
+                gemm(plan.rows, plan.cols, plan.shared, a, a_rs, a_cs, b, b_rs, b_cs,
+                     res, c_rs, c_cs);
+        };
+
+        // as for Tensors: batches in parallel, or gemm's own row blocks
+        // when there are fewer batches than threads
+        size_t const num_batches = result.size() / plan.batch_size;
+        size_t const batch_work  = plan.rows * plan.cols * plan.shared;
+        size_t const grain       = num_batches >= parallel::num_threads()
+                                   ? max<size_t>(1, batch_parallel_flops / max<size_t>(batch_work, 1))
+                                   : num_batches;
+
+        parallel::parallel_for(0, num_batches, grain, [&](size_t first, size_t last) {
+            for (size_t batch = first; batch < last; ++batch)
+            {
+                size_t res_offset = batch * plan.batch_size;
+                size_t lhs_offset = 0;
+                size_t rhs_offset = 0;
+
+                size_t remaining  = res_offset;
+                for (size_t dim = 0; dim < row_axis; ++dim)
+                {
+                    size_t coord = remaining / res_strides[dim];
+
+                    lhs_offset += coord * lhs_strides[dim];
+                    rhs_offset += coord * rhs_strides[dim];
 
-                    res[i_res] = sum;
+                    remaining %= res_strides[dim];
                 }
+
+                product(lhs.data() + lhs_offset, rhs.data() + rhs_offset, c + res_offset);
             }
+        });
 
-        }
+        if constexpr (not is_same_v<T, Acc>)
+            detail::convert(wide.data(), result.data(), wide.size());
 
-        return Tensor{std::move(plan.res_shape), std::move(res)};
+        return result;
     }
 
-
+    template BasicTensor<float> matmul(BasicTensor<float> const &, BasicTensor<float> const &);
+    template BasicTensor<bfloat16> matmul(BasicTensor<bfloat16> const &,
+                                          BasicTensor<bfloat16> const &);
+    template BasicTensor<float16> matmul(BasicTensor<float16> const &,
+                                         BasicTensor<float16> const &);
+    template BasicTensor<int32_t> matmul(BasicTensor<int32_t> const &,
+                                         BasicTensor<int32_t> const &);
 }
@@ -2,6 +2,7 @@
 #define INCLUDED_LINALG
 
 #include "../tensor/tensor.h"
+#include "../tensor/basic_tensor.h"
 
 namespace autodiff
 {
@@ -15,6 +16,25 @@ namespace autodiff
     };
 
     Tensor matmul(const Tensor &t1, const Tensor &t2);
+
+    // Batched and broadcast as matmul of Tensors. Products are accumulated
+    // in accumulate_t<T> and rounded to T once per result element.
+    template <typename T>
+    BasicTensor<T> matmul(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs);
+
+    // c (m x n) = a (m x k) * b (k x n), every operand addressed through a
+    // row stride (rs) and column stride (cs). Packed and cache-blocked, with
+    // direct paths for the vector cases m == 1 and n == 1. Operands are
+    // read along their smaller stride, so transposed and sliced views cost
+    // about as much as contiguous ones.
+    //
+    // T is double, float, bfloat16 or float16. c holds accumulate_t<T>:
+    // 16-bit operands are widened to float while they are packed.
+    template <typename T>
+    void gemm(size_t m, size_t n, size_t k,
+              T const *a, size_t a_rs, size_t a_cs,
+              T const *b, size_t b_rs, size_t b_cs,
+              accumulate_t<T> *c, size_t c_rs, size_t c_cs);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "memory.ih"
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        mutex &default_mutex()
+        {
+            static mutex default_mutex;
+            return default_mutex;
+        }
+
+        shared_ptr<Allocator> &default_slot()
+        {
+            static shared_ptr<Allocator> allocator = make_shared<PoolAllocator>();
+            return allocator;
+        }
+
+        // innermost Scope of this thread, empty outside any scope
+        thread_local shared_ptr<Allocator> t_scoped;
+    }
+
+    HeapAllocator::HeapAllocator(size_t alignment)
+    :
+        d_alignment(checked_alignment(alignment))
+    {}
+
+    void *HeapAllocator::allocate(size_t bytes)
+    {
+        void *ptr = system_allocate(bytes, d_alignment);
+
+        lock_guard lock{d_mutex};
+        ++d_stats.fresh_allocations;
+        d_stats.fresh_bytes += bytes;
+        return ptr;
+    }
+
+    void HeapAllocator::deallocate(void *ptr, size_t bytes)
+    {
+        system_deallocate(ptr, bytes, d_alignment);
+    }
+
+    Stats HeapAllocator::stats() const
+    {
+        lock_guard lock{d_mutex};
+        return d_stats;
+    }
+
+    Scope::Scope(shared_ptr<Allocator> allocator)
+    :
+        d_previous(exchange(t_scoped, std::move(allocator)))
+    {}
+
+    Scope::~Scope()
+    {
+        t_scoped = std::move(d_previous);
+    }
+
+    shared_ptr<Allocator> default_allocator()
+    {
+        lock_guard lock{default_mutex()};
+        return default_slot();
+    }
+
+    void set_default_allocator(shared_ptr<Allocator> allocator)
+    {
+        if (not allocator)
+            allocator = make_shared<HeapAllocator>();
+
+        lock_guard lock{default_mutex()};
+        default_slot().swap(allocator);
+    }
+
+    shared_ptr<Allocator> current_allocator()
+    {
+        return t_scoped ? t_scoped : default_allocator();
+    }
+}
@@ -0,0 +1,96 @@
+#include "memory.ih"
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        // keeps every block on its own alignment boundary
+        size_t round_up(size_t bytes, size_t alignment)
+        {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    Arena::Arena(size_t chunk_bytes, size_t alignment)
+    :
+        d_alignment(checked_alignment(alignment)),
+        d_chunk_bytes(round_up(chunk_bytes, d_alignment))
+    {}
+
+    Arena::~Arena()
+    {
+        for (Chunk const &chunk : d_chunks)
+            system_deallocate(chunk.data, chunk.size, d_alignment);
+    }
+
+    void *Arena::allocate(size_t bytes)
+    {
+        bytes = round_up(max<size_t>(bytes, 1), d_alignment);
+
+        unique_lock lock{d_mutex};
+        while (true)
+        {
+            // move on to the next chunk that fits, reusing those of earlier steps
+            while (d_current < d_chunks.size() and d_used + bytes > d_chunks[d_current].size)
+            {
+                ++d_current;
+                d_used = 0;
+            }
+
+            if (d_current < d_chunks.size())
+                break;
+
+            // placing the pages may run on the pool, whose tasks can
+            // allocate from this arena, so the lock is not held meanwhile;
+            // chunks other threads add in between are used as well
+            size_t const size = max(d_chunk_bytes, bytes);
+            lock.unlock();
+            char *const data = static_cast<char *>(system_allocate(size, d_alignment));
+            lock.lock();
+
+            d_chunks.push_back({data, size});
+            d_stats.fresh_bytes += size;
+        }
+
+        if (d_current < d_kept)
+        {
+            ++d_stats.reused_allocations;
+            d_stats.reused_bytes += bytes;
+        }
+        else
+            ++d_stats.fresh_allocations;
+
+        void *ptr = d_chunks[d_current].data + d_used;
+        d_used += bytes;
+        ++d_live;
+        return ptr;
+    }
+
+    void Arena::deallocate(void *, size_t)
+    {
+        lock_guard lock{d_mutex};
+
+        if (--d_live == 0)
+        {
+            d_current = 0;
+            d_used    = 0;
+            d_kept    = d_chunks.size();
+        }
+    }
+
+    Stats Arena::stats() const
+    {
+        lock_guard lock{d_mutex};
+
+        Stats stats = d_stats;
+        for (Chunk const &chunk : d_chunks)
+            stats.cached_bytes += chunk.size;
+        return stats;
+    }
+
+    size_t Arena::live() const
+    {
+        lock_guard lock{d_mutex};
+        return d_live;
+    }
+}
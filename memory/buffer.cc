@@ -0,0 +1,104 @@
+#include "memory.ih"
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        // std allocator over a memory::Allocator, so shared_ptr control
+        // blocks come from the same pool as the data
+        template <typename T>
+        struct Adaptor
+        {
+            using value_type = T;
+
+            shared_ptr<Allocator> allocator;
+
+            explicit Adaptor(shared_ptr<Allocator> source)
+            :
+                allocator(std::move(source))
+            {}
+
+            template <typename U>
+            Adaptor(Adaptor<U> const &other)
+            :
+                allocator(other.allocator)
+            {}
+
+            T *allocate(size_t count)
+            {
+                return static_cast<T *>(allocator->allocate(count * sizeof(T)));
+            }
+
+            void deallocate(T *ptr, size_t count)
+            {
+                allocator->deallocate(ptr, count * sizeof(T));
+            }
+
+            template <typename U>
+            bool operator==(Adaptor<U> const &other) const
+            {
+                return allocator == other.allocator;
+            }
+        };
+
+        thread_local Allocations t_allocations;
+    }
+
+    Buffer::Buffer(size_t size, shared_ptr<Allocator> allocator)
+    :
+        d_allocator(std::move(allocator)),
+        d_data(static_cast<double *>(d_allocator->allocate(size * sizeof(double)))),
+        d_size(size),
+        d_origin(account_allocation(this, size * sizeof(double)))
+    {}
+
+    Buffer::Buffer(double *data, size_t size, shared_ptr<void> owner)
+    :
+        d_owner(std::move(owner)),
+        d_data(data),
+        d_size(size)
+    {}
+
+    Buffer::~Buffer()
+    {
+        if (not d_allocator)
+            return;
+
+        account_release(this, d_size * sizeof(double), d_origin);
+        d_allocator->deallocate(d_data, d_size * sizeof(double));
+    }
+
+    double *Buffer::data()
+    {
+        return d_data;
+    }
+
+    double const *Buffer::data() const
+    {
+        return d_data;
+    }
+
+    size_t Buffer::size() const
+    {
+        return d_size;
+    }
+
+    char const *Buffer::origin() const
+    {
+        return d_origin;
+    }
+
+    shared_ptr<Buffer> allocate(size_t size)
+    {
+        ++t_allocations.count;
+        t_allocations.bytes += size * sizeof(double);
+
+        shared_ptr<Allocator> allocator = current_allocator();
+        return allocate_shared<Buffer>(Adaptor<Buffer>{allocator}, size, allocator);
+    }
+
+    Allocations thread_allocations()
+    {
+        return t_allocations;
+    }
+}
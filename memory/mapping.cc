@@ -0,0 +1,84 @@
+#include "memory.ih"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        [[noreturn]] void throw_errno(string const &what, string const &path)
+        {
+            throw system_error(errno, generic_category(), what + " " + path);
+        }
+    }
+
+    Mapping::Mapping(string const &path)
+    {
+        int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw_errno("cannot open", path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            int const error = errno;
+            ::close(fd);
+            errno = error;
+            throw_errno("cannot stat", path);
+        }
+
+        d_size = static_cast<size_t>(info.st_size);
+        if (d_size == 0)
+        {
+            ::close(fd);
+            errno = EINVAL;             // mmap refuses a zero length
+            throw_errno("cannot map empty file", path);
+        }
+
+        // private and writable: copy-on-write, the file is never modified
+        d_data = ::mmap(nullptr, d_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        int const error = errno;
+        ::close(fd);                    // the mapping holds its own reference
+
+        if (d_data == MAP_FAILED)
+        {
+            errno = error;
+            throw_errno("cannot map", path);
+        }
+    }
+
+    Mapping::~Mapping()
+    {
+        ::munmap(d_data, d_size);
+    }
+
+    char *Mapping::data()
+    {
+        return static_cast<char *>(d_data);
+    }
+
+    char const *Mapping::data() const
+    {
+        return static_cast<char const *>(d_data);
+    }
+
+    size_t Mapping::size() const
+    {
+        return d_size;
+    }
+
+    shared_ptr<Buffer> map(shared_ptr<Mapping> mapping, size_t offset, size_t size)
+    {
+        if (offset + size * sizeof(double) > mapping->size() or offset % alignof(double) != 0)
+            throw invalid_argument("buffer does not fit the mapping");
+
+        double *data = reinterpret_cast<double *>(mapping->data() + offset);
+        return make_shared<Buffer>(data, size, std::move(mapping));
+    }
+}
@@ -0,0 +1,291 @@
+#ifndef INCLUDED_MEMORY
+#define INCLUDED_MEMORY
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace autodiff::memory
+{
+    struct Stats
+    {
+        size_t fresh_allocations  = 0;   // served by the system heap
+        size_t reused_allocations = 0;   // served from memory already held
+        size_t fresh_bytes        = 0;
+        size_t reused_bytes       = 0;
+        size_t cached_bytes       = 0;   // held for reuse right now
+    };
+
+    // Alignment of the blocks allocators hand out: a cache line, so no
+    // buffer straddles one and vector loads of a block never split one.
+    inline constexpr size_t default_alignment = 64;
+
+    // Where the pages of fresh allocations of 256 KiB and more go. With
+    // any they land on the node of the thread that first writes them,
+    // which for a buffer filled on the main thread is that thread's node.
+    enum class Placement
+    {
+        any,
+        first_touch,    // written page by page by the parallel pool
+        local,          // preferably on the node of the allocating thread
+    };
+
+    // Process-wide; blocks a PoolAllocator or Arena reuses keep the
+    // placement they were first allocated with.
+    void set_placement(Placement placement);
+    Placement placement();
+
+    // Source of tensor storage. Implementations must be thread-safe: buffers
+    // may be released on a different thread than the one allocating them.
+    class Allocator
+    {
+    public:
+        virtual ~Allocator() = default;
+
+        virtual void *allocate(size_t bytes) = 0;
+        virtual void deallocate(void *ptr, size_t bytes) = 0;
+
+        virtual Stats stats() const = 0;
+    };
+
+    // Aligned blocks straight from system memory, nothing cached.
+    class HeapAllocator : public Allocator
+    {
+        mutable std::mutex d_mutex;
+        Stats              d_stats;
+        size_t             d_alignment;
+
+    public:
+        // alignment must be a power of two of at least alignof(max_align_t)
+        explicit HeapAllocator(size_t alignment = default_alignment);
+
+        void *allocate(size_t bytes) override;
+        void deallocate(void *ptr, size_t bytes) override;
+
+        Stats stats() const override;
+    };
+
+    // Caches released blocks in size classes (four per power of two) and
+    // hands them out again, up to max_cached_bytes held at any time.
+    class PoolAllocator : public Allocator
+    {
+        mutable std::mutex              d_mutex;
+        std::vector<std::vector<void *>> d_free;   // per size class
+        size_t                          d_max_cached;
+        size_t                          d_alignment;
+        Stats                           d_stats;
+
+    public:
+        explicit PoolAllocator(size_t max_cached_bytes = size_t{1} << 30,
+                               size_t alignment = default_alignment);
+        ~PoolAllocator() override;
+
+        void *allocate(size_t bytes) override;
+        void deallocate(void *ptr, size_t bytes) override;
+
+        Stats stats() const override;
+
+        void release();                 // return every cached block to the heap
+    };
+
+    // Bump allocator for per-step temporaries. Blocks are carved out of large
+    // chunks and freeing is only counted; once every block is released the
+    // arena rewinds and the next step reuses the same chunks. Tensors that
+    // outlive the step should therefore not be allocated from it. Blocks
+    // count as reused when their chunk predates the last rewind; fresh_bytes
+    // counts the chunks taken from the system.
+    class Arena : public Allocator
+    {
+        struct Chunk
+        {
+            char   *data;
+            size_t  size;
+        };
+
+        mutable std::mutex d_mutex;
+        std::vector<Chunk> d_chunks;
+        size_t             d_alignment;        // of chunks and blocks
+        size_t             d_chunk_bytes;
+        size_t             d_current = 0;   // chunk being carved
+        size_t             d_used    = 0;   // bytes used in the current chunk
+        size_t             d_live    = 0;   // blocks not yet released
+        size_t             d_kept    = 0;   // chunks allocated before the last rewind
+        Stats              d_stats;
+
+    public:
+        explicit Arena(size_t chunk_bytes = size_t{1} << 22,
+                       size_t alignment = default_alignment);
+        ~Arena() override;
+
+        void *allocate(size_t bytes) override;
+        void deallocate(void *ptr, size_t bytes) override;
+
+        Stats stats() const override;
+
+        size_t live() const;
+    };
+
+    // Routes the tensor allocations of the current thread to allocator for
+    // as long as the scope lives. Scopes nest.
+    class Scope
+    {
+        std::shared_ptr<Allocator> d_previous;
+
+    public:
+        explicit Scope(std::shared_ptr<Allocator> allocator);
+        ~Scope();
+
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+    };
+
+    // Process-wide allocator used outside any Scope, a PoolAllocator by default.
+    std::shared_ptr<Allocator> default_allocator();
+    void set_default_allocator(std::shared_ptr<Allocator> allocator);
+
+    std::shared_ptr<Allocator> current_allocator();
+
+    // Tensor storage: size doubles from an allocator, which the buffer keeps
+    // alive until it is released, or memory owned by something else (a
+    // Mapping), which the buffer keeps alive instead. Only the former count
+    // in usage().
+    class Buffer
+    {
+        std::shared_ptr<Allocator> d_allocator;
+        std::shared_ptr<void>      d_owner;
+        double                    *d_data;
+        size_t                     d_size;
+        char const                *d_origin = nullptr;  // set while tracking origins
+
+    public:
+        Buffer(size_t size, std::shared_ptr<Allocator> allocator);
+        Buffer(double *data, size_t size, std::shared_ptr<void> owner);
+        ~Buffer();
+
+        Buffer(Buffer const &) = delete;
+        Buffer &operator=(Buffer const &) = delete;
+
+        double       *data();
+        double const *data() const;
+        size_t        size() const;
+        char const   *origin() const;               // null when not tracked
+    };
+
+    // Uninitialised buffer from current_allocator(); the shared_ptr control
+    // block comes from the same allocator.
+    std::shared_ptr<Buffer> allocate(size_t size);
+
+    struct Allocations
+    {
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    // Buffers made by allocate() on the calling thread so far, which lets
+    // callers attribute allocations to the code running on it
+    Allocations thread_allocations();
+
+    // Tensor memory held by allocator-backed Buffers, over all threads.
+    // Updated with relaxed atomics on every buffer made and released, so
+    // the fields of one snapshot may be a few allocations apart.
+    struct Usage
+    {
+        size_t current_bytes = 0;               // in live buffers
+        size_t peak_bytes    = 0;               // of current_bytes since reset_peak()
+        size_t total_bytes   = 0;               // ever allocated
+        size_t live_buffers  = 0;
+        size_t total_buffers = 0;
+
+        // live buffers by size: histogram[i] counts those of
+        // (2^(i-1), 2^i] bytes
+        std::array<size_t, 64> histogram{};
+    };
+
+    Usage usage();
+    void reset_peak();                          // peak_bytes = current_bytes
+
+    // Debug mode: every buffer made while it is on remembers the innermost
+    // Label (the op) active on its thread, at the cost of a registry lock
+    // per buffer.
+    void track_origins(bool enable = true);
+
+    namespace detail
+    {
+        inline std::atomic<bool> tracking{false};
+
+        char const *exchange_label(char const *label);
+    }
+
+    inline bool tracking_origins()
+    {
+        return detail::tracking.load(std::memory_order_relaxed);
+    }
+
+    struct Origin
+    {
+        std::string op;                         // "unlabelled" outside any Label
+        size_t      buffers = 0;
+        size_t      bytes   = 0;
+    };
+
+    // Live tracked buffers grouped by the op that made them, most bytes first
+    std::vector<Origin> live_origins();
+
+    // Names the op allocating on this thread while origins are tracked,
+    // a no-op otherwise. Labels nest; profile::Record sets one per op.
+    class Label
+    {
+        char const *d_previous = nullptr;
+        bool        d_active;
+
+    public:
+        explicit Label(char const *op)
+        :
+            d_active(tracking_origins())
+        {
+            if (d_active)
+                d_previous = detail::exchange_label(op);
+        }
+
+        ~Label()
+        {
+            if (d_active)
+                detail::exchange_label(d_previous);
+        }
+
+        Label(Label const &) = delete;
+        Label &operator=(Label const &) = delete;
+    };
+
+    // A file mapped privately into memory. Pages are read on first touch
+    // and shared with the page cache, and so with every other process
+    // mapping the file, until they are written; writes stay private and
+    // never reach the file. Throws system_error when the file cannot be
+    // opened or mapped, which includes an empty file.
+    class Mapping
+    {
+        void   *d_data = nullptr;
+        size_t  d_size = 0;
+
+    public:
+        explicit Mapping(std::string const &path);
+        ~Mapping();
+
+        Mapping(Mapping const &) = delete;
+        Mapping &operator=(Mapping const &) = delete;
+
+        char       *data();
+        char const *data() const;
+        size_t      size() const;
+    };
+
+    // Buffer of size doubles at offset bytes into mapping, without copying.
+    // The buffer keeps the mapping alive.
+    std::shared_ptr<Buffer> map(std::shared_ptr<Mapping> mapping, size_t offset, size_t size);
+}
+
+#endif
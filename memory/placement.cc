@@ -0,0 +1,133 @@
+#include "memory.ih"
+
+#include "../parallel/parallel.h"
+
+#include <bit>
+#include <cstdint>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        // smaller blocks come from pages the heap has touched already;
+        // larger ones are mapped, and unmapped, on their own
+        size_t const placed_bytes = size_t{1} << 18;
+
+        atomic<Placement> g_placement{Placement::any};
+
+        size_t page_size()
+        {
+            static size_t const page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return page;
+        }
+
+        size_t round_up(size_t bytes, size_t alignment)
+        {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+        // One write per page, split as the kernels split their loops, so
+        // each page is faulted in on the node of a pool thread
+        void first_touch(char *first, char *last, size_t page)
+        {
+            size_t const count = (last - first) / page;
+            parallel::parallel_for(0, count, parallel::grain_size(count, page / sizeof(double)),
+                [first, page](size_t begin, size_t end) {
+                    for (size_t index = begin; index < end; ++index)
+                        first[index * page] = 0;
+                });
+        }
+
+        // Asks for the pages to come from the node of the calling thread.
+        // A preference: when that node is full they come from another, and
+        // failures (no NUMA support) leave the default policy in place.
+        void prefer_local(char *first, char *last)
+        {
+            unsigned cpu  = 0;
+            unsigned node = 0;
+            if (getcpu(&cpu, &node) != 0)
+                return;
+
+            unsigned long mask[16] = {};
+            size_t const bits = sizeof(unsigned long) * 8;
+            if (node >= size(mask) * bits)
+                return;
+            mask[node / bits] = 1ul << node % bits;
+
+            syscall(SYS_mbind, first, last - first, MPOL_PREFERRED, mask, size(mask) * bits, 0);
+        }
+
+        // Large blocks own their pages, so a policy set on them ends with
+        // the block instead of passing on to later users of the heap
+        void *map_block(size_t bytes, size_t alignment)
+        {
+            size_t const page   = page_size();
+            size_t const length = round_up(bytes, page);
+            size_t const extra  = alignment > page ? alignment : 0;
+
+            void *ptr = mmap(nullptr, length + extra, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+                throw bad_alloc();
+
+            char *const base  = static_cast<char *>(ptr);
+            char *const first = base + (alignment - reinterpret_cast<uintptr_t>(base) % alignment) % alignment;
+            if (first != base)
+                munmap(base, first - base);
+            if (char *const tail = first + length; tail != base + length + extra)
+                munmap(tail, base + length + extra - tail);
+
+            return first;
+        }
+    }
+
+    void set_placement(Placement placement)
+    {
+        g_placement.store(placement, memory_order_relaxed);
+    }
+
+    Placement placement()
+    {
+        return g_placement.load(memory_order_relaxed);
+    }
+
+    void *system_allocate(size_t bytes, size_t alignment)
+    {
+        if (bytes < placed_bytes)
+            return ::operator new(bytes, align_val_t{alignment});
+
+        char *const first = static_cast<char *>(map_block(bytes, alignment));
+        char *const last  = first + round_up(bytes, page_size());
+
+        Placement const where = placement();
+        if (where == Placement::local)
+            prefer_local(first, last);
+        else if (where == Placement::first_touch)
+            first_touch(first, last, page_size());
+
+        return first;
+    }
+
+    void system_deallocate(void *ptr, size_t bytes, size_t alignment)
+    {
+        if (bytes < placed_bytes)
+            ::operator delete(ptr, align_val_t{alignment});
+        else
+            munmap(ptr, round_up(bytes, page_size()));
+    }
+
+    size_t checked_alignment(size_t alignment)
+    {
+        if (alignment < alignof(max_align_t) or not has_single_bit(alignment))
+            throw invalid_argument("alignment " + to_string(alignment)
+                                   + " is not a power of two of at least "
+                                   + to_string(alignof(max_align_t)));
+        return alignment;
+    }
+}
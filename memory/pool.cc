@@ -0,0 +1,107 @@
+#include "memory.ih"
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        // classes step by a quarter of a power of two: 64, 80, 96, 112, 128, 160, ...
+        size_t const min_class_bytes = 64;
+        size_t const steps_per_power = 4;
+        size_t const num_classes     = 4 * 40;
+
+        // smallest class holding bytes, as (index, class size)
+        pair<size_t, size_t> size_class(size_t bytes)
+        {
+            bytes = max(bytes, min_class_bytes);
+
+            size_t power = 0;
+            while ((min_class_bytes << (power + 1)) <= bytes)
+                ++power;
+
+            size_t const base = min_class_bytes << power;
+            size_t const step = base / steps_per_power;
+            size_t const sub  = (bytes - base + step - 1) / step;
+
+            return {power * steps_per_power + sub, base + sub * step};
+        }
+
+        // size of the class at index, the inverse of size_class
+        size_t class_size(size_t index)
+        {
+            size_t const base = min_class_bytes << index / steps_per_power;
+            return base + index % steps_per_power * (base / steps_per_power);
+        }
+    }
+
+    PoolAllocator::PoolAllocator(size_t max_cached_bytes, size_t alignment)
+    :
+        d_free(num_classes + 1),
+        d_max_cached(max_cached_bytes),
+        d_alignment(checked_alignment(alignment))
+    {}
+
+    PoolAllocator::~PoolAllocator()
+    {
+        release();
+    }
+
+    void *PoolAllocator::allocate(size_t bytes)
+    {
+        auto const [index, class_bytes] = size_class(bytes);
+
+        {
+            lock_guard lock{d_mutex};
+            if (index < d_free.size() and not d_free[index].empty())
+            {
+                void *ptr = d_free[index].back();
+                d_free[index].pop_back();
+
+                ++d_stats.reused_allocations;
+                d_stats.reused_bytes += class_bytes;
+                d_stats.cached_bytes -= class_bytes;
+                return ptr;
+            }
+
+            ++d_stats.fresh_allocations;
+            d_stats.fresh_bytes += class_bytes;
+        }
+
+        return system_allocate(class_bytes, d_alignment);
+    }
+
+    void PoolAllocator::deallocate(void *ptr, size_t bytes)
+    {
+        auto const [index, class_bytes] = size_class(bytes);
+
+        {
+            lock_guard lock{d_mutex};
+            if (index < d_free.size() and d_stats.cached_bytes + class_bytes <= d_max_cached)
+            {
+                d_free[index].push_back(ptr);
+                d_stats.cached_bytes += class_bytes;
+                return;
+            }
+        }
+
+        system_deallocate(ptr, class_bytes, d_alignment);
+    }
+
+    Stats PoolAllocator::stats() const
+    {
+        lock_guard lock{d_mutex};
+        return d_stats;
+    }
+
+    void PoolAllocator::release()
+    {
+        lock_guard lock{d_mutex};
+        for (size_t index = 0; index < d_free.size(); ++index)
+        {
+            for (void *ptr : d_free[index])
+                system_deallocate(ptr, class_size(index), d_alignment);
+            d_free[index].clear();
+        }
+
+        d_stats.cached_bytes = 0;
+    }
+}
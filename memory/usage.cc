@@ -0,0 +1,146 @@
+#include "memory.ih"
+
+#include <bit>
+#include <map>
+#include <unordered_set>
+
+namespace autodiff::memory
+{
+    namespace
+    {
+        size_t const buckets = 64;
+
+        struct Counters
+        {
+            atomic<size_t> current_bytes{0};
+            atomic<size_t> peak_bytes{0};
+            atomic<size_t> total_bytes{0};
+            atomic<size_t> live_buffers{0};
+            atomic<size_t> total_buffers{0};
+            array<atomic<size_t>, buckets> histogram{};
+        };
+
+        Counters &counters()
+        {
+            static Counters counters;
+            return counters;
+        }
+
+        // tracked live buffers
+        struct Registry
+        {
+            mutex                          lock;
+            unordered_set<Buffer const *>  buffers;
+        };
+
+        Registry &registry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        thread_local char const *t_label = nullptr;
+
+        char const unlabelled[] = "unlabelled";
+
+        size_t bucket(size_t bytes)
+        {
+            return min<size_t>(bit_width(max<size_t>(bytes, 1) - 1), buckets - 1);
+        }
+    }
+
+    char const *account_allocation(Buffer const *buffer, size_t bytes)
+    {
+        Counters &count = counters();
+        size_t const current = count.current_bytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+        count.total_bytes.fetch_add(bytes, memory_order_relaxed);
+        count.live_buffers.fetch_add(1, memory_order_relaxed);
+        count.total_buffers.fetch_add(1, memory_order_relaxed);
+        count.histogram[bucket(bytes)].fetch_add(1, memory_order_relaxed);
+
+        size_t peak = count.peak_bytes.load(memory_order_relaxed);
+        while (current > peak
+               and not count.peak_bytes.compare_exchange_weak(peak, current, memory_order_relaxed))
+            ;
+
+        if (not tracking_origins())
+            return nullptr;
+
+        Registry &live = registry();
+        lock_guard guard{live.lock};
+        live.buffers.insert(buffer);
+        return t_label ? t_label : unlabelled;
+    }
+
+    void account_release(Buffer const *buffer, size_t bytes, char const *origin)
+    {
+        Counters &count = counters();
+        count.current_bytes.fetch_sub(bytes, memory_order_relaxed);
+        count.live_buffers.fetch_sub(1, memory_order_relaxed);
+        count.histogram[bucket(bytes)].fetch_sub(1, memory_order_relaxed);
+
+        if (origin)
+        {
+            Registry &live = registry();
+            lock_guard guard{live.lock};
+            live.buffers.erase(buffer);
+        }
+    }
+
+    Usage usage()
+    {
+        Counters const &count = counters();
+
+        Usage result;
+        result.current_bytes = count.current_bytes.load(memory_order_relaxed);
+        result.peak_bytes    = count.peak_bytes.load(memory_order_relaxed);
+        result.total_bytes   = count.total_bytes.load(memory_order_relaxed);
+        result.live_buffers  = count.live_buffers.load(memory_order_relaxed);
+        result.total_buffers = count.total_buffers.load(memory_order_relaxed);
+        for (size_t index = 0; index < buckets; ++index)
+            result.histogram[index] = count.histogram[index].load(memory_order_relaxed);
+        return result;
+    }
+
+    void reset_peak()
+    {
+        Counters &count = counters();
+        count.peak_bytes.store(count.current_bytes.load(memory_order_relaxed),
+                               memory_order_relaxed);
+    }
+
+    void track_origins(bool enable)
+    {
+        detail::tracking.store(enable, memory_order_relaxed);
+    }
+
+    char const *detail::exchange_label(char const *label)
+    {
+        return exchange(t_label, label);
+    }
+
+    vector<Origin> live_origins()
+    {
+        std::map<string, Origin> groups;       // not memory::map
+        {
+            Registry &live = registry();
+            lock_guard guard{live.lock};
+            for (Buffer const *buffer : live.buffers)
+            {
+                Origin &group = groups[buffer->origin()];
+                group.op       = buffer->origin();
+                group.buffers += 1;
+                group.bytes   += buffer->size() * sizeof(double);
+            }
+        }
+
+        vector<Origin> result;
+        for (auto &[op, group] : groups)
+            result.push_back(std::move(group));
+
+        stable_sort(result.begin(), result.end(), [](Origin const &lhs, Origin const &rhs) {
+            return lhs.bytes > rhs.bytes;
+        });
+        return result;
+    }
+}
@@ -0,0 +1,86 @@
+#include "parallel.ih"
+
+namespace autodiff::parallel
+{
+    namespace
+    {
+        // element operations a chunk must carry to be worth a task
+        size_t const min_chunk_cost = size_t{1} << 15;
+
+        // chunks per thread, so stealing can even out uneven chunks
+        size_t const chunks_per_thread = 4;
+
+        size_t default_threads()
+        {
+            if (char const *env = getenv("AUTODIFF_NUM_THREADS"))
+            {
+                size_t threads = strtoul(env, nullptr, 10);
+                if (threads > 0)
+                    return threads;
+            }
+
+            return max(1u, thread::hardware_concurrency());
+        }
+
+        // read by grain_size on every kernel call, so kept out of the lock
+        atomic<size_t> &thread_count()
+        {
+            static atomic<size_t> count{default_threads()};
+            return count;
+        }
+
+        mutex &pool_mutex()
+        {
+            static mutex pool_mutex;
+            return pool_mutex;
+        }
+
+        shared_ptr<ThreadPool> &pool_slot()
+        {
+            static shared_ptr<ThreadPool> pool = make_shared<ThreadPool>(thread_count().load());
+            return pool;
+        }
+
+        // callers keep the pool alive while a resize swaps the slot
+        shared_ptr<ThreadPool> pool()
+        {
+            lock_guard lock{pool_mutex()};
+            return pool_slot();
+        }
+    }
+
+    size_t num_threads()
+    {
+        return thread_count().load(memory_order_relaxed);
+    }
+
+    void set_num_threads(size_t threads)
+    {
+        threads = max<size_t>(threads, 1);
+        auto replacement = make_shared<ThreadPool>(threads);
+
+        lock_guard lock{pool_mutex()};
+        pool_slot().swap(replacement);
+        thread_count().store(threads, memory_order_relaxed);
+    }
+
+    size_t grain_size(size_t size, size_t cost)
+    {
+        size_t const per_chunk = (min_chunk_cost + max<size_t>(cost, 1) - 1) / max<size_t>(cost, 1);
+        size_t const balanced  = size / (num_threads() * chunks_per_thread);
+
+        return max<size_t>({per_chunk, balanced, 1});
+    }
+
+    void parallel_for(size_t begin, size_t end, size_t grain,
+                      function<void(size_t, size_t)> const &body)
+    {
+        if (begin >= end)
+            return;
+
+        if (end - begin < 2 * max<size_t>(grain, 1))
+            return body(begin, end);
+
+        pool()->run(begin, end, grain, body);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef INCLUDED_PARALLEL
+#define INCLUDED_PARALLEL
+
+#include <cstddef>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace autodiff::parallel
+{
+    // Persistent work-stealing pool. run() splits a range in halves until
+    // chunks are shorter than twice the grain; the halves go to the bottom
+    // of the running thread's deque and idle threads steal from the top of
+    // any deque. Callers help execute tasks while they wait and sleep once
+    // none are left, so run() may be called concurrently from user threads
+    // and from inside a chunk.
+    class ThreadPool
+    {
+        struct Job;
+        struct Task;
+        struct Queue;
+
+        std::vector<std::unique_ptr<Queue>> d_queues;   // [0] is shared by external callers
+        std::vector<std::thread>            d_workers;
+        std::atomic<size_t>                 d_pending{0};
+        std::mutex                          d_sleep;
+        std::condition_variable             d_wake;
+        std::mutex                          d_done_lock;
+        std::condition_variable             d_done;    // the last chunk of a job finished
+        bool                                d_stop = false;
+
+    public:
+        explicit ThreadPool(size_t threads);
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const &) = delete;
+        ThreadPool &operator=(ThreadPool const &) = delete;
+
+        size_t size() const;       // workers plus the calling thread
+
+        void run(size_t begin, size_t end, size_t grain,
+                 std::function<void(size_t, size_t)> const &body);
+
+    private:
+        void worker(size_t index);
+
+        Queue &local_queue();
+        void push(Task const &task);
+        bool pop(Task &task);
+        bool steal(Task &task);
+        bool execute_one();
+        void execute(Task task);
+    };
+
+    // Threads used by the library's kernels. Defaults to the
+    // AUTODIFF_NUM_THREADS environment variable, or the hardware concurrency.
+    size_t num_threads();
+    void   set_num_threads(size_t threads);
+
+    // Items per chunk for a loop over size items that each cost about cost
+    // element operations: large enough to amortise a task, small enough to
+    // balance over the pool. Loops shorter than one grain stay serial.
+    size_t grain_size(size_t size, size_t cost = 1);
+
+    // Calls body(first, last) on disjoint subranges of [begin, end). The
+    // subranges depend only on the range and grain, never on the thread
+    // count; ranges shorter than twice the grain run inline.
+    void parallel_for(size_t begin, size_t end, size_t grain,
+                      std::function<void(size_t, size_t)> const &body);
+
+    // Runs loops below the split threshold without type-erasing body.
+    template <typename Body>
+    void parallel_for(size_t begin, size_t end, size_t grain, Body const &body)
+    {
+        if (begin < end and end - begin < 2 * std::max<size_t>(grain, 1))
+            return body(begin, end);
+
+        parallel_for(begin, end, grain, std::function<void(size_t, size_t)>{std::cref(body)});
+    }
+}
+
+#endif
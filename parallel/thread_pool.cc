@@ -0,0 +1,230 @@
+#include "parallel.ih"
+
+namespace autodiff::parallel
+{
+    namespace
+    {
+        // identifies the pool and deque of worker threads
+        thread_local ThreadPool const *t_pool  = nullptr;
+        thread_local size_t            t_queue = 0;
+
+        // empty polls a waiting caller spins through before it sleeps
+        size_t const max_spins = 64;
+
+        // a sleeping caller looks for queued tasks again after this long
+        chrono::microseconds const recheck{500};
+    }
+
+    struct ThreadPool::Job
+    {
+        function<void(size_t, size_t)> const *body;
+        size_t                                grain;
+        atomic<size_t>                        remaining;   // items not yet executed
+        exception_ptr                         error;
+        mutex                                 error_mutex;
+    };
+
+    struct ThreadPool::Task
+    {
+        Job    *job;
+        size_t  begin;
+        size_t  end;
+    };
+
+    struct ThreadPool::Queue
+    {
+        mutex       lock;
+        deque<Task> tasks;
+    };
+
+    ThreadPool::ThreadPool(size_t threads)
+    {
+        size_t const workers = max<size_t>(threads, 1) - 1;
+
+        for (size_t i = 0; i <= workers; ++i)
+            d_queues.push_back(make_unique<Queue>());
+
+        for (size_t i = 1; i <= workers; ++i)
+            d_workers.emplace_back(&ThreadPool::worker, this, i);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            lock_guard lock{d_sleep};
+            d_stop = true;
+        }
+        d_wake.notify_all();
+
+        for (thread &worker : d_workers)
+            worker.join();
+    }
+
+    size_t ThreadPool::size() const
+    {
+        return d_workers.size() + 1;
+    }
+
+    void ThreadPool::run(size_t begin, size_t end, size_t grain,
+                         function<void(size_t, size_t)> const &body)
+    {
+        if (begin >= end)
+            return;
+
+        Job job;
+        job.body  = &body;
+        job.grain = max<size_t>(grain, 1);
+        job.remaining.store(end - begin);
+
+        execute(Task{&job, begin, end});
+
+        // help with whatever is queued until the last chunk of this job is
+        // done; chunks taken by other threads may still be running, so
+        // after a short spin sleep until the last one finishes or new tasks
+        // are queued
+        size_t spins = 0;
+        while (job.remaining.load(memory_order_acquire) != 0)
+        {
+            if (execute_one())
+            {
+                spins = 0;
+                continue;
+            }
+
+            if (++spins < max_spins)
+            {
+                this_thread::yield();
+                continue;
+            }
+
+            unique_lock lock{d_done_lock};
+            d_done.wait_for(lock, recheck, [this, &job] {
+                return job.remaining.load(memory_order_acquire) == 0 or d_pending.load() > 0;
+            });
+        }
+
+        if (job.error)
+            rethrow_exception(job.error);
+    }
+
+    void ThreadPool::worker(size_t index)
+    {
+        t_pool  = this;
+        t_queue = index;
+
+        while (true)
+        {
+            if (execute_one())
+                continue;
+
+            unique_lock lock{d_sleep};
+            d_wake.wait(lock, [this] {
+                return d_stop or d_pending.load() > 0;
+            });
+
+            if (d_stop)
+                return;
+        }
+    }
+
+    ThreadPool::Queue &ThreadPool::local_queue()
+    {
+        return *d_queues[t_pool == this ? t_queue : 0];
+    }
+
+    void ThreadPool::push(Task const &task)
+    {
+        Queue &queue = local_queue();
+        {
+            lock_guard guard{queue.lock};
+            queue.tasks.push_back(task);
+        }
+
+        ++d_pending;
+        {
+            lock_guard lock{d_sleep};
+        }
+        d_wake.notify_one();
+    }
+
+    // newest task of the own deque: the smallest and most cache-warm half
+    bool ThreadPool::pop(Task &task)
+    {
+        Queue &queue = local_queue();
+        lock_guard guard{queue.lock};
+
+        if (queue.tasks.empty())
+            return false;
+
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        --d_pending;
+        return true;
+    }
+
+    // oldest task of another deque: the largest half left to split
+    bool ThreadPool::steal(Task &task)
+    {
+        size_t const count = d_queues.size();
+        size_t const start = t_pool == this ? t_queue : 0;
+
+        for (size_t offset = 1; offset <= count; ++offset)
+        {
+            Queue &queue = *d_queues[(start + offset) % count];
+            lock_guard guard{queue.lock};
+
+            if (queue.tasks.empty())
+                continue;
+
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            --d_pending;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ThreadPool::execute_one()
+    {
+        Task task;
+        if (not pop(task) and not steal(task))
+            return false;
+
+        execute(task);
+        return true;
+    }
+
+    void ThreadPool::execute(Task task)
+    {
+        Job &job = *task.job;
+
+        while (task.end - task.begin >= 2 * job.grain)
+        {
+            size_t const mid = task.begin + (task.end - task.begin) / 2;
+            push(Task{&job, mid, task.end});
+            task.end = mid;
+        }
+
+        try
+        {
+            (*job.body)(task.begin, task.end);
+        }
+        catch (...)
+        {
+            lock_guard lock{job.error_mutex};
+            if (not job.error)
+                job.error = current_exception();
+        }
+
+        // last access to job: the owner may return once remaining hits 0
+        size_t const count = task.end - task.begin;
+        if (job.remaining.fetch_sub(count, memory_order_acq_rel) != count)
+            return;
+
+        {
+            lock_guard lock{d_done_lock};
+        }
+        d_done.notify_all();
+    }
+}
@@ -0,0 +1,172 @@
+#include "profile.ih"
+
+namespace autodiff::profile
+{
+    namespace
+    {
+        struct Session
+        {
+            mutex                        lock;
+            vector<Event>                events;
+            chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+        };
+
+        Session &session()
+        {
+            static Session session;
+            return session;
+        }
+
+        size_t thread_number()
+        {
+            static atomic<size_t> next{0};
+            thread_local size_t const number = next++;
+            return number;
+        }
+
+        string signature(initializer_list<Dims> shapes)
+        {
+            string result;
+            for (Dims const &shape : shapes)
+            {
+                result += result.empty() ? "[" : " [";
+                for (size_t axis = 0; axis < shape.size(); ++axis)
+                    result += (axis ? "," : "") + to_string(shape[axis]);
+                result += "]";
+            }
+            return result;
+        }
+
+        double microseconds(chrono::nanoseconds time)
+        {
+            return chrono::duration<double, micro>(time).count();
+        }
+    }
+
+    void enable()
+    {
+        Session &current = session();
+        {
+            lock_guard guard{current.lock};
+            current.events.clear();
+            current.origin = chrono::steady_clock::now();
+        }
+        detail::active.store(true, memory_order_relaxed);
+    }
+
+    void disable()
+    {
+        detail::active.store(false, memory_order_relaxed);
+    }
+
+    vector<Event> events()
+    {
+        Session &current = session();
+        lock_guard guard{current.lock};
+        return current.events;
+    }
+
+    vector<Summary> summary()
+    {
+        map<pair<string, string>, Summary> totals;
+        for (Event const &event : events())
+        {
+            Summary &total = totals[{event.name, event.signature}];
+            total.name       = event.name;
+            total.signature  = event.signature;
+            total.calls     += 1;
+            total.time      += event.duration;
+            total.counters.elements      += event.counters.elements;
+            total.counters.flops         += event.counters.flops;
+            total.counters.bytes_read    += event.counters.bytes_read;
+            total.counters.bytes_written += event.counters.bytes_written;
+            total.allocations     += event.allocations;
+            total.allocated_bytes += event.allocated_bytes;
+        }
+
+        vector<Summary> result;
+        for (auto &[key, total] : totals)
+            result.push_back(std::move(total));
+
+        stable_sort(result.begin(), result.end(), [](Summary const &lhs, Summary const &rhs) {
+            return lhs.time > rhs.time;
+        });
+        return result;
+    }
+
+    void report(ostream &out)
+    {
+        out << "op\tshapes\tcalls\ttime us\tGFLOP/s\tGB/s\tallocations\n";
+        for (Summary const &total : summary())
+        {
+            double const seconds = chrono::duration<double>(total.time).count();
+            double const bytes   = static_cast<double>(total.counters.bytes_read
+                                                       + total.counters.bytes_written);
+
+            out << total.name << '\t' << total.signature << '\t' << total.calls << '\t'
+                << microseconds(total.time) << '\t'
+                << (seconds > 0 ? total.counters.flops / seconds * 1e-9 : 0.0) << '\t'
+                << (seconds > 0 ? bytes / seconds * 1e-9 : 0.0) << '\t'
+                << total.allocations << '\n';
+        }
+    }
+
+    void write_trace(ostream &out)
+    {
+        out << "{\"traceEvents\":[";
+        bool first = true;
+        for (Event const &event : events())
+        {
+            out << (first ? "\n" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"cat\":\"op\",\"ph\":\"X\""
+                << ",\"ts\":" << microseconds(event.start)
+                << ",\"dur\":" << microseconds(event.duration)
+                << ",\"pid\":0,\"tid\":" << event.thread
+                << ",\"args\":{\"shapes\":\"" << event.signature << '"'
+                << ",\"elements\":" << event.counters.elements
+                << ",\"flops\":" << event.counters.flops
+                << ",\"bytes_read\":" << event.counters.bytes_read
+                << ",\"bytes_written\":" << event.counters.bytes_written
+                << ",\"allocations\":" << event.allocations
+                << ",\"allocated_bytes\":" << event.allocated_bytes << "}}";
+            first = false;
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    void Record::describe(initializer_list<Dims> shapes, Counters const &counters)
+    {
+        d_signature = signature(shapes);
+        d_counters  = counters;
+    }
+
+    void Record::start()
+    {
+        memory::Allocations const allocations = memory::thread_allocations();
+        d_allocations     = allocations.count;
+        d_allocated_bytes = allocations.bytes;
+        d_start           = chrono::steady_clock::now();
+    }
+
+    void Record::finish()
+    {
+        auto const stop = chrono::steady_clock::now();
+        memory::Allocations const allocations = memory::thread_allocations();
+
+        Event event{
+            .name            = d_name,
+            .signature       = std::move(d_signature),
+            .counters        = d_counters,
+            .allocations     = allocations.count - d_allocations,
+            .allocated_bytes = allocations.bytes - d_allocated_bytes,
+            .thread          = thread_number(),
+        };
+
+        Session &current = session();
+        lock_guard guard{current.lock};
+        // a call that started before enable() is cut at the start of the session
+        event.start    = max(d_start, current.origin) - current.origin;
+        event.duration = stop - max(d_start, current.origin);
+        current.events.push_back(std::move(event));
+    }
+}
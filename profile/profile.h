@@ -0,0 +1,136 @@
+#ifndef INCLUDED_PROFILE
+#define INCLUDED_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <initializer_list>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "../tensor/dims.h"
+#include "../memory/memory.h"
+
+// Set to 0 to compile the instrumentation out. Otherwise an op costs one
+// relaxed atomic load and a branch while the profiler is disabled.
+#ifndef AUTODIFF_PROFILE
+#define AUTODIFF_PROFILE 1
+#endif
+
+namespace autodiff::profile
+{
+    // Work done by one op call, as estimated by the op
+    struct Counters
+    {
+        size_t elements      = 0;           // of the result
+        size_t flops         = 0;
+        size_t bytes_read    = 0;
+        size_t bytes_written = 0;
+    };
+
+    struct Event
+    {
+        std::string              name;
+        std::string              signature;     // operand shapes, "[64,32] [32]"
+        Counters                 counters;
+        size_t                   allocations = 0;
+        size_t                   allocated_bytes = 0;
+        size_t                   thread = 0;    // numbered from 0 in order of first use
+        std::chrono::nanoseconds start{};       // since enable()
+        std::chrono::nanoseconds duration{};
+    };
+
+    // The calls of one op with one signature. Times include the ops
+    // called from inside the op.
+    struct Summary
+    {
+        std::string              name;
+        std::string              signature;
+        size_t                   calls = 0;
+        std::chrono::nanoseconds time{};
+        Counters                 counters;
+        size_t                   allocations = 0;
+        size_t                   allocated_bytes = 0;
+    };
+
+    namespace detail
+    {
+        inline std::atomic<bool> active{false};
+    }
+
+    inline bool enabled()
+    {
+#if AUTODIFF_PROFILE
+        return detail::active.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    void enable();                          // starts a session, dropping earlier events
+    void disable();                         // stops recording, keeps the events
+
+    std::vector<Event> events();            // in order of completion
+    std::vector<Summary> summary();         // most time first
+
+    // summary() as a table
+    void report(std::ostream &out);
+
+    // Chrome trace-event JSON, for chrome://tracing or Perfetto: one
+    // complete event per call, with the counters as arguments
+    void write_trace(std::ostream &out);
+
+    // Times an op call from construction to destruction while the
+    // profiler is enabled, and does nothing otherwise. It also labels the
+    // buffers the op makes while memory::track_origins() is on. Ops only
+    // describe themselves when they are recorded:
+    //
+    //     profile::Record record{"matmul"};
+    //     if (record)
+    //         record.describe({lhs.shape(), rhs.shape()}, {...});
+    class Record
+    {
+        char const                           *d_name;
+        memory::Label                         d_label;
+        bool                                  d_active;
+        std::string                           d_signature;
+        Counters                              d_counters;
+        size_t                                d_allocations = 0;
+        size_t                                d_allocated_bytes = 0;
+        std::chrono::steady_clock::time_point d_start;
+
+    public:
+        explicit Record(char const *name)
+        :
+            d_name(name),
+            d_label(name),
+            d_active(enabled())
+        {
+            if (d_active)
+                start();
+        }
+
+        ~Record()
+        {
+            if (d_active)
+                finish();
+        }
+
+        Record(Record const &) = delete;
+        Record &operator=(Record const &) = delete;
+
+        explicit operator bool() const
+        {
+            return d_active;
+        }
+
+        void describe(std::initializer_list<Dims> shapes, Counters const &counters);
+
+    private:
+        void start();
+        void finish();
+    };
+}
+
+#endif
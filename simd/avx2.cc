@@ -0,0 +1,401 @@
+// Compiled with -mavx2 -mfma (see Makefile), only reached after runtime detection.
+// Keep this file free of standard library headers so no AVX2 code leaks
+// into inline functions shared with other translation units.
+#include "simd.ih"
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+namespace autodiff::simd
+{
+    namespace
+    {
+        struct Add
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_add_pd(x, y); }
+            static __m256 apply(__m256 x, __m256 y) { return _mm256_add_ps(x, y); }
+            static double apply(double x, double y) { return x + y; }
+        };
+
+        struct Sub
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_sub_pd(x, y); }
+            static __m256 apply(__m256 x, __m256 y) { return _mm256_sub_ps(x, y); }
+            static double apply(double x, double y) { return x - y; }
+        };
+
+        struct Mul
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_mul_pd(x, y); }
+            static __m256 apply(__m256 x, __m256 y) { return _mm256_mul_ps(x, y); }
+            static double apply(double x, double y) { return x * y; }
+        };
+
+        struct Div
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_div_pd(x, y); }
+            static __m256 apply(__m256 x, __m256 y) { return _mm256_div_ps(x, y); }
+            static double apply(double x, double y) { return x / y; }
+        };
+
+        // _mm256_max_pd(x, y) is x > y ? x : y, matching ops::Max with NaNs
+        struct Max
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_max_pd(x, y); }
+            static double apply(double x, double y) { return x > y ? x : y; }
+        };
+
+        struct Min
+        {
+            static __m256d apply(__m256d x, __m256d y) { return _mm256_min_pd(x, y); }
+            static double apply(double x, double y) { return x < y ? x : y; }
+        };
+
+        size_t const width = 4;
+
+        template <typename Op>
+        void binary(double const *lhs, double const *rhs, double *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + 2 * width <= size; i += 2 * width)
+            {
+                __m256d r0 = Op::apply(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i));
+                __m256d r1 = Op::apply(_mm256_loadu_pd(lhs + i + width),
+                                       _mm256_loadu_pd(rhs + i + width));
+                _mm256_storeu_pd(res + i, r0);
+                _mm256_storeu_pd(res + i + width, r1);
+            }
+
+            for (; i < size; ++i)
+                res[i] = Op::apply(lhs[i], rhs[i]);
+        }
+
+        template <typename Op>
+        void binary_scalar(double const *lhs, double rhs, double *res, size_t size)
+        {
+            __m256d const value = _mm256_set1_pd(rhs);
+
+            size_t i = 0;
+            for (; i + 2 * width <= size; i += 2 * width)
+            {
+                __m256d r0 = Op::apply(_mm256_loadu_pd(lhs + i), value);
+                __m256d r1 = Op::apply(_mm256_loadu_pd(lhs + i + width), value);
+                _mm256_storeu_pd(res + i, r0);
+                _mm256_storeu_pd(res + i + width, r1);
+            }
+
+            for (; i < size; ++i)
+                res[i] = Op::apply(lhs[i], rhs);
+        }
+
+        // four independent accumulators hide the latency of the vector op
+        template <typename Op>
+        double fold(double const *x, size_t size, double init)
+        {
+            __m256d acc0 = _mm256_set1_pd(init);
+            __m256d acc1 = acc0;
+            __m256d acc2 = acc0;
+            __m256d acc3 = acc0;
+
+            size_t i = 0;
+            for (; i + 4 * width <= size; i += 4 * width)
+            {
+                acc0 = Op::apply(acc0, _mm256_loadu_pd(x + i));
+                acc1 = Op::apply(acc1, _mm256_loadu_pd(x + i + width));
+                acc2 = Op::apply(acc2, _mm256_loadu_pd(x + i + 2 * width));
+                acc3 = Op::apply(acc3, _mm256_loadu_pd(x + i + 3 * width));
+            }
+            for (; i + width <= size; i += width)
+                acc0 = Op::apply(acc0, _mm256_loadu_pd(x + i));
+
+            double lanes[width];
+            _mm256_storeu_pd(lanes, Op::apply(Op::apply(acc0, acc1), Op::apply(acc2, acc3)));
+            double acc = Op::apply(Op::apply(lanes[0], lanes[1]), Op::apply(lanes[2], lanes[3]));
+
+            for (; i < size; ++i)
+                acc = Op::apply(acc, x[i]);
+            return acc;
+        }
+
+        double reduce_sum(double const *x, size_t size)
+        {
+            return fold<Add>(x, size, 0.0);
+        }
+
+        template <typename Op>
+        double reduce(double const *x, size_t size)
+        {
+            return fold<Op>(x, size, x[0]);
+        }
+
+        void update_axpby(double alpha, double const *x, double beta, double *y, size_t size)
+        {
+            __m256d const a = _mm256_set1_pd(alpha);
+            __m256d const b = _mm256_set1_pd(beta);
+
+            size_t i = 0;
+            for (; i + width <= size; i += width)
+            {
+                __m256d r = _mm256_mul_pd(b, _mm256_loadu_pd(y + i));
+                _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), r));
+            }
+
+            for (; i < size; ++i)
+                y[i] = alpha * x[i] + beta * y[i];
+        }
+
+        void update_momentum(double const *grad, double *velocity, double *weights,
+                      double lr, double mu, size_t size)
+        {
+            __m256d const rate     = _mm256_set1_pd(-lr);
+            __m256d const friction = _mm256_set1_pd(mu);
+
+            size_t i = 0;
+            for (; i + width <= size; i += width)
+            {
+                __m256d vel = _mm256_fmadd_pd(friction, _mm256_loadu_pd(velocity + i),
+                                              _mm256_loadu_pd(grad + i));
+                _mm256_storeu_pd(velocity + i, vel);
+                _mm256_storeu_pd(weights + i,
+                                 _mm256_fmadd_pd(rate, vel, _mm256_loadu_pd(weights + i)));
+            }
+
+            for (; i < size; ++i)
+            {
+                velocity[i] = mu * velocity[i] + grad[i];
+                weights[i] -= lr * velocity[i];
+            }
+        }
+
+        void update_adam(double const *grad, double *m, double *v, double *weights,
+                  AdamStep const &step, size_t size)
+        {
+            __m256d const beta1 = _mm256_set1_pd(step.beta1);
+            __m256d const beta2 = _mm256_set1_pd(step.beta2);
+            __m256d const rest1 = _mm256_set1_pd(1 - step.beta1);
+            __m256d const rest2 = _mm256_set1_pd(1 - step.beta2);
+            __m256d const rate  = _mm256_set1_pd(step.step_size);
+            __m256d const scale = _mm256_set1_pd(step.bias2_rsqrt);
+            __m256d const eps   = _mm256_set1_pd(step.eps);
+
+            size_t i = 0;
+            for (; i + width <= size; i += width)
+            {
+                __m256d g  = _mm256_loadu_pd(grad + i);
+                __m256d mi = _mm256_fmadd_pd(beta1, _mm256_loadu_pd(m + i), _mm256_mul_pd(rest1, g));
+                __m256d vi = _mm256_fmadd_pd(beta2, _mm256_loadu_pd(v + i),
+                                             _mm256_mul_pd(rest2, _mm256_mul_pd(g, g)));
+                _mm256_storeu_pd(m + i, mi);
+                _mm256_storeu_pd(v + i, vi);
+
+                __m256d denom = _mm256_fmadd_pd(_mm256_sqrt_pd(vi), scale, eps);
+                __m256d delta = _mm256_div_pd(_mm256_mul_pd(rate, mi), denom);
+                _mm256_storeu_pd(weights + i, _mm256_sub_pd(_mm256_loadu_pd(weights + i), delta));
+            }
+
+            for (; i < size; ++i)
+            {
+                m[i] = step.beta1 * m[i] + (1 - step.beta1) * grad[i];
+                v[i] = step.beta2 * v[i] + (1 - step.beta2) * grad[i] * grad[i];
+                weights[i] -= step.step_size * m[i]
+                            / (__builtin_sqrt(v[i]) * step.bias2_rsqrt + step.eps);
+            }
+        }
+
+        size_t const width_f32 = 8;
+
+        template <typename Op>
+        void binary_f32(float const *lhs, float const *rhs, float *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + 2 * width_f32 <= size; i += 2 * width_f32)
+            {
+                __m256 r0 = Op::apply(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i));
+                __m256 r1 = Op::apply(_mm256_loadu_ps(lhs + i + width_f32),
+                                      _mm256_loadu_ps(rhs + i + width_f32));
+                _mm256_storeu_ps(res + i, r0);
+                _mm256_storeu_ps(res + i + width_f32, r1);
+            }
+
+            for (; i < size; ++i)
+                res[i] = static_cast<float>(Op::apply(lhs[i], rhs[i]));
+        }
+
+        float reduce_sum_f32(float const *x, size_t size)
+        {
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = acc0;
+            __m256 acc2 = acc0;
+            __m256 acc3 = acc0;
+
+            size_t i = 0;
+            for (; i + 4 * width_f32 <= size; i += 4 * width_f32)
+            {
+                acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + i));
+                acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(x + i + width_f32));
+                acc2 = _mm256_add_ps(acc2, _mm256_loadu_ps(x + i + 2 * width_f32));
+                acc3 = _mm256_add_ps(acc3, _mm256_loadu_ps(x + i + 3 * width_f32));
+            }
+            for (; i + width_f32 <= size; i += width_f32)
+                acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + i));
+
+            float lanes[width_f32];
+            _mm256_storeu_ps(lanes, _mm256_add_ps(_mm256_add_ps(acc0, acc1),
+                                                  _mm256_add_ps(acc2, acc3)));
+            float acc = lanes[0];
+            for (size_t lane = 1; lane < width_f32; ++lane)
+                acc += lanes[lane];
+
+            for (; i < size; ++i)
+                acc += x[i];
+            return acc;
+        }
+
+        void update_axpby_f32(float alpha, float const *x, float beta, float *y, size_t size)
+        {
+            __m256 const a = _mm256_set1_ps(alpha);
+            __m256 const b = _mm256_set1_ps(beta);
+
+            size_t i = 0;
+            for (; i + width_f32 <= size; i += width_f32)
+            {
+                __m256 r = _mm256_mul_ps(b, _mm256_loadu_ps(y + i));
+                _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), r));
+            }
+
+            for (; i < size; ++i)
+                y[i] = alpha * x[i] + beta * y[i];
+        }
+
+        // 6 x 8 tile: 12 accumulators plus 2 b vectors and one broadcast a
+        size_t const mr = 6;
+        size_t const nr = 8;
+
+        void gemm(size_t k, double const *a, double const *b, double *c, size_t ldc)
+        {
+            __m256d acc[mr][2];
+#pragma GCC unroll 6
+            for (size_t i = 0; i < mr; ++i)
+                acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr)
+            {
+                __m256d b0 = _mm256_loadu_pd(b);
+                __m256d b1 = _mm256_loadu_pd(b + width);
+#pragma GCC unroll 6
+                for (size_t i = 0; i < mr; ++i)
+                {
+                    __m256d ai = _mm256_broadcast_sd(a + i);
+                    acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+                }
+            }
+
+#pragma GCC unroll 6
+            for (size_t i = 0; i < mr; ++i)
+            {
+                double *row = c + i * ldc;
+                _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), acc[i][0]));
+                _mm256_storeu_pd(row + width,
+                                 _mm256_add_pd(_mm256_loadu_pd(row + width), acc[i][1]));
+            }
+        }
+    }
+
+    namespace
+    {
+        // 6 x 16 tile of floats, the same registers as the double tile
+        size_t const nr_f32 = 16;
+
+        void gemm_f32(size_t k, float const *a, float const *b, float *c, size_t ldc)
+        {
+            __m256 acc[mr][2];
+#pragma GCC unroll 6
+            for (size_t i = 0; i < mr; ++i)
+                acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr_f32)
+            {
+                __m256 b0 = _mm256_loadu_ps(b);
+                __m256 b1 = _mm256_loadu_ps(b + width_f32);
+#pragma GCC unroll 6
+                for (size_t i = 0; i < mr; ++i)
+                {
+                    __m256 ai = _mm256_broadcast_ss(a + i);
+                    acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+                }
+            }
+
+#pragma GCC unroll 6
+            for (size_t i = 0; i < mr; ++i)
+            {
+                float *row = c + i * ldc;
+                _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), acc[i][0]));
+                _mm256_storeu_ps(row + width_f32,
+                                 _mm256_add_ps(_mm256_loadu_ps(row + width_f32), acc[i][1]));
+            }
+        }
+    }
+
+    namespace
+    {
+        void widen_bf16(unsigned short const *x, float *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + width_f32 <= size; i += width_f32)
+            {
+                __m128i bits = _mm_loadu_si128(reinterpret_cast<__m128i const *>(x + i));
+                __m256i wide = _mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16);
+                _mm256_storeu_ps(res + i, _mm256_castsi256_ps(wide));
+            }
+
+            for (; i < size; ++i)
+                res[i] = bf16_value(x[i]);
+        }
+
+        // adds 0x7fff plus the lowest kept bit and keeps the upper half;
+        // nan lanes keep their upper half with the quiet bit set
+        void narrow_bf16(float const *x, unsigned short *res, size_t size)
+        {
+            __m256i const one  = _mm256_set1_epi32(1);
+            __m256i const bias = _mm256_set1_epi32(0x7fff);
+            __m256i const quiet_bit = _mm256_set1_epi32(0x40);
+
+            size_t i = 0;
+            for (; i + width_f32 <= size; i += width_f32)
+            {
+                __m256 value  = _mm256_loadu_ps(x + i);
+                __m256i bits  = _mm256_castps_si256(value);
+                __m256i upper = _mm256_srli_epi32(bits, 16);
+                __m256i round = _mm256_add_epi32(bias, _mm256_and_si256(upper, one));
+                __m256i out   = _mm256_srli_epi32(_mm256_add_epi32(bits, round), 16);
+                __m256 nan    = _mm256_cmp_ps(value, value, _CMP_UNORD_Q);
+                out = _mm256_blendv_epi8(out, _mm256_or_si256(upper, quiet_bit),
+                                         _mm256_castps_si256(nan));
+
+                __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(out),
+                                                  _mm256_extracti128_si256(out, 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(res + i), packed);
+            }
+
+            for (; i < size; ++i)
+                res[i] = bf16_bits(x[i]);
+        }
+    }
+
+    extern Kernels const avx2_kernels{
+        binary<Add>, binary<Sub>, binary<Mul>, binary<Div>, binary<Max>, binary<Min>,
+        binary_scalar<Add>, binary_scalar<Sub>, binary_scalar<Mul>,
+        binary_scalar<Div>, binary_scalar<Max>, binary_scalar<Min>,
+        reduce_sum, reduce<Max>, reduce<Min>,
+        update_axpby, update_momentum, update_adam,
+        binary_f32<Add>, binary_f32<Sub>, binary_f32<Mul>, binary_f32<Div>,
+        reduce_sum_f32, update_axpby_f32, {mr, nr_f32, gemm_f32},
+        widen_bf16, narrow_bf16,
+        {mr, nr, gemm},
+    };
+}
+
+#endif
@@ -0,0 +1,420 @@
+// Compiled with -mavx512f (see Makefile), only reached after runtime
+// detection. Keep this file free of standard library headers so no AVX-512
+// code leaks into inline functions shared with other translation units.
+#include "simd.ih"
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+namespace autodiff::simd
+{
+    namespace
+    {
+        struct Add
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_add_pd(x, y); }
+            static __m512 apply(__m512 x, __m512 y) { return _mm512_add_ps(x, y); }
+            static double apply(double x, double y) { return x + y; }
+        };
+
+        struct Sub
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_sub_pd(x, y); }
+            static __m512 apply(__m512 x, __m512 y) { return _mm512_sub_ps(x, y); }
+        };
+
+        struct Mul
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_mul_pd(x, y); }
+            static __m512 apply(__m512 x, __m512 y) { return _mm512_mul_ps(x, y); }
+        };
+
+        struct Div
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_div_pd(x, y); }
+            static __m512 apply(__m512 x, __m512 y) { return _mm512_div_ps(x, y); }
+        };
+
+        // max_pd(x, y) is x > y ? x : y, matching ops::Max with NaNs. The
+        // full-mask form avoids the undefined source in _mm512_max_pd, which
+        // trips -Wmaybe-uninitialized on GCC 12.
+        struct Max
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_mask_max_pd(x, 0xff, x, y); }
+            static double apply(double x, double y) { return x > y ? x : y; }
+        };
+
+        struct Min
+        {
+            static __m512d apply(__m512d x, __m512d y) { return _mm512_mask_min_pd(x, 0xff, x, y); }
+            static double apply(double x, double y) { return x < y ? x : y; }
+        };
+
+        size_t const width = 8;
+
+        __mmask8 tail_mask(size_t remaining)
+        {
+            return static_cast<__mmask8>((1u << remaining) - 1);
+        }
+
+        template <typename Op>
+        void binary(double const *lhs, double const *rhs, double *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + 2 * width <= size; i += 2 * width)
+            {
+                __m512d r0 = Op::apply(_mm512_loadu_pd(lhs + i), _mm512_loadu_pd(rhs + i));
+                __m512d r1 = Op::apply(_mm512_loadu_pd(lhs + i + width),
+                                       _mm512_loadu_pd(rhs + i + width));
+                _mm512_storeu_pd(res + i, r0);
+                _mm512_storeu_pd(res + i + width, r1);
+            }
+
+            // masked tail, the inactive lanes are loaded as 1 so div stays quiet
+            for (; i < size; i += width)
+            {
+                __mmask8 mask = size - i >= width ? 0xff : tail_mask(size - i);
+                __m512d one   = _mm512_set1_pd(1.0);
+                __m512d r     = Op::apply(_mm512_mask_loadu_pd(one, mask, lhs + i),
+                                          _mm512_mask_loadu_pd(one, mask, rhs + i));
+                _mm512_mask_storeu_pd(res + i, mask, r);
+            }
+        }
+
+        template <typename Op>
+        void binary_scalar(double const *lhs, double rhs, double *res, size_t size)
+        {
+            __m512d const value = _mm512_set1_pd(rhs);
+
+            size_t i = 0;
+            for (; i + 2 * width <= size; i += 2 * width)
+            {
+                __m512d r0 = Op::apply(_mm512_loadu_pd(lhs + i), value);
+                __m512d r1 = Op::apply(_mm512_loadu_pd(lhs + i + width), value);
+                _mm512_storeu_pd(res + i, r0);
+                _mm512_storeu_pd(res + i + width, r1);
+            }
+
+            for (; i < size; i += width)
+            {
+                __mmask8 mask = size - i >= width ? 0xff : tail_mask(size - i);
+                __m512d r     = Op::apply(_mm512_mask_loadu_pd(_mm512_set1_pd(1.0), mask, lhs + i),
+                                          value);
+                _mm512_mask_storeu_pd(res + i, mask, r);
+            }
+        }
+
+        // four independent accumulators hide the latency of the vector op;
+        // the tail is folded in serially, as by the other kernels
+        template <typename Op>
+        double fold(double const *x, size_t size, double init)
+        {
+            __m512d acc0 = _mm512_set1_pd(init);
+            __m512d acc1 = acc0;
+            __m512d acc2 = acc0;
+            __m512d acc3 = acc0;
+
+            size_t i = 0;
+            for (; i + 4 * width <= size; i += 4 * width)
+            {
+                acc0 = Op::apply(acc0, _mm512_loadu_pd(x + i));
+                acc1 = Op::apply(acc1, _mm512_loadu_pd(x + i + width));
+                acc2 = Op::apply(acc2, _mm512_loadu_pd(x + i + 2 * width));
+                acc3 = Op::apply(acc3, _mm512_loadu_pd(x + i + 3 * width));
+            }
+            for (; i + width <= size; i += width)
+                acc0 = Op::apply(acc0, _mm512_loadu_pd(x + i));
+
+            double lanes[width];
+            _mm512_storeu_pd(lanes, Op::apply(Op::apply(acc0, acc1), Op::apply(acc2, acc3)));
+            double acc = lanes[0];
+            for (size_t lane = 1; lane < width; ++lane)
+                acc = Op::apply(acc, lanes[lane]);
+
+            for (; i < size; ++i)
+                acc = Op::apply(acc, x[i]);
+            return acc;
+        }
+
+        double reduce_sum(double const *x, size_t size)
+        {
+            return fold<Add>(x, size, 0.0);
+        }
+
+        template <typename Op>
+        double reduce(double const *x, size_t size)
+        {
+            return fold<Op>(x, size, x[0]);
+        }
+
+        // The updates below run their tail with masked loads; inactive lanes
+        // read as 0, which keeps sqrt and the eps-guarded division quiet.
+        void update_axpby(double alpha, double const *x, double beta, double *y, size_t size)
+        {
+            __m512d const a = _mm512_set1_pd(alpha);
+            __m512d const b = _mm512_set1_pd(beta);
+
+            for (size_t i = 0; i < size; i += width)
+            {
+                __mmask8 mask = size - i >= width ? 0xff : tail_mask(size - i);
+                __m512d r = _mm512_mul_pd(b, _mm512_maskz_loadu_pd(mask, y + i));
+                r = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), r);
+                _mm512_mask_storeu_pd(y + i, mask, r);
+            }
+        }
+
+        void update_momentum(double const *grad, double *velocity, double *weights,
+                      double lr, double mu, size_t size)
+        {
+            __m512d const rate     = _mm512_set1_pd(-lr);
+            __m512d const friction = _mm512_set1_pd(mu);
+
+            for (size_t i = 0; i < size; i += width)
+            {
+                __mmask8 mask = size - i >= width ? 0xff : tail_mask(size - i);
+                __m512d vel = _mm512_fmadd_pd(friction, _mm512_maskz_loadu_pd(mask, velocity + i),
+                                              _mm512_maskz_loadu_pd(mask, grad + i));
+                _mm512_mask_storeu_pd(velocity + i, mask, vel);
+                _mm512_mask_storeu_pd(weights + i, mask,
+                    _mm512_fmadd_pd(rate, vel, _mm512_maskz_loadu_pd(mask, weights + i)));
+            }
+        }
+
+        void update_adam(double const *grad, double *m, double *v, double *weights,
+                  AdamStep const &step, size_t size)
+        {
+            __m512d const beta1 = _mm512_set1_pd(step.beta1);
+            __m512d const beta2 = _mm512_set1_pd(step.beta2);
+            __m512d const rest1 = _mm512_set1_pd(1 - step.beta1);
+            __m512d const rest2 = _mm512_set1_pd(1 - step.beta2);
+            __m512d const rate  = _mm512_set1_pd(step.step_size);
+            __m512d const scale = _mm512_set1_pd(step.bias2_rsqrt);
+            __m512d const eps   = _mm512_set1_pd(step.eps);
+
+            for (size_t i = 0; i < size; i += width)
+            {
+                __mmask8 mask = size - i >= width ? 0xff : tail_mask(size - i);
+                __m512d g  = _mm512_maskz_loadu_pd(mask, grad + i);
+                __m512d mi = _mm512_fmadd_pd(beta1, _mm512_maskz_loadu_pd(mask, m + i),
+                                             _mm512_mul_pd(rest1, g));
+                __m512d vi = _mm512_fmadd_pd(beta2, _mm512_maskz_loadu_pd(mask, v + i),
+                                             _mm512_mul_pd(rest2, _mm512_mul_pd(g, g)));
+                _mm512_mask_storeu_pd(m + i, mask, mi);
+                _mm512_mask_storeu_pd(v + i, mask, vi);
+
+                __m512d root  = _mm512_mask_sqrt_pd(vi, 0xff, vi);    // see Max
+                __m512d denom = _mm512_fmadd_pd(root, scale, eps);
+                __m512d delta = _mm512_div_pd(_mm512_mul_pd(rate, mi), denom);
+                _mm512_mask_storeu_pd(weights + i, mask,
+                    _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, weights + i), delta));
+            }
+        }
+
+        size_t const width_f32 = 16;
+
+        __mmask16 tail_mask_f32(size_t remaining)
+        {
+            return static_cast<__mmask16>((1u << remaining) - 1);
+        }
+
+        template <typename Op>
+        void binary_f32(float const *lhs, float const *rhs, float *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + 2 * width_f32 <= size; i += 2 * width_f32)
+            {
+                __m512 r0 = Op::apply(_mm512_loadu_ps(lhs + i), _mm512_loadu_ps(rhs + i));
+                __m512 r1 = Op::apply(_mm512_loadu_ps(lhs + i + width_f32),
+                                      _mm512_loadu_ps(rhs + i + width_f32));
+                _mm512_storeu_ps(res + i, r0);
+                _mm512_storeu_ps(res + i + width_f32, r1);
+            }
+
+            // masked tail, the inactive lanes are loaded as 1 so div stays quiet
+            for (; i < size; i += width_f32)
+            {
+                __mmask16 mask = size - i >= width_f32 ? 0xffff : tail_mask_f32(size - i);
+                __m512 one     = _mm512_set1_ps(1.0f);
+                __m512 r       = Op::apply(_mm512_mask_loadu_ps(one, mask, lhs + i),
+                                           _mm512_mask_loadu_ps(one, mask, rhs + i));
+                _mm512_mask_storeu_ps(res + i, mask, r);
+            }
+        }
+
+        float reduce_sum_f32(float const *x, size_t size)
+        {
+            __m512 acc0 = _mm512_setzero_ps();
+            __m512 acc1 = acc0;
+            __m512 acc2 = acc0;
+            __m512 acc3 = acc0;
+
+            size_t i = 0;
+            for (; i + 4 * width_f32 <= size; i += 4 * width_f32)
+            {
+                acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(x + i));
+                acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(x + i + width_f32));
+                acc2 = _mm512_add_ps(acc2, _mm512_loadu_ps(x + i + 2 * width_f32));
+                acc3 = _mm512_add_ps(acc3, _mm512_loadu_ps(x + i + 3 * width_f32));
+            }
+            for (; i + width_f32 <= size; i += width_f32)
+                acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(x + i));
+
+            float lanes[width_f32];
+            _mm512_storeu_ps(lanes, _mm512_add_ps(_mm512_add_ps(acc0, acc1),
+                                                  _mm512_add_ps(acc2, acc3)));
+            float acc = lanes[0];
+            for (size_t lane = 1; lane < width_f32; ++lane)
+                acc += lanes[lane];
+
+            for (; i < size; ++i)
+                acc += x[i];
+            return acc;
+        }
+
+        void update_axpby_f32(float alpha, float const *x, float beta, float *y, size_t size)
+        {
+            __m512 const a = _mm512_set1_ps(alpha);
+            __m512 const b = _mm512_set1_ps(beta);
+
+            for (size_t i = 0; i < size; i += width_f32)
+            {
+                __mmask16 mask = size - i >= width_f32 ? 0xffff : tail_mask_f32(size - i);
+                __m512 r = _mm512_mul_ps(b, _mm512_maskz_loadu_ps(mask, y + i));
+                r = _mm512_fmadd_ps(a, _mm512_maskz_loadu_ps(mask, x + i), r);
+                _mm512_mask_storeu_ps(y + i, mask, r);
+            }
+        }
+
+        // 8 x 16 tile: 16 accumulators plus 2 b vectors and one broadcast a
+        size_t const mr = 8;
+        size_t const nr = 16;
+
+        void gemm(size_t k, double const *a, double const *b, double *c, size_t ldc)
+        {
+            __m512d acc[mr][2];
+#pragma GCC unroll 8
+            for (size_t i = 0; i < mr; ++i)
+                acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr)
+            {
+                __m512d b0 = _mm512_loadu_pd(b);
+                __m512d b1 = _mm512_loadu_pd(b + width);
+#pragma GCC unroll 8
+                for (size_t i = 0; i < mr; ++i)
+                {
+                    __m512d ai = _mm512_set1_pd(a[i]);
+                    acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+                }
+            }
+
+#pragma GCC unroll 8
+            for (size_t i = 0; i < mr; ++i)
+            {
+                double *row = c + i * ldc;
+                _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), acc[i][0]));
+                _mm512_storeu_pd(row + width,
+                                 _mm512_add_pd(_mm512_loadu_pd(row + width), acc[i][1]));
+            }
+        }
+    }
+
+    namespace
+    {
+        // 8 x 32 tile of floats, the same registers as the double tile
+        size_t const nr_f32 = 32;
+
+        void gemm_f32(size_t k, float const *a, float const *b, float *c, size_t ldc)
+        {
+            __m512 acc[mr][2];
+#pragma GCC unroll 8
+            for (size_t i = 0; i < mr; ++i)
+                acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr_f32)
+            {
+                __m512 b0 = _mm512_loadu_ps(b);
+                __m512 b1 = _mm512_loadu_ps(b + width_f32);
+#pragma GCC unroll 8
+                for (size_t i = 0; i < mr; ++i)
+                {
+                    __m512 ai = _mm512_set1_ps(a[i]);
+                    acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+                    acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+                }
+            }
+
+#pragma GCC unroll 8
+            for (size_t i = 0; i < mr; ++i)
+            {
+                float *row = c + i * ldc;
+                _mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), acc[i][0]));
+                _mm512_storeu_ps(row + width_f32,
+                                 _mm512_add_ps(_mm512_loadu_ps(row + width_f32), acc[i][1]));
+            }
+        }
+    }
+
+    namespace
+    {
+        // the zero-masked forms avoid the undefined sources that trip
+        // -Wmaybe-uninitialized (see Max)
+        void widen_bf16(unsigned short const *x, float *res, size_t size)
+        {
+            size_t i = 0;
+            for (; i + width_f32 <= size; i += width_f32)
+            {
+                __m256i bits = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(x + i));
+                __m512i wide = _mm512_maskz_cvtepu16_epi32(0xffff, bits);
+                wide = _mm512_maskz_slli_epi32(0xffff, wide, 16);
+                _mm512_storeu_ps(res + i, _mm512_castsi512_ps(wide));
+            }
+
+            for (; i < size; ++i)
+                res[i] = bf16_value(x[i]);
+        }
+
+        // see the AVX2 kernel
+        void narrow_bf16(float const *x, unsigned short *res, size_t size)
+        {
+            __m512i const one  = _mm512_set1_epi32(1);
+            __m512i const bias = _mm512_set1_epi32(0x7fff);
+            __m512i const quiet_bit = _mm512_set1_epi32(0x40);
+
+            size_t i = 0;
+            for (; i + width_f32 <= size; i += width_f32)
+            {
+                __m512 value  = _mm512_loadu_ps(x + i);
+                __m512i bits  = _mm512_castps_si512(value);
+                __m512i upper = _mm512_maskz_srli_epi32(0xffff, bits, 16);
+                __m512i round = _mm512_add_epi32(bias, _mm512_and_si512(upper, one));
+                __m512i out   = _mm512_add_epi32(bits, round);
+                out = _mm512_maskz_srli_epi32(0xffff, out, 16);
+                __mmask16 nan = _mm512_cmp_ps_mask(value, value, _CMP_UNORD_Q);
+                out = _mm512_mask_blend_epi32(nan, out, _mm512_or_si512(upper, quiet_bit));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(res + i),
+                                    _mm512_maskz_cvtepi32_epi16(0xffff, out));
+            }
+
+            for (; i < size; ++i)
+                res[i] = bf16_bits(x[i]);
+        }
+    }
+
+    extern Kernels const avx512_kernels{
+        binary<Add>, binary<Sub>, binary<Mul>, binary<Div>, binary<Max>, binary<Min>,
+        binary_scalar<Add>, binary_scalar<Sub>, binary_scalar<Mul>,
+        binary_scalar<Div>, binary_scalar<Max>, binary_scalar<Min>,
+        reduce_sum, reduce<Max>, reduce<Min>,
+        update_axpby, update_momentum, update_adam,
+        binary_f32<Add>, binary_f32<Sub>, binary_f32<Mul>, binary_f32<Div>,
+        reduce_sum_f32, update_axpby_f32, {mr, nr_f32, gemm_f32},
+        widen_bf16, narrow_bf16,
+        {mr, nr, gemm},
+    };
+}
+
+#endif
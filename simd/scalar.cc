@@ -0,0 +1,157 @@
+#include "simd.ih"
+
+#include <cmath>
+
+namespace autodiff::simd
+{
+    namespace
+    {
+        struct Add { static double apply(double x, double y) { return x + y; } };
+        struct Sub { static double apply(double x, double y) { return x - y; } };
+        struct Mul { static double apply(double x, double y) { return x * y; } };
+        struct Div { static double apply(double x, double y) { return x / y; } };
+        struct Max { static double apply(double x, double y) { return x > y ? x : y; } };
+        struct Min { static double apply(double x, double y) { return x < y ? x : y; } };
+
+        template <typename Op>
+        void binary(double const *lhs, double const *rhs, double *res, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                res[i] = Op::apply(lhs[i], rhs[i]);
+        }
+
+        template <typename Op>
+        void binary_scalar(double const *lhs, double rhs, double *res, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                res[i] = Op::apply(lhs[i], rhs);
+        }
+
+        double reduce_sum(double const *x, size_t size)
+        {
+            double acc = 0;
+            for (size_t i = 0; i < size; ++i)
+                acc += x[i];
+            return acc;
+        }
+
+        template <typename Op>
+        double reduce(double const *x, size_t size)
+        {
+            double acc = x[0];
+            for (size_t i = 1; i < size; ++i)
+                acc = Op::apply(acc, x[i]);
+            return acc;
+        }
+
+        void update_axpby(double alpha, double const *x, double beta, double *y, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                y[i] = alpha * x[i] + beta * y[i];
+        }
+
+        void update_momentum(double const *grad, double *velocity, double *weights,
+                      double lr, double mu, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                velocity[i] = mu * velocity[i] + grad[i];
+                weights[i] -= lr * velocity[i];
+            }
+        }
+
+        void update_adam(double const *grad, double *m, double *v, double *weights,
+                  AdamStep const &step, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                m[i] = step.beta1 * m[i] + (1 - step.beta1) * grad[i];
+                v[i] = step.beta2 * v[i] + (1 - step.beta2) * grad[i] * grad[i];
+                weights[i] -= step.step_size * m[i]
+                            / (std::sqrt(v[i]) * step.bias2_rsqrt + step.eps);
+            }
+        }
+
+        template <typename Op>
+        void binary_f32(float const *lhs, float const *rhs, float *res, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                res[i] = static_cast<float>(Op::apply(lhs[i], rhs[i]));
+        }
+
+        float reduce_sum_f32(float const *x, size_t size)
+        {
+            float acc = 0;
+            for (size_t i = 0; i < size; ++i)
+                acc += x[i];
+            return acc;
+        }
+
+        void update_axpby_f32(float alpha, float const *x, float beta, float *y, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                y[i] = alpha * x[i] + beta * y[i];
+        }
+
+        size_t const mr = 4;
+        size_t const nr = 4;
+
+        void gemm(size_t k, double const *a, double const *b, double *c, size_t ldc)
+        {
+            double acc[mr][nr] = {};
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr)
+                for (size_t i = 0; i < mr; ++i)
+                    for (size_t j = 0; j < nr; ++j)
+                        acc[i][j] += a[i] * b[j];
+
+            for (size_t i = 0; i < mr; ++i)
+                for (size_t j = 0; j < nr; ++j)
+                    c[i * ldc + j] += acc[i][j];
+        }
+    }
+
+    namespace
+    {
+        void gemm_f32(size_t k, float const *a, float const *b, float *c, size_t ldc)
+        {
+            float acc[mr][nr] = {};
+
+            for (size_t p = 0; p < k; ++p, a += mr, b += nr)
+                for (size_t i = 0; i < mr; ++i)
+                    for (size_t j = 0; j < nr; ++j)
+                        acc[i][j] += a[i] * b[j];
+
+            for (size_t i = 0; i < mr; ++i)
+                for (size_t j = 0; j < nr; ++j)
+                    c[i * ldc + j] += acc[i][j];
+        }
+    }
+
+    namespace
+    {
+        void widen_bf16(unsigned short const *x, float *res, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                res[i] = bf16_value(x[i]);
+        }
+
+        void narrow_bf16(float const *x, unsigned short *res, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+                res[i] = bf16_bits(x[i]);
+        }
+    }
+
+    extern Kernels const scalar_kernels{
+        binary<Add>, binary<Sub>, binary<Mul>, binary<Div>, binary<Max>, binary<Min>,
+        binary_scalar<Add>, binary_scalar<Sub>, binary_scalar<Mul>,
+        binary_scalar<Div>, binary_scalar<Max>, binary_scalar<Min>,
+        reduce_sum, reduce<Max>, reduce<Min>,
+        update_axpby, update_momentum, update_adam,
+        binary_f32<Add>, binary_f32<Sub>, binary_f32<Mul>, binary_f32<Div>,
+        reduce_sum_f32, update_axpby_f32, {mr, nr, gemm_f32},
+        widen_bf16, narrow_bf16,
+        {mr, nr, gemm},
+    };
+}
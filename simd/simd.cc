@@ -0,0 +1,200 @@
+#include "simd.ih"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace autodiff::simd
+{
+    namespace
+    {
+        Kernels const &kernels_for(Isa isa)
+        {
+            switch (isa)
+            {
+#if defined(__x86_64__)
+                case Isa::Avx512:   return avx512_kernels;
+                case Isa::Avx2:     return avx2_kernels;
+#endif
+                default:            return scalar_kernels;
+            }
+        }
+
+        atomic<Isa> &active_isa()
+        {
+            static atomic<Isa> active{detected_isa()};
+            return active;
+        }
+
+        Kernels const &kernels()
+        {
+            return kernels_for(active_isa().load(memory_order_relaxed));
+        }
+    }
+
+    Isa detected_isa()
+    {
+#if defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            return Isa::Avx512;
+        if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma"))
+            return Isa::Avx2;
+#endif
+        return Isa::Scalar;
+    }
+
+    Isa isa()
+    {
+        return active_isa().load(memory_order_relaxed);
+    }
+
+    void use_isa(Isa isa)
+    {
+        if (isa > detected_isa())
+            throw invalid_argument("instruction set not supported by this host");
+
+        active_isa().store(isa, memory_order_relaxed);
+    }
+
+    void add(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().add(lhs, rhs, res, size);
+    }
+
+    void sub(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().sub(lhs, rhs, res, size);
+    }
+
+    void mul(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().mul(lhs, rhs, res, size);
+    }
+
+    void div(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().div(lhs, rhs, res, size);
+    }
+
+    void max(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().max(lhs, rhs, res, size);
+    }
+
+    void min(double const *lhs, double const *rhs, double *res, size_t size)
+    {
+        kernels().min(lhs, rhs, res, size);
+    }
+
+    void add(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().add_scalar(lhs, rhs, res, size);
+    }
+
+    void sub(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().sub_scalar(lhs, rhs, res, size);
+    }
+
+    void mul(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().mul_scalar(lhs, rhs, res, size);
+    }
+
+    void div(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().div_scalar(lhs, rhs, res, size);
+    }
+
+    void max(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().max_scalar(lhs, rhs, res, size);
+    }
+
+    void min(double const *lhs, double rhs, double *res, size_t size)
+    {
+        kernels().min_scalar(lhs, rhs, res, size);
+    }
+
+    double sum(double const *x, size_t size)
+    {
+        return kernels().sum(x, size);
+    }
+
+    double max(double const *x, size_t size)
+    {
+        return kernels().reduce_max(x, size);
+    }
+
+    double min(double const *x, size_t size)
+    {
+        return kernels().reduce_min(x, size);
+    }
+
+    void axpby(double alpha, double const *x, double beta, double *y, size_t size)
+    {
+        kernels().axpby(alpha, x, beta, y, size);
+    }
+
+    void momentum(double const *grad, double *velocity, double *weights,
+                  double lr, double mu, size_t size)
+    {
+        kernels().momentum(grad, velocity, weights, lr, mu, size);
+    }
+
+    void adam(double const *grad, double *m, double *v, double *weights,
+              AdamStep const &step, size_t size)
+    {
+        kernels().adam(grad, m, v, weights, step, size);
+    }
+
+    void add(float const *lhs, float const *rhs, float *res, size_t size)
+    {
+        kernels().add_f32(lhs, rhs, res, size);
+    }
+
+    void sub(float const *lhs, float const *rhs, float *res, size_t size)
+    {
+        kernels().sub_f32(lhs, rhs, res, size);
+    }
+
+    void mul(float const *lhs, float const *rhs, float *res, size_t size)
+    {
+        kernels().mul_f32(lhs, rhs, res, size);
+    }
+
+    void div(float const *lhs, float const *rhs, float *res, size_t size)
+    {
+        kernels().div_f32(lhs, rhs, res, size);
+    }
+
+    float sum(float const *x, size_t size)
+    {
+        return kernels().sum_f32(x, size);
+    }
+
+    void axpby(float alpha, float const *x, float beta, float *y, size_t size)
+    {
+        kernels().axpby_f32(alpha, x, beta, y, size);
+    }
+
+    void bf16_to_f32(uint16_t const *x, float *res, size_t size)
+    {
+        kernels().widen_bf16(x, res, size);
+    }
+
+    void f32_to_bf16(float const *x, uint16_t *res, size_t size)
+    {
+        kernels().narrow_bf16(x, res, size);
+    }
+
+    GemmKernel gemm_kernel()
+    {
+        return kernels().gemm;
+    }
+
+    GemmKernelF32 gemm_kernel_f32()
+    {
+        return kernels().gemm_f32;
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef INCLUDED_SIMD
+#define INCLUDED_SIMD
+
+#include <cstddef>
+#include <cstdint>
+
+namespace autodiff::simd
+{
+    // Instruction sets with hand-written kernels, ordered by width.
+    enum class Isa
+    {
+        Scalar,
+        Avx2,
+        Avx512,
+    };
+
+    Isa detected_isa();             // widest ISA supported by this host
+    Isa isa();                      // ISA currently dispatched to
+    void use_isa(Isa isa);          // throws if not supported by this host
+
+    // res[i] = lhs[i] op rhs[i], res may alias lhs or rhs
+    void add(double const *lhs, double const *rhs, double *res, size_t size);
+    void sub(double const *lhs, double const *rhs, double *res, size_t size);
+    void mul(double const *lhs, double const *rhs, double *res, size_t size);
+    void div(double const *lhs, double const *rhs, double *res, size_t size);
+    void max(double const *lhs, double const *rhs, double *res, size_t size);
+    void min(double const *lhs, double const *rhs, double *res, size_t size);
+
+    // res[i] = lhs[i] op rhs, res may alias lhs
+    void add(double const *lhs, double rhs, double *res, size_t size);
+    void sub(double const *lhs, double rhs, double *res, size_t size);
+    void mul(double const *lhs, double rhs, double *res, size_t size);
+    void div(double const *lhs, double rhs, double *res, size_t size);
+    void max(double const *lhs, double rhs, double *res, size_t size);
+    void min(double const *lhs, double rhs, double *res, size_t size);
+
+    // Reductions of x[0, size) in lane-parallel partials, so the order of
+    // the additions differs from a serial loop. max and min need size > 0.
+    double sum(double const *x, size_t size);
+    double max(double const *x, size_t size);
+    double min(double const *x, size_t size);
+
+    // y[i] = alpha * x[i] + beta * y[i]
+    void axpby(double alpha, double const *x, double beta, double *y, size_t size);
+
+    // SGD with momentum: velocity = mu * velocity + grad, then
+    // weights -= lr * velocity
+    void momentum(double const *grad, double *velocity, double *weights,
+                  double lr, double mu, size_t size);
+
+    // Adam moments and update. Bias correction is folded in by the caller:
+    // step_size = lr / (1 - beta1^t) and bias2_rsqrt = 1 / sqrt(1 - beta2^t),
+    // so weights -= step_size * m / (sqrt(v) * bias2_rsqrt + eps).
+    struct AdamStep
+    {
+        double step_size;
+        double beta1;
+        double beta2;
+        double eps;
+        double bias2_rsqrt;
+    };
+
+    void adam(double const *grad, double *m, double *v, double *weights,
+              AdamStep const &step, size_t size);
+
+    // float32 forms of the above, twice as many lanes per vector
+    void add(float const *lhs, float const *rhs, float *res, size_t size);
+    void sub(float const *lhs, float const *rhs, float *res, size_t size);
+    void mul(float const *lhs, float const *rhs, float *res, size_t size);
+    void div(float const *lhs, float const *rhs, float *res, size_t size);
+    float sum(float const *x, size_t size);
+    void axpby(float alpha, float const *x, float beta, float *y, size_t size);
+
+    // bfloat16 bit patterns to float and back, rounding to nearest even
+    void bf16_to_f32(std::uint16_t const *x, float *res, size_t size);
+    void f32_to_bf16(float const *x, std::uint16_t *res, size_t size);
+
+    // GEMM micro-kernel: c[mr x nr] += a * b over k, with a packed as k
+    // columns of mr values, b as k rows of nr values and c row-major with
+    // row stride ldc. The tile shape depends on the ISA and element type.
+    template <typename T>
+    struct BasicGemmKernel
+    {
+        size_t mr;
+        size_t nr;
+        void (*run)(size_t k, T const *a, T const *b, T *c, size_t ldc);
+    };
+
+    using GemmKernel    = BasicGemmKernel<double>;
+    using GemmKernelF32 = BasicGemmKernel<float>;
+
+    GemmKernel    gemm_kernel();
+    GemmKernelF32 gemm_kernel_f32();
+}
+
+#endif
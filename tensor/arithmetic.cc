@@ -4,107 +4,163 @@ namespace autodiff
 {
     namespace
     {
+        using expr::sum_block;
 
-    }
+        // dst[i] = src[i] op num over the pool, dst may alias src
+        template <typename Op>
+        void apply_scalar(double const *src, double num, double *dst, size_t size)
+        {
+            parallel::parallel_for(0, size, parallel::grain_size(size),
+                [src, num, dst](size_t first, size_t last) {
+                    Op::run(src + first, num, dst + first, last - first);
+                });
+        }
 
-    Tensor operator+(Tensor const &lhs, Tensor const &rhs)
-    {
-        return operation(lhs, rhs, [](double x, double y) { return x + y; });
+        // out[i * step] = out[i * step] op num for i < length
+        template <typename Op>
+        void apply_scalar_run(double *out, double num, size_t length, size_t step)
+        {
+            if (step == 1)
+                return Op::run(out, num, out, length);
+
+            Op op;
+            for (size_t i = 0; i < length; ++i)
+                out[i * step] = op(out[i * step], num);
+        }
+
+        // lhs = lhs op rhs, written through lhs's buffer and strides so views
+        // update their parent; rhs must broadcast into the shape of lhs
+        template <typename Op>
+        void apply_inplace(Tensor &lhs, Tensor const &rhs)
+        {
+            profile::Record record{"compound"};
+            if (record)
+                record.describe({lhs.shape(), rhs.shape()}, {
+                    .elements      = lhs.size(),
+                    .flops         = lhs.size(),
+                    .bytes_read    = (lhs.size() + rhs.size()) * sizeof(double),
+                    .bytes_written = lhs.size() * sizeof(double),
+                });
+
+            BroadcastPlan plan = prepare_broadcast(lhs, rhs);
+            if (plan.res_shape != lhs.shape())
+                throw invalid_argument("rhs cannot be broadcast into lhs");
+            expr::check_writable(lhs);
+
+            // an rhs that partially overlaps lhs would be read after it is
+            // written, so it is read from a copy; exact aliases are safe
+            if (expr::partially_overlaps(rhs, lhs))
+            {
+                Tensor copy{rhs.shape(), uninitialized};
+                copy_elements(rhs, copy);
+                return apply_inplace<Op>(lhs, copy);
+            }
+
+            BroadcastIterator const iter{plan.res_shape, plan.lhs_strides,
+                                         plan.lhs_strides, plan.rhs_strides};
+
+            Op op;
+            detail::apply_broadcast(iter, op, lhs.data(), lhs.data(), rhs.data());
+        }
+
+        // lhs = lhs op num for contiguous tensors, through strides otherwise
+        template <typename Op>
+        void apply_scalar(Tensor &lhs, double num)
+        {
+            profile::Record record{"compound scalar"};
+            if (record)
+                record.describe({lhs.shape()}, {
+                    .elements      = lhs.size(),
+                    .flops         = lhs.size(),
+                    .bytes_read    = lhs.size() * sizeof(double),
+                    .bytes_written = lhs.size() * sizeof(double),
+                });
+
+            expr::check_writable(lhs);
+            if (lhs.is_contiguous())
+                return apply_scalar<Op>(lhs.data(), num, lhs.data(), lhs.size());
+
+            // views run the scalar kernel over each of their inner runs,
+            // split as in detail::apply_broadcast
+            BroadcastIterator const iter{lhs.shape(), lhs.strides(), lhs.strides(),
+                                         Dims(lhs.rank())};
+            double *data        = lhs.data();
+            size_t const length = iter.length();
+            size_t const step   = iter.lhs_step();
+
+            if (iter.runs() == 1)
+                parallel::parallel_for(0, length, parallel::grain_size(length),
+                    [&](size_t first, size_t last) {
+                        apply_scalar_run<Op>(data + iter.lhs() + first * step, num,
+                                             last - first, step);
+                    });
+            else
+                parallel::parallel_for(0, iter.runs(), parallel::grain_size(iter.runs(), length),
+                    [&](size_t first, size_t last) {
+                        BroadcastIterator chunk = iter;
+                        chunk.seek(first);
+
+                        for (size_t run = first; run < last; ++run, chunk.next())
+                            apply_scalar_run<Op>(data + chunk.lhs(), num, length, step);
+                    });
+        }
     }
 
     Tensor &Tensor::operator+=(Tensor const &rhs)
     {
-        Tensor res = *this + rhs;
-        // @todo: might implement custom swap
-        swap(*this, res);
+        apply_inplace<ops::Add>(*this, rhs);
         return *this;
     }
 
-    Tensor operator-(Tensor const &lhs, Tensor const &rhs)
-    {
-        return operation(lhs, rhs, [](double x, double y) { return x - y; });
-    }
-
     Tensor &Tensor::operator-=(Tensor const &rhs)
     {
-        Tensor res = *this - rhs;
-        swap(*this, res);
+        apply_inplace<ops::Sub>(*this, rhs);
         return *this;
     }
 
-    Tensor operator*(Tensor const &lhs, Tensor const &rhs)
-    {
-        return operation(lhs, rhs, [](double x, double y) { return x * y; });
-    }
-
     Tensor &Tensor::operator*=(Tensor const &rhs)
     {
-        Tensor res = *this - rhs;
-        swap(*this, res);
+        apply_inplace<ops::Mul>(*this, rhs);
         return *this;
     }
 
-    Tensor operator/(Tensor const &lhs, Tensor const &rhs)
-    {
-        return operation(lhs, rhs, [](double x, double y) { return x / y; });
-    }
-
     Tensor &Tensor::operator/=(Tensor const &rhs)
     {
-        Tensor res = *this - rhs;
-        swap(*this, res);
+        apply_inplace<ops::Div>(*this, rhs);
         return *this;
     }
 
     Tensor &Tensor::operator+=(double num)
     {
-        for_each(begin(), end(), [num](double &val) {
-            val += num;
-        });
+        apply_scalar<ops::Add>(*this, num);
 
         return *this;
     }
 
     Tensor &Tensor::operator-=(double num)
     {
-        for_each(begin(), end(), [num](double &val) {
-            val -= num;
-        });
+        apply_scalar<ops::Sub>(*this, num);
 
         return *this;
     }
 
     Tensor &Tensor::operator*=(double num)
     {
-        for_each(begin(), end(), [num](double &val) {
-            val *= num;
-        });
+        apply_scalar<ops::Mul>(*this, num);
 
         return *this;
     }
 
     Tensor &Tensor::operator/=(double num)
     {
-        for_each(begin(), end(), [num](double &val) {
-            val /= num;
-        });
+        apply_scalar<ops::Div>(*this, num);
 
         return *this;
     }
 
-    Tensor operator*(Tensor const &t, double num)
-    {
-        vector<double> res(t.size());
-        size_t ix = 0;
-        for_each(t.cbegin(), t.cend(), [&ix, &res, num](double val) {
-            res[ix++] = val * num;
-        });
-
-        return Tensor{t.shape(), std::move(res)};
-    }
-
     Tensor &Tensor::power(double num)
     {
+        expr::check_writable(*this);
         for_each(begin(), end(), [num](double &val) {
             val = std::pow(val, num);
         });
@@ -114,7 +170,33 @@ namespace autodiff
 
     double Tensor::sum() const
     {
-        return accumulate(cbegin(), cend(), 0, plus<double>());
+        if (not is_contiguous())
+            return contiguous().sum();
+
+        profile::Record record{"sum"};
+        if (record)
+            record.describe({d_shape}, {
+                .elements      = 1,
+                .flops         = size(),
+                .bytes_read    = size() * sizeof(double),
+                .bytes_written = sizeof(double),
+            });
+
+        double const *values = data();
+        size_t const blocks = (size() + sum_block - 1) / sum_block;
+
+        vector<double> partial(blocks);
+        parallel::parallel_for(0, blocks, parallel::grain_size(blocks, sum_block),
+            [this, values, &partial](size_t first, size_t last) {
+                for (size_t block = first; block < last; ++block)
+                {
+                    double const *start = values + block * sum_block;
+                    double const *stop  = values + std::min(size(), (block + 1) * sum_block);
+                    partial[block] = accumulate(start, stop, 0.0);
+                }
+            });
+
+        return accumulate(partial.begin(), partial.end(), 0.0);
     }
 
     BroadcastPlan prepare_broadcast(const Tensor& lhs, const Tensor& rhs)
@@ -126,7 +208,7 @@ namespace autodiff
 
         const size_t rank = max(lhs_shape.size(), rhs_strides.size());
 
-        vector<size_t>  b_lhs_strides(rank), b_rhs_strides(rank),
+        Dims            b_lhs_strides(rank), b_rhs_strides(rank),
                         result_shape(rank), result_strides(rank);
 
         int ia = static_cast<int>(lhs_shape.size()) - 1;
@@ -0,0 +1,605 @@
+#include "tensor.ih"
+#include "basic_tensor.h"
+
+namespace autodiff
+{
+    namespace
+    {
+        // elements widened to accumulate_t<T> at a time
+        size_t const block = 256;
+
+        // elements summed into one partial of sum()
+        size_t const sum_block = 4096;
+
+        // Strides of a contiguous tensor of shape broadcast to target
+        Dims broadcast_strides(Dims const &shape, Dims const &target)
+        {
+            Dims const strides = calculate_strides(shape);
+            Dims result(target.size());
+            size_t const skip = target.size() - shape.size();
+            for (size_t axis = 0; axis < shape.size(); ++axis)
+                result[skip + axis] = shape[axis] == 1 ? 0 : strides[axis];
+            return result;
+        }
+
+        // run() over arrays of the accumulate type: the float32 SIMD
+        // kernels for float, plain loops for int64_t
+        struct Add
+        {
+            static void run(float const *x, float const *y, float *res, size_t size)
+            {
+                simd::add(x, y, res, size);
+            }
+
+            static void run(int64_t const *x, int64_t const *y, int64_t *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = x[i] + y[i];
+            }
+        };
+
+        struct Sub
+        {
+            static void run(float const *x, float const *y, float *res, size_t size)
+            {
+                simd::sub(x, y, res, size);
+            }
+
+            static void run(int64_t const *x, int64_t const *y, int64_t *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = x[i] - y[i];
+            }
+        };
+
+        struct Mul
+        {
+            static void run(float const *x, float const *y, float *res, size_t size)
+            {
+                simd::mul(x, y, res, size);
+            }
+
+            static void run(int64_t const *x, int64_t const *y, int64_t *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = x[i] * y[i];
+            }
+        };
+
+        struct Div
+        {
+            static void run(float const *x, float const *y, float *res, size_t size)
+            {
+                simd::div(x, y, res, size);
+            }
+
+            static void run(int64_t const *x, int64_t const *y, int64_t *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = x[i] / y[i];
+            }
+        };
+
+        // the unit-step loops are kept separate so they vectorise, and
+        // bfloat16 goes to the SIMD conversion kernels
+        template <typename T>
+        void widen(T const *src, size_t step, accumulate_t<T> *dst, size_t size)
+        {
+            if constexpr (is_same_v<T, bfloat16>)
+                if (step == 1)
+                    return simd::bf16_to_f32(&src->bits, dst, size);
+
+            if (step == 1)
+                for (size_t i = 0; i < size; ++i)
+                    dst[i] = static_cast<accumulate_t<T>>(src[i]);
+            else
+                for (size_t i = 0; i < size; ++i)
+                    dst[i] = static_cast<accumulate_t<T>>(src[i * step]);
+        }
+
+        template <typename T>
+        void narrow(accumulate_t<T> const *src, T *dst, size_t step, size_t size)
+        {
+            if constexpr (is_same_v<T, bfloat16>)
+                if (step == 1)
+                    return simd::f32_to_bf16(src, &dst->bits, size);
+
+            if (step == 1)
+                for (size_t i = 0; i < size; ++i)
+                    dst[i] = static_cast<T>(src[i]);
+            else
+                for (size_t i = 0; i < size; ++i)
+                    dst[i * step] = static_cast<T>(src[i]);
+        }
+
+        // res = lhs op rhs over the broadcast shape of res. Runs are cut
+        // into blocks, which float tensors hand to the kernel directly
+        // when they are contiguous and the other types widen first.
+        template <typename Op, typename T>
+        void apply(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs, BasicTensor<T> &res)
+        {
+            using Acc = accumulate_t<T>;
+
+            Dims const &shape = res.shape();
+            BroadcastIterator const start{shape, calculate_strides(shape),
+                                          broadcast_strides(lhs.shape(), shape),
+                                          broadcast_strides(rhs.shape(), shape)};
+
+            size_t const length = start.length();
+            size_t const blocks = (length + block - 1) / block;
+            size_t const tasks  = start.runs() * blocks;
+
+            T const *x = lhs.data();
+            T const *y = rhs.data();
+            T *out     = res.data();
+
+            parallel::parallel_for(0, tasks, parallel::grain_size(tasks, block),
+                [&](size_t first, size_t last) {
+                    BroadcastIterator iter = start;
+                    size_t run = first / blocks;
+                    iter.seek(run);
+
+                    Acc a[block];
+                    Acc b[block];
+                    for (size_t task = first; task < last; ++task)
+                    {
+                        for (; run < task / blocks; ++run)
+                            iter.next();
+
+                        size_t const offset = task % blocks * block;
+                        size_t const size   = std::min(block, length - offset);
+                        T const *l = x + iter.lhs() + offset * iter.lhs_step();
+                        T const *r = y + iter.rhs() + offset * iter.rhs_step();
+                        T *o       = out + iter.res() + offset * iter.res_step();
+
+                        if constexpr (is_same_v<T, Acc>)
+                            if (iter.lhs_step() == 1 and iter.rhs_step() == 1 and iter.res_step() == 1)
+                            {
+                                Op::run(l, r, o, size);
+                                continue;
+                            }
+
+                        widen(l, iter.lhs_step(), a, size);
+                        widen(r, iter.rhs_step(), b, size);
+                        Op::run(a, b, a, size);
+                        narrow(a, o, iter.res_step(), size);
+                    }
+                });
+        }
+
+        template <typename Op, typename T>
+        BasicTensor<T> binary(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+        {
+            BasicTensor<T> result{expr::broadcast_shape(lhs.shape(), rhs.shape()), uninitialized};
+            apply<Op>(lhs, rhs, result);
+            return result;
+        }
+
+        template <typename Op, typename T>
+        BasicTensor<T> &inplace(BasicTensor<T> &lhs, BasicTensor<T> const &rhs)
+        {
+            if (expr::broadcast_shape(lhs.shape(), rhs.shape()) != lhs.shape())
+                throw invalid_argument("operand does not broadcast to the shape of the target");
+
+            apply<Op>(lhs, rhs, lhs);
+            return lhs;
+        }
+
+        // Integer division by zero traps, so int32 divisors are checked
+        // before any element is written
+        template <typename T>
+        BasicTensor<T> const &checked_divisor(BasicTensor<T> const &rhs)
+        {
+            if constexpr (is_integral_v<T>)
+                if (find(rhs.cbegin(), rhs.cend(), T{0}) != rhs.cend())
+                    throw invalid_argument("integer division by zero");
+            return rhs;
+        }
+
+        float block_sum(float const *x, size_t size)
+        {
+            return simd::sum(x, size);
+        }
+
+        int64_t block_sum(int64_t const *x, size_t size)
+        {
+            return accumulate(x, x + size, int64_t{0});
+        }
+
+        // error grows with log(size) instead of size
+        template <typename T>
+        accumulate_t<T> pairwise_sum(T const *x, size_t size)
+        {
+            if (size > block)
+            {
+                size_t const half = size / 2;
+                return pairwise_sum(x, half) + pairwise_sum(x + half, size - half);
+            }
+
+            if constexpr (is_same_v<T, accumulate_t<T>>)
+                return block_sum(x, size);
+            else
+            {
+                accumulate_t<T> wide[block];
+                widen(x, 1, wide, size);
+                return block_sum(wide, size);
+            }
+        }
+
+        // The axes a reduction keeps and those it folds into each output
+        struct Reduction
+        {
+            Dims   shape;                       // of the result
+            Dims   kept_shape;
+            Dims   kept_strides;
+            Dims   reduced_shape;
+            Dims   reduced_strides;
+            size_t count    = 1;                // elements folded into an output
+            bool   trailing = true;             // and they form one run
+        };
+
+        Reduction reduction(Dims const &shape, Dims const &axes, bool keepdims)
+        {
+            size_t const rank = shape.size();
+            vector<bool> reduce(rank, axes.empty());
+            for (size_t axis : axes)
+            {
+                if (axis >= rank)
+                    throw invalid_argument("axis " + to_string(axis)
+                                           + " out of range for rank " + to_string(rank));
+                if (reduce[axis])
+                    throw invalid_argument("axis " + to_string(axis) + " reduced twice");
+                reduce[axis] = true;
+            }
+
+            Dims const strides = calculate_strides(shape);
+            Reduction result;
+            bool folded = false;                // a reduced axis longer than 1 so far
+            for (size_t axis = 0; axis < rank; ++axis)
+            {
+                if (reduce[axis])
+                {
+                    result.reduced_shape.push_back(shape[axis]);
+                    result.reduced_strides.push_back(strides[axis]);
+                    result.count *= shape[axis];
+                    folded = folded or shape[axis] > 1;
+                    if (keepdims)
+                        result.shape.push_back(1);
+                }
+                else
+                {
+                    result.kept_shape.push_back(shape[axis]);
+                    result.kept_strides.push_back(strides[axis]);
+                    result.shape.push_back(shape[axis]);
+                    result.trailing = result.trailing and (not folded or shape[axis] == 1);
+                }
+            }
+
+            if (result.shape.empty())
+                result.shape.push_back(1);
+            return result;
+        }
+
+        // Calls visit(offset) for the elements of shape laid out by
+        // strides, in row-major order, stepping an odometer
+        template <typename Visit>
+        void walk(Dims const &shape, Dims const &strides, Visit &&visit)
+        {
+            Dims coord(shape.size());
+            size_t offset = 0;
+            for (size_t count = elements(shape); count-- > 0;)
+            {
+                visit(offset);
+                for (size_t axis = shape.size(); axis-- > 0;)
+                {
+                    offset += strides[axis];
+                    if (++coord[axis] < shape[axis])
+                        break;
+
+                    offset -= coord[axis] * strides[axis];
+                    coord[axis] = 0;
+                }
+            }
+        }
+
+        // fold(first element of an output) for every output, in parallel
+        template <typename T, typename Fold>
+        auto reduce(BasicTensor<T> const &tensor, Reduction const &lay, Fold const &fold)
+        {
+            size_t const outputs = elements(lay.kept_shape);
+            T const *in          = tensor.data();
+
+            vector<decltype(fold(in))> out(outputs);
+            parallel::parallel_for(0, outputs, parallel::grain_size(outputs, lay.count),
+                [&](size_t first, size_t last) {
+                    for (size_t index = first; index < last; ++index)
+                    {
+                        size_t offset = 0;
+                        size_t rest   = index;
+                        for (size_t axis = lay.kept_shape.size(); axis-- > 0;)
+                        {
+                            offset += rest % lay.kept_shape[axis] * lay.kept_strides[axis];
+                            rest   /= lay.kept_shape[axis];
+                        }
+                        out[index] = fold(in + offset);
+                    }
+                });
+            return out;
+        }
+
+        // Sums of runs are pairwise; strided float sums are compensated
+        template <typename T>
+        vector<accumulate_t<T>> reduce_sum(BasicTensor<T> const &tensor, Reduction const &lay)
+        {
+            using Acc = accumulate_t<T>;
+
+            if (lay.trailing)
+                return reduce(tensor, lay, [&lay](T const *base) {
+                    return pairwise_sum(base, lay.count);
+                });
+
+            return reduce(tensor, lay, [&lay](T const *base) {
+                Acc acc          = 0;
+                Acc compensation = 0;
+                walk(lay.reduced_shape, lay.reduced_strides, [&](size_t offset) {
+                    Acc const value = static_cast<Acc>(base[offset]);
+                    if constexpr (is_integral_v<Acc>)
+                        acc += value;
+                    else
+                    {
+                        Acc const y = value - compensation;
+                        Acc const t = acc + y;
+                        compensation = (t - acc) - y;
+                        acc          = t;
+                    }
+                });
+                return acc;
+            });
+        }
+
+        // The first element wins ties, so max and min are exact
+        template <typename T, typename Better>
+        vector<accumulate_t<T>> reduce_extreme(BasicTensor<T> const &tensor, Reduction const &lay,
+                                               Better better)
+        {
+            using Acc = accumulate_t<T>;
+
+            return reduce(tensor, lay, [&lay, better](T const *base) {
+                Acc acc = static_cast<Acc>(base[0]);
+                walk(lay.reduced_shape, lay.reduced_strides, [&](size_t offset) {
+                    Acc const value = static_cast<Acc>(base[offset]);
+                    if (better(value, acc))
+                        acc = value;
+                });
+                return acc;
+            });
+        }
+
+        template <typename T, typename Acc>
+        BasicTensor<T> rounded(Dims const &shape, vector<Acc> const &values)
+        {
+            BasicTensor<T> result{shape, uninitialized};
+            detail::convert(values.data(), result.data(), values.size());
+            return result;
+        }
+    }
+
+    template <typename T>
+    BasicTensor<T>::BasicTensor(Dims const &shape)
+    :
+        BasicTensor(shape, T{})
+    {}
+
+    template <typename T>
+    BasicTensor<T>::BasicTensor(Dims const &shape, T value)
+    :
+        BasicTensor(shape, uninitialized)
+    {
+        fill(data(), data() + d_size, value);
+    }
+
+    template <typename T>
+    BasicTensor<T>::BasicTensor(Dims const &shape, vector<T> &&values)
+    :
+        BasicTensor(shape, uninitialized)
+    {
+        assert(values.size() == d_size and "data does not match shape");
+        copy(values.begin(), values.end(), data());
+    }
+
+    // Buffers hold doubles; a buffer of ceil(size * sizeof(T) / 8) of them
+    // is suitably aligned storage for any T
+    template <typename T>
+    BasicTensor<T>::BasicTensor(Dims const &shape, Uninitialized)
+    :
+        d_data(memory::allocate((elements(shape) * sizeof(T) + sizeof(double) - 1)
+                                / sizeof(double))),
+        d_shape(shape),
+        d_size(elements(shape))
+    {
+        assert(not d_shape.empty() and "shape cannot be empty");
+        assert(find(d_shape.begin(), d_shape.end(), 0) == d_shape.end() and "invalid dimension 0");
+    }
+
+    template <typename T>
+    BasicTensor<T>::BasicTensor(Dims const &shape, shared_ptr<memory::Buffer> data)
+    :
+        d_data(std::move(data)),
+        d_shape(shape),
+        d_size(elements(shape))
+    {}
+
+    template <typename T>
+    Dims const &BasicTensor<T>::shape() const
+    {
+        return d_shape;
+    }
+
+    template <typename T>
+    size_t BasicTensor<T>::rank() const
+    {
+        return d_shape.size();
+    }
+
+    template <typename T>
+    size_t BasicTensor<T>::size() const
+    {
+        return d_size;
+    }
+
+    template <typename T>
+    T *BasicTensor<T>::data()
+    {
+        return reinterpret_cast<T *>(d_data->data());
+    }
+
+    template <typename T>
+    T const *BasicTensor<T>::data() const
+    {
+        return reinterpret_cast<T const *>(d_data->data());
+    }
+
+    template <typename T>
+    T const *BasicTensor<T>::cbegin() const
+    {
+        return data();
+    }
+
+    template <typename T>
+    T const *BasicTensor<T>::cend() const
+    {
+        return data() + d_size;
+    }
+
+    template <typename T>
+    BasicTensor<T> &BasicTensor<T>::operator+=(BasicTensor const &rhs)
+    {
+        return inplace<Add>(*this, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> &BasicTensor<T>::operator-=(BasicTensor const &rhs)
+    {
+        return inplace<Sub>(*this, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> &BasicTensor<T>::operator*=(BasicTensor const &rhs)
+    {
+        return inplace<Mul>(*this, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> &BasicTensor<T>::operator/=(BasicTensor const &rhs)
+    {
+        return inplace<Div>(*this, checked_divisor(rhs));
+    }
+
+    template <typename T>
+    accumulate_t<T> BasicTensor<T>::sum() const
+    {
+        T const *values     = data();
+        size_t const blocks = (d_size + sum_block - 1) / sum_block;
+
+        vector<accumulate_t<T>> partial(blocks);
+        parallel::parallel_for(0, blocks, parallel::grain_size(blocks, sum_block),
+            [this, values, &partial](size_t first, size_t last) {
+                for (size_t index = first; index < last; ++index)
+                {
+                    size_t const start = index * sum_block;
+                    partial[index] = pairwise_sum(values + start,
+                                                  std::min(d_size, start + sum_block) - start);
+                }
+            });
+
+        return pairwise_sum(partial.data(), blocks);
+    }
+
+    template <typename T>
+    BasicTensor<T> BasicTensor<T>::sum(Dims const &axes, bool keepdims) const
+    {
+        Reduction const lay = reduction(d_shape, axes, keepdims);
+        return rounded<T>(lay.shape, reduce_sum(*this, lay));
+    }
+
+    template <typename T>
+    BasicTensor<T> BasicTensor<T>::mean(Dims const &axes, bool keepdims) const
+    {
+        Reduction const lay = reduction(d_shape, axes, keepdims);
+        vector<accumulate_t<T>> values = reduce_sum(*this, lay);
+        for (accumulate_t<T> &value : values)
+            value /= static_cast<accumulate_t<T>>(lay.count);
+        return rounded<T>(lay.shape, values);
+    }
+
+    template <typename T>
+    BasicTensor<T> BasicTensor<T>::max(Dims const &axes, bool keepdims) const
+    {
+        Reduction const lay = reduction(d_shape, axes, keepdims);
+        return rounded<T>(lay.shape, reduce_extreme(*this, lay, greater<>()));
+    }
+
+    template <typename T>
+    BasicTensor<T> BasicTensor<T>::min(Dims const &axes, bool keepdims) const
+    {
+        Reduction const lay = reduction(d_shape, axes, keepdims);
+        return rounded<T>(lay.shape, reduce_extreme(*this, lay, less<>()));
+    }
+
+    template <typename T>
+    BasicTensor<int32_t> BasicTensor<T>::argmax(size_t axis, bool keepdims) const
+    {
+        Reduction const lay = reduction(d_shape, {axis}, keepdims);
+        size_t const length = lay.count;
+        size_t const stride = lay.reduced_strides[0];
+
+        vector<int32_t> const best = reduce(*this, lay, [length, stride](T const *base) {
+            size_t best = 0;
+            for (size_t step = 1; step < length; ++step)
+                if (static_cast<accumulate_t<T>>(base[step * stride])
+                    > static_cast<accumulate_t<T>>(base[best * stride]))
+                    best = step;
+            return static_cast<int32_t>(best);
+        });
+
+        return rounded<int32_t>(lay.shape, best);
+    }
+
+    template <typename T>
+    BasicTensor<T> operator+(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+    {
+        return binary<Add>(lhs, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> operator-(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+    {
+        return binary<Sub>(lhs, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> operator*(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+    {
+        return binary<Mul>(lhs, rhs);
+    }
+
+    template <typename T>
+    BasicTensor<T> operator/(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs)
+    {
+        return binary<Div>(lhs, checked_divisor(rhs));
+    }
+
+#define AUTODIFF_INSTANTIATE(T)                                                     \
+    template class BasicTensor<T>;                                                  \
+    template BasicTensor<T> operator+(BasicTensor<T> const &, BasicTensor<T> const &); \
+    template BasicTensor<T> operator-(BasicTensor<T> const &, BasicTensor<T> const &); \
+    template BasicTensor<T> operator*(BasicTensor<T> const &, BasicTensor<T> const &); \
+    template BasicTensor<T> operator/(BasicTensor<T> const &, BasicTensor<T> const &);
+
+    AUTODIFF_INSTANTIATE(float)
+    AUTODIFF_INSTANTIATE(bfloat16)
+    AUTODIFF_INSTANTIATE(float16)
+    AUTODIFF_INSTANTIATE(int32_t)
+
+#undef AUTODIFF_INSTANTIATE
+}
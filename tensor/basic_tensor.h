@@ -0,0 +1,160 @@
+#ifndef INCLUDED_BASIC_TENSOR
+#define INCLUDED_BASIC_TENSOR
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dtype.h"
+#include "tensor.h"
+
+namespace autodiff
+{
+    template <typename T>
+    class BasicTensor;
+
+    template <typename T>
+    BasicTensor<T> load(std::string const &path);
+
+    // Dense row-major tensor of element type T: float, bfloat16, float16
+    // or int32_t. Tensor remains the double tensor used by autograd and the
+    // lazy expressions; BasicTensor halves (float) or quarters (16-bit)
+    // the memory of models that do not need double precision.
+    //
+    // Element-wise arithmetic and reductions run in accumulate_t<T>, so the
+    // 16-bit types are storage formats: blocks are widened to float,
+    // computed with the float32 SIMD kernels and rounded back once.
+    template <typename T>
+    class BasicTensor
+    {
+        std::shared_ptr<memory::Buffer> d_data;
+        Dims                            d_shape;
+        size_t                          d_size;
+
+        // over data, which holds at least the elements of shape
+        BasicTensor(Dims const &shape, std::shared_ptr<memory::Buffer> data);
+
+        friend BasicTensor load<T>(std::string const &path);
+
+    public:
+        using value_type = T;
+
+        explicit BasicTensor(Dims const &shape);        // zeros
+        BasicTensor(Dims const &shape, T value);
+        BasicTensor(Dims const &shape, std::vector<T> &&data);
+        BasicTensor(Dims const &shape, Uninitialized);
+
+        Dims const &shape() const;
+        size_t rank() const;
+        size_t size() const;
+
+        T       *data();
+        T const *data()   const;
+        T const *cbegin() const;
+        T const *cend()   const;
+
+        // rhs must broadcast to the shape of this tensor. Integer
+        // division throws invalid_argument on a zero divisor.
+        BasicTensor &operator+=(BasicTensor const &rhs);
+        BasicTensor &operator-=(BasicTensor const &rhs);
+        BasicTensor &operator*=(BasicTensor const &rhs);
+        BasicTensor &operator/=(BasicTensor const &rhs);
+
+        // Pairwise over fixed blocks, independent of the thread count
+        accumulate_t<T> sum() const;
+
+        // Reductions over axes, or over every axis when axes is empty,
+        // shaped as those of Tensor. Values are folded in accumulate_t<T>
+        // and rounded to T once per result element; int32 means truncate.
+        BasicTensor sum(Dims const &axes, bool keepdims = false) const;
+        BasicTensor mean(Dims const &axes = {}, bool keepdims = false) const;
+        BasicTensor max(Dims const &axes = {}, bool keepdims = false) const;
+        BasicTensor min(Dims const &axes = {}, bool keepdims = false) const;
+
+        // Index of the first maximum along axis
+        BasicTensor<std::int32_t> argmax(size_t axis, bool keepdims = false) const;
+    };
+
+    using Float32Tensor  = BasicTensor<float>;
+    using BFloat16Tensor = BasicTensor<bfloat16>;
+    using Float16Tensor  = BasicTensor<float16>;
+    using Int32Tensor    = BasicTensor<std::int32_t>;
+
+    // Element-wise with broadcasting, computed in accumulate_t<T>; integer
+    // division by zero throws invalid_argument
+    template <typename T>
+    BasicTensor<T> operator+(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs);
+    template <typename T>
+    BasicTensor<T> operator-(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs);
+    template <typename T>
+    BasicTensor<T> operator*(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs);
+    template <typename T>
+    BasicTensor<T> operator/(BasicTensor<T> const &lhs, BasicTensor<T> const &rhs);
+
+    // matmul of BasicTensors is declared in linalg/linalg.h
+
+    // Tensor files as for Tensor (see save() in tensor.h), with the element
+    // type of T in the header. load<T> maps the file without copying and
+    // throws runtime_error when it holds another element type or is not
+    // stored in row-major order.
+    template <typename T>
+    void save(BasicTensor<T> const &tensor, std::string const &path);
+
+    // Explicit conversions, rounding to nearest even. Conversions from
+    // double to a 16-bit type go through float.
+    template <typename To, typename From>
+    BasicTensor<To> astype(BasicTensor<From> const &tensor);
+
+    template <typename To>
+    BasicTensor<To> astype(Tensor const &tensor);
+
+    template <typename From>
+    Tensor to_tensor(BasicTensor<From> const &tensor);
+
+    namespace detail
+    {
+        template <typename To, typename From>
+        void convert(From const *src, To *dst, size_t size)
+        {
+            parallel::parallel_for(0, size, parallel::grain_size(size),
+                [src, dst](size_t first, size_t last) {
+                    for (size_t index = first; index < last; ++index)
+                        dst[index] = static_cast<To>(src[index]);
+                });
+        }
+    }
+
+    template <typename To, typename From>
+    BasicTensor<To> astype(BasicTensor<From> const &tensor)
+    {
+        BasicTensor<To> result{tensor.shape(), uninitialized};
+        detail::convert(tensor.data(), result.data(), tensor.size());
+        return result;
+    }
+
+    template <typename To>
+    BasicTensor<To> astype(Tensor const &tensor)
+    {
+        Tensor const dense = tensor.contiguous();
+        BasicTensor<To> result{dense.shape(), uninitialized};
+        detail::convert(dense.data(), result.data(), dense.size());
+        return result;
+    }
+
+    template <typename From>
+    Tensor to_tensor(BasicTensor<From> const &tensor)
+    {
+        Tensor result{tensor.shape(), uninitialized};
+        detail::convert(tensor.data(), result.data(), tensor.size());
+        return result;
+    }
+
+    extern template class BasicTensor<float>;
+    extern template class BasicTensor<bfloat16>;
+    extern template class BasicTensor<float16>;
+    extern template class BasicTensor<std::int32_t>;
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "tensor.ih"
+
+namespace autodiff
+{
+    BroadcastIterator::BroadcastIterator(BroadcastPlan const &plan)
+    :
+        BroadcastIterator(plan.res_shape, plan.res_strides, plan.lhs_strides, plan.rhs_strides)
+    {}
+
+    BroadcastIterator::BroadcastIterator(Dims const &shape,
+                                         Dims const &res_strides,
+                                         Dims const &lhs_strides,
+                                         Dims const &rhs_strides)
+    {
+        // collapse from the innermost axis outwards, skipping size-1 axes
+        for (size_t axis = shape.size(); axis-- > 0;)
+        {
+            if (shape[axis] == 1)
+                continue;
+
+            if (not d_shape.empty())
+            {
+                size_t const dim = d_shape.front();
+                bool const contiguous = res_strides[axis] == d_res_strides.front() * dim
+                                    and lhs_strides[axis] == d_lhs_strides.front() * dim
+                                    and rhs_strides[axis] == d_rhs_strides.front() * dim;
+                if (contiguous)
+                {
+                    d_shape.front() *= shape[axis];
+                    continue;
+                }
+            }
+
+            d_shape.insert(d_shape.begin(), shape[axis]);
+            d_res_strides.insert(d_res_strides.begin(), res_strides[axis]);
+            d_lhs_strides.insert(d_lhs_strides.begin(), lhs_strides[axis]);
+            d_rhs_strides.insert(d_rhs_strides.begin(), rhs_strides[axis]);
+        }
+
+        if (not d_shape.empty())
+        {
+            d_length   = d_shape.back();
+            d_res_step = d_res_strides.back();
+            d_lhs_step = d_lhs_strides.back();
+            d_rhs_step = d_rhs_strides.back();
+
+            d_shape.pop_back();
+            d_res_strides.pop_back();
+            d_lhs_strides.pop_back();
+            d_rhs_strides.pop_back();
+        }
+
+        d_runs = elements(d_shape);
+        d_coord.assign(d_shape.size(), 0);
+    }
+}
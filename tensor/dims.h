@@ -0,0 +1,147 @@
+#ifndef INCLUDED_DIMS
+#define INCLUDED_DIMS
+
+#include <cstddef>
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autodiff
+{
+    // Shape or strides of up to max_rank dimensions, stored inline so that
+    // building and copying them never touches the heap. Mirrors the parts
+    // of std::vector<size_t> the library uses.
+    class Dims
+    {
+    public:
+        static constexpr size_t max_rank = 8;
+
+    private:
+        size_t d_dims[max_rank] = {};
+        size_t d_size           = 0;
+
+    public:
+        using value_type     = size_t;
+        using iterator       = size_t *;
+        using const_iterator = size_t const *;
+
+        Dims() = default;
+
+        explicit Dims(size_t count, size_t value = 0)
+        :
+            d_size(checked(count))
+        {
+            std::fill(d_dims, d_dims + d_size, value);
+        }
+
+        Dims(std::initializer_list<size_t> dims)
+        :
+            Dims(dims.begin(), dims.end())
+        {}
+
+        Dims(std::vector<size_t> const &dims)
+        :
+            Dims(dims.data(), dims.data() + dims.size())
+        {}
+
+        Dims(size_t const *first, size_t const *last)
+        :
+            d_size(checked(static_cast<size_t>(last - first)))
+        {
+            std::copy(first, last, d_dims);
+        }
+
+        size_t size()  const { return d_size; }
+        bool   empty() const { return d_size == 0; }
+
+        size_t       &operator[](size_t axis)       { return d_dims[axis]; }
+        size_t const &operator[](size_t axis) const { return d_dims[axis]; }
+
+        size_t       &front()       { return d_dims[0]; }
+        size_t const &front() const { return d_dims[0]; }
+        size_t       &back()        { return d_dims[d_size - 1]; }
+        size_t const &back()  const { return d_dims[d_size - 1]; }
+
+        iterator       begin()        { return d_dims; }
+        iterator       end()          { return d_dims + d_size; }
+        const_iterator begin()  const { return d_dims; }
+        const_iterator end()    const { return d_dims + d_size; }
+        const_iterator cbegin() const { return d_dims; }
+        const_iterator cend()   const { return d_dims + d_size; }
+
+        size_t       *data()       { return d_dims; }
+        size_t const *data() const { return d_dims; }
+
+        void push_back(size_t dim)
+        {
+            checked(d_size + 1);
+            d_dims[d_size++] = dim;
+        }
+
+        void pop_back()
+        {
+            --d_size;
+        }
+
+        iterator insert(const_iterator pos, size_t dim)
+        {
+            checked(d_size + 1);
+            size_t const axis = static_cast<size_t>(pos - d_dims);
+            std::copy_backward(d_dims + axis, d_dims + d_size, d_dims + d_size + 1);
+            d_dims[axis] = dim;
+            ++d_size;
+            return d_dims + axis;
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            size_t const axis = static_cast<size_t>(pos - d_dims);
+            std::copy(d_dims + axis + 1, d_dims + d_size, d_dims + axis);
+            --d_size;
+            return d_dims + axis;
+        }
+
+        void assign(size_t count, size_t value)
+        {
+            d_size = checked(count);
+            std::fill(d_dims, d_dims + d_size, value);
+        }
+
+        operator std::vector<size_t>() const
+        {
+            return std::vector<size_t>(begin(), end());
+        }
+
+        friend bool operator==(Dims const &lhs, Dims const &rhs)
+        {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+        friend bool operator==(Dims const &lhs, std::vector<size_t> const &rhs)
+        {
+            return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+        }
+
+    private:
+        static size_t checked(size_t size)
+        {
+            if (size > max_rank)
+                throw std::length_error("tensors support at most "
+                                        + std::to_string(max_rank) + " dimensions");
+            return size;
+        }
+    };
+
+    // Elements of a tensor of the given shape
+    inline size_t elements(Dims const &shape)
+    {
+        return std::accumulate(shape.begin(), shape.end(), size_t{1},
+                               std::multiplies<size_t>());
+    }
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef INCLUDED_DTYPE
+#define INCLUDED_DTYPE
+
+#include <bit>
+#include <cstdint>
+
+namespace autodiff
+{
+    // 16-bit floating point storage formats. They only convert to and
+    // from float, rounding to nearest even; arithmetic on them happens in
+    // float (see accumulate_t).
+
+    // IEEE 754 binary16: 5 exponent bits, 10 mantissa bits, max 65504
+    struct float16
+    {
+        std::uint16_t bits = 0;
+
+        float16() = default;
+        constexpr explicit float16(float value);
+
+        constexpr operator float() const;
+    };
+
+    // bfloat16: the upper half of a float, 8 mantissa bits fewer
+    struct bfloat16
+    {
+        std::uint16_t bits = 0;
+
+        bfloat16() = default;
+        constexpr explicit bfloat16(float value);
+
+        constexpr operator float() const;
+    };
+
+    // Type in which arithmetic on elements of type T is carried out and
+    // accumulated: float for the 16-bit formats, int64_t for int32_t.
+    template <typename T>
+    struct Accumulate
+    {
+        using type = T;
+    };
+
+    template <>
+    struct Accumulate<float16>
+    {
+        using type = float;
+    };
+
+    template <>
+    struct Accumulate<bfloat16>
+    {
+        using type = float;
+    };
+
+    template <>
+    struct Accumulate<std::int32_t>
+    {
+        using type = std::int64_t;
+    };
+
+    template <typename T>
+    using accumulate_t = typename Accumulate<T>::type;
+
+    // Normal values add the rounding bias in the bit pattern and shift;
+    // subnormal results are aligned by adding 0.5f, whose rounding does
+    // the work. After F. Giesen, "half <-> float conversions".
+    constexpr float16::float16(float value)
+    {
+        std::uint32_t in         = std::bit_cast<std::uint32_t>(value);
+        std::uint32_t const sign = (in >> 16) & 0x8000;
+        in &= 0x7fffffff;
+
+        if (in >= 0x47800000)                   // 65536 and up, inf, nan
+            bits = static_cast<std::uint16_t>(sign | (in > 0x7f800000 ? 0x7e00 : 0x7c00));
+        else if (in < 0x38800000)               // below 2^-14: subnormal or zero
+        {
+            float const aligned = std::bit_cast<float>(in) + 0.5f;
+            bits = static_cast<std::uint16_t>(sign | (std::bit_cast<std::uint32_t>(aligned)
+                                                      - 0x3f000000));
+        }
+        else
+        {
+            std::uint32_t const odd = (in >> 13) & 1;
+            in += 0xc8000fff + odd;             // rebias the exponent, round
+            bits = static_cast<std::uint16_t>(sign | (in >> 13));
+        }
+    }
+
+    constexpr float16::operator float() const
+    {
+        std::uint32_t out            = std::uint32_t{bits & 0x7fffu} << 13;
+        std::uint32_t const exponent = out & 0x0f800000;
+        out += 0x38000000;                      // rebias the exponent
+
+        if (exponent == 0x0f800000)             // inf, nan
+            out += 0x38000000;
+        else if (exponent == 0)                 // subnormal
+            out = std::bit_cast<std::uint32_t>(std::bit_cast<float>(out + 0x00800000)
+                                               - 6.103515625e-05f);
+
+        return std::bit_cast<float>(out | std::uint32_t{bits & 0x8000u} << 16);
+    }
+
+    constexpr bfloat16::bfloat16(float value)
+    {
+        std::uint32_t const in = std::bit_cast<std::uint32_t>(value);
+        if ((in & 0x7fffffff) > 0x7f800000)     // keep nan quiet
+            bits = static_cast<std::uint16_t>(in >> 16 | 0x40);
+        else
+            bits = static_cast<std::uint16_t>((in + 0x7fff + ((in >> 16) & 1)) >> 16);
+    }
+
+    constexpr bfloat16::operator float() const
+    {
+        return std::bit_cast<float>(std::uint32_t{bits} << 16);
+    }
+}
+
+#endif
@@ -0,0 +1,147 @@
+#include "tensor.ih"
+
+namespace autodiff::expr
+{
+    Dims broadcast_shape(Dims const &lhs, Dims const &rhs)
+    {
+        size_t const rank = max(lhs.size(), rhs.size());
+        size_t const lhs_skip = rank - lhs.size();
+        size_t const rhs_skip = rank - rhs.size();
+
+        Dims shape(rank);
+        for (size_t axis = 0; axis < rank; ++axis)
+        {
+            size_t const dim_lhs = axis < lhs_skip ? 1 : lhs[axis - lhs_skip];
+            size_t const dim_rhs = axis < rhs_skip ? 1 : rhs[axis - rhs_skip];
+
+            if (dim_lhs != 1 and dim_rhs != 1 and dim_lhs != dim_rhs)
+                throw runtime_error("Incompatible shapes at axis " + to_string(axis));
+
+            shape[axis] = max(dim_lhs, dim_rhs);
+        }
+
+        return shape;
+    }
+
+    Dims broadcast_strides(Tensor const &t, Dims const &shape)
+    {
+        assert(t.rank() <= shape.size() and "tensor does not broadcast to shape");
+
+        Dims strides(shape.size());
+        size_t const skip = shape.size() - t.rank();
+        for (size_t axis = 0; axis < t.rank(); ++axis)
+            strides[skip + axis] = t.shape()[axis] == 1 ? 0 : t.strides()[axis];
+
+        return strides;
+    }
+
+    bool partially_overlaps(Tensor const &a, Tensor const &b)
+    {
+        auto const [a_first, a_last] = extent(a);
+        auto const [b_first, b_last] = extent(b);
+
+        bool const overlaps = a_first < b_last and b_first < a_last;
+        bool const aliases  = a_first == b_first
+                          and a.shape() == b.shape()
+                          and a.strides() == b.strides();
+        return overlaps and not aliases;
+    }
+
+    void check_writable(Tensor const &target)
+    {
+        for (size_t axis = 0; axis < target.rank(); ++axis)
+            if (target.strides()[axis] == 0 and target.shape()[axis] > 1)
+                throw invalid_argument("cannot write in place to broadcast axis "
+                                       + to_string(axis) + " of size "
+                                       + to_string(target.shape()[axis]));
+    }
+
+    Plan::Plan(Dims const &shape, vector<Dims> const &leaf_strides)
+    :
+        d_strides(leaf_strides.size()),
+        d_steps(leaf_strides.size(), 0),
+        d_size(elements(shape))
+    {
+        size_t const leaves = leaf_strides.size();
+
+        // collapse from the innermost axis outwards, skipping size-1 axes
+        for (size_t axis = shape.size(); axis-- > 0;)
+        {
+            if (shape[axis] == 1)
+                continue;
+
+            if (not d_shape.empty())
+            {
+                size_t const dim = d_shape.front();
+                bool contiguous = true;
+                for (size_t leaf = 0; leaf < leaves; ++leaf)
+                    contiguous = contiguous
+                             and leaf_strides[leaf][axis] == d_strides[leaf].front() * dim;
+
+                if (contiguous)
+                {
+                    d_shape.front() *= shape[axis];
+                    continue;
+                }
+            }
+
+            d_shape.insert(d_shape.begin(), shape[axis]);
+            for (size_t leaf = 0; leaf < leaves; ++leaf)
+                d_strides[leaf].insert(d_strides[leaf].begin(), leaf_strides[leaf][axis]);
+        }
+
+        if (not d_shape.empty())
+        {
+            d_length = d_shape.back();
+            d_shape.pop_back();
+
+            for (size_t leaf = 0; leaf < leaves; ++leaf)
+            {
+                d_steps[leaf] = d_strides[leaf].back();
+                d_strides[leaf].pop_back();
+            }
+        }
+    }
+
+    size_t Plan::size() const
+    {
+        return d_size;
+    }
+
+    size_t Plan::length() const
+    {
+        return d_length;
+    }
+
+    Dims const &Plan::strides(size_t leaf) const
+    {
+        return d_strides[leaf];
+    }
+
+    size_t Plan::step(size_t leaf) const
+    {
+        return d_steps[leaf];
+    }
+
+    Dims Plan::coord(size_t run) const
+    {
+        Dims coord(d_shape.size());
+        for (size_t axis = d_shape.size(); axis-- > 0;)
+        {
+            coord[axis] = run % d_shape[axis];
+            run /= d_shape[axis];
+        }
+
+        return coord;
+    }
+
+    void Plan::next(Dims &coord) const
+    {
+        for (size_t axis = d_shape.size(); axis-- > 0;)
+        {
+            if (++coord[axis] < d_shape[axis])
+                return;
+            coord[axis] = 0;
+        }
+    }
+}
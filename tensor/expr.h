@@ -0,0 +1,571 @@
+#ifndef INCLUDED_EXPR
+#define INCLUDED_EXPR
+
+#include "tensor.h"
+
+#include <algorithm>
+#include <concepts>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace autodiff
+{
+    // Lazy element-wise expressions. The arithmetic operators, maximum,
+    // minimum and the comparisons build a tree of nodes that holds its
+    // tensor operands by value (sharing their buffers, so temporaries
+    // cannot dangle). Nothing is computed until the tree is converted to a
+    // Tensor, reduced with sum() or applied to a tensor with a compound
+    // operator; it is then evaluated in one broadcast-aware pass, block by
+    // block, so intermediates stay in cache.
+    namespace expr
+    {
+        // elements evaluated per node at a time
+        inline constexpr size_t block = 256;
+
+        // elements summed serially into one partial by sum() and
+        // Tensor::sum(); fixed so results do not depend on the thread count
+        inline constexpr size_t sum_block = 4096;
+
+        // --- expr.cc
+        // Shape of lhs op rhs, throws for incompatible shapes.
+        Dims broadcast_shape(Dims const &lhs, Dims const &rhs);
+
+        // Strides of t broadcast to shape: 0 on size-1 and missing axes.
+        Dims broadcast_strides(Tensor const &t, Dims const &shape);
+
+        // True if a and b share memory without being the same view.
+        bool partially_overlaps(Tensor const &a, Tensor const &b);
+
+        // Throws invalid_argument if target has a broadcast axis (stride 0,
+        // size > 1), whose elements alias each other: an in-place op would
+        // apply once per alias, and race once split over the pool.
+        void check_writable(Tensor const &target);
+
+        // Traversal of a row-major result shared by all leaves of a tree:
+        // size-1 axes are dropped and axes contiguous for every leaf are
+        // collapsed, as in BroadcastIterator; the last remaining axis is
+        // the inner run.
+        class Plan
+        {
+            Dims                d_shape;        // outer axes
+            std::vector<Dims>   d_strides;      // per leaf, outer axes
+            std::vector<size_t> d_steps;        // per leaf, inner axis
+            size_t              d_length = 1;
+            size_t              d_size;
+
+        public:
+            Plan(Dims const &shape, std::vector<Dims> const &leaf_strides);
+
+            size_t size()   const;              // elements of the result
+            size_t length() const;              // elements per run
+
+            Dims const &strides(size_t leaf) const;
+            size_t step(size_t leaf) const;
+
+            Dims coord(size_t run) const;       // outer coordinates of a run
+            void next(Dims &coord) const;
+        };
+        // /-- expr.cc
+
+        class Leaf
+        {
+            Tensor d_tensor;
+            Dims   d_strides;                   // set by bind()
+            size_t d_step   = 0;
+            size_t d_offset = 0;
+
+        public:
+            using ExprNode = void;
+            static constexpr size_t slots = 0;  // scratch blocks for children
+            static constexpr size_t nodes = 1;
+
+            explicit Leaf(Tensor const &tensor)
+            :
+                d_tensor(tensor)
+            {}
+
+            Dims const &shape() const { return d_tensor.shape(); }
+            Tensor const &tensor() const { return d_tensor; }
+
+            // inner step, 0 when the leaf is broadcast along the run
+            size_t step() const { return d_step; }
+            double front() const { return d_tensor.data()[d_offset]; }
+
+            template <typename Fn>
+            void leaves(Fn &&fn) { fn(*this); }
+            template <typename Fn>
+            void leaves(Fn &&fn) const { fn(*this); }
+
+            void bind(Dims const &strides, size_t step)
+            {
+                d_strides = strides;
+                d_step    = step;
+            }
+
+            void seek(Dims const &coord, size_t pos)
+            {
+                d_offset = pos * d_step;
+                for (size_t axis = 0; axis < coord.size(); ++axis)
+                    d_offset += coord[axis] * d_strides[axis];
+            }
+
+            // Returns the next n values, in place when they are contiguous
+            double const *eval(size_t n, double *out, double *)
+            {
+                double const *src = d_tensor.data() + d_offset;
+                d_offset += n * d_step;
+
+                if (d_step == 1)
+                    return src;
+
+                if (d_step == 0)
+                    std::fill_n(out, n, *src);
+                else
+                    for (size_t i = 0; i < n; ++i)
+                        out[i] = src[i * d_step];
+                return out;
+            }
+        };
+
+        struct Scalar
+        {
+            using ExprNode = void;
+            static constexpr size_t slots = 0;
+            static constexpr size_t nodes = 1;
+
+            double value;
+
+            Dims shape() const { return {}; }
+
+            template <typename Fn>
+            void leaves(Fn &&) {}
+            template <typename Fn>
+            void leaves(Fn &&) const {}
+
+            double const *eval(size_t n, double *out, double *)
+            {
+                std::fill_n(out, n, value);
+                return out;
+            }
+        };
+
+        template <typename E>
+        double sum(E node);
+
+        // Op must provide the run() overloads of the ops:: functors
+        template <typename Op, typename L, typename R>
+        class Binary
+        {
+            L    d_lhs;
+            R    d_rhs;
+            Dims d_shape;
+
+        public:
+            using ExprNode = void;
+            // an output block for each child plus what the children need
+            static constexpr size_t slots = 2 + L::slots + R::slots;
+            static constexpr size_t nodes = 1 + L::nodes + R::nodes;
+
+            Binary(L lhs, R rhs)
+            :
+                d_lhs(std::move(lhs)),
+                d_rhs(std::move(rhs)),
+                d_shape(broadcast_shape(d_lhs.shape(), d_rhs.shape()))
+            {}
+
+            Dims const &shape() const { return d_shape; }
+
+            template <typename Fn>
+            void leaves(Fn &&fn)
+            {
+                d_lhs.leaves(fn);
+                d_rhs.leaves(fn);
+            }
+
+            template <typename Fn>
+            void leaves(Fn &&fn) const
+            {
+                d_lhs.leaves(fn);
+                d_rhs.leaves(fn);
+            }
+
+            double const *eval(size_t n, double *out, double *scratch)
+            {
+                double *lhs_out     = scratch;
+                double *lhs_scratch = lhs_out + block;
+                double *rhs_out     = lhs_scratch + L::slots * block;
+                double *rhs_scratch = rhs_out + block;
+
+                // scalars and leaves broadcast along the run go to the
+                // scalar kernel instead of being spread over a block
+                double const *lhs = d_lhs.eval(n, lhs_out, lhs_scratch);
+                if constexpr (std::same_as<R, Scalar>)
+                    Op::run(lhs, d_rhs.value, out, n);
+                else if constexpr (std::same_as<R, Leaf>)
+                {
+                    if (d_rhs.step() == 0)
+                        Op::run(lhs, d_rhs.front(), out, n);
+                    else
+                        Op::run(lhs, d_rhs.eval(n, rhs_out, rhs_scratch), out, n);
+                }
+                else
+                    Op::run(lhs, d_rhs.eval(n, rhs_out, rhs_scratch), out, n);
+                return out;
+            }
+
+            double sum() const
+            {
+                return expr::sum(*this);
+            }
+
+            Binary<ops::Pow, Binary, Scalar> power(double exponent) const
+            {
+                return {*this, Scalar{exponent}};
+            }
+        };
+
+        template <typename T>
+        concept Operand = Node<T> or std::same_as<T, Tensor> or std::is_arithmetic_v<T>;
+
+        template <typename L, typename R>
+        concept Operands = Operand<L> and Operand<R>
+                       and not (std::is_arithmetic_v<L> and std::is_arithmetic_v<R>);
+
+        inline Leaf wrap(Tensor const &tensor)
+        {
+            return Leaf{tensor};
+        }
+
+        inline Scalar wrap(double value)
+        {
+            return Scalar{value};
+        }
+
+        template <Node E>
+        E const &wrap(E const &node)
+        {
+            return node;
+        }
+
+        template <typename Op, typename L, typename R>
+        auto make(L const &lhs, R const &rhs)
+        {
+            using LNode = std::remove_cvref_t<decltype(wrap(lhs))>;
+            using RNode = std::remove_cvref_t<decltype(wrap(rhs))>;
+            return Binary<Op, LNode, RNode>{wrap(lhs), wrap(rhs)};
+        }
+
+        // Binds the leaves of node to a traversal of shape
+        template <typename E>
+        Plan bind(E &node, Dims const &shape)
+        {
+            std::vector<Dims> strides;
+            node.leaves([&](Leaf const &leaf) {
+                strides.push_back(broadcast_strides(leaf.tensor(), shape));
+            });
+
+            Plan plan{shape, strides};
+
+            size_t index = 0;
+            node.leaves([&](Leaf &leaf) {
+                leaf.bind(plan.strides(index), plan.step(index));
+                ++index;
+            });
+
+            return plan;
+        }
+
+        // Evaluates elements [first, last) of the flattened result in order,
+        // calling sink(index, values, n) per block. With a dest the root
+        // writes its blocks straight to dest + index.
+        template <typename E, typename Sink>
+        void evaluate(E node, Plan const &plan, size_t first, size_t last,
+                      double *dest, Sink &&sink)
+        {
+            alignas(64) double scratch[(E::slots + 1) * block];
+            double *root_out = scratch + E::slots * block;
+
+            size_t const length = plan.length();
+            size_t pos = first % length;
+            Dims coord = plan.coord(first / length);
+
+            auto seek = [&] {
+                node.leaves([&](Leaf &leaf) { leaf.seek(coord, pos); });
+            };
+            seek();
+
+            while (first < last)
+            {
+                size_t const n = std::min({block, length - pos, last - first});
+                double *out = dest ? dest + first : root_out;
+
+                sink(first, node.eval(n, out, scratch), n);
+
+                first += n;
+                pos   += n;
+                if (pos == length and first < last)
+                {
+                    pos = 0;
+                    plan.next(coord);
+                    seek();
+                }
+            }
+        }
+
+        // ops evaluated per element of node
+        template <typename E>
+        inline constexpr size_t operations = (E::nodes - 1) / 2;
+
+        // bytes of the tensors node reads
+        template <typename E>
+        size_t leaf_bytes(E const &node)
+        {
+            size_t bytes = 0;
+            node.leaves([&bytes](Leaf const &leaf) {
+                bytes += leaf.tensor().size() * sizeof(double);
+            });
+            return bytes;
+        }
+
+        // node evaluated into a new contiguous tensor
+        template <typename E>
+        Tensor materialize(E node)
+        {
+            profile::Record record{"expression"};
+
+            Tensor result{node.shape(), uninitialized};
+            double *dest = result.data();
+
+            Plan const plan = bind(node, node.shape());
+            size_t const size = plan.size();
+            if (record)
+                record.describe({node.shape()}, {
+                    .elements      = size,
+                    .flops         = size * operations<E>,
+                    .bytes_read    = leaf_bytes(node),
+                    .bytes_written = size * sizeof(double),
+                });
+
+            parallel::parallel_for(0, size, parallel::grain_size(size, E::nodes),
+                [&](size_t first, size_t last) {
+                    evaluate(node, plan, first, last, dest,
+                        [dest](size_t index, double const *values, size_t n) {
+                            if (values != dest + index)
+                                std::copy_n(values, n, dest + index);
+                        });
+                });
+
+            return result;
+        }
+
+        // target = target op node, node must broadcast into target
+        template <typename Op, typename E>
+        void update(Tensor &target, E node)
+        {
+            profile::Record record{"compound"};
+            if (record)
+                record.describe({target.shape(), node.shape()}, {
+                    .elements      = target.size(),
+                    .flops         = target.size() * (operations<E> + 1),
+                    .bytes_read    = leaf_bytes(node) + target.size() * sizeof(double),
+                    .bytes_written = target.size() * sizeof(double),
+                });
+
+            if (broadcast_shape(target.shape(), node.shape()) != target.shape())
+                throw std::invalid_argument("rhs cannot be broadcast into lhs");
+            check_writable(target);
+
+            // leaves reading target at other positions would see updated
+            // values, so such trees are evaluated into a temporary first
+            bool overlaps = false;
+            node.leaves([&](Leaf const &leaf) {
+                overlaps = overlaps or partially_overlaps(leaf.tensor(), target);
+            });
+            if (overlaps)
+                return update<Op>(target, wrap(Tensor{node}));
+
+            // results are written by flat index, so strided targets get
+            // theirs through a contiguous temporary
+            if (not target.is_contiguous())
+            {
+                Tensor view = target;
+                std::move(view) = Tensor{make<Op>(target, node)};
+                return;
+            }
+
+            Plan const plan = bind(node, target.shape());
+            size_t const size = plan.size();
+            double *dest = target.data();
+
+            parallel::parallel_for(0, size, parallel::grain_size(size, E::nodes + 1),
+                [&](size_t first, size_t last) {
+                    evaluate(node, plan, first, last, nullptr,
+                        [dest](size_t index, double const *values, size_t n) {
+                            Op::run(dest + index, values, dest + index, n);
+                        });
+                });
+        }
+
+        // Sums in the same blocks and order as Tensor::sum, so the fused
+        // reduction matches summing the materialized result bit for bit
+        template <typename E>
+        double sum(E node)
+        {
+            profile::Record record{"sum"};
+
+            Plan const plan = bind(node, node.shape());
+            size_t const size   = plan.size();
+            size_t const blocks = (size + sum_block - 1) / sum_block;
+            if (record)
+                record.describe({node.shape()}, {
+                    .elements      = 1,
+                    .flops         = size * (operations<E> + 1),
+                    .bytes_read    = leaf_bytes(node),
+                    .bytes_written = sizeof(double),
+                });
+
+            std::vector<double> partial(blocks);
+            parallel::parallel_for(0, blocks, parallel::grain_size(blocks, sum_block * E::nodes),
+                [&](size_t first, size_t last) {
+                    for (size_t index = first; index < last; ++index)
+                    {
+                        double acc = 0;
+                        evaluate(node, plan, index * sum_block,
+                                 std::min(size, (index + 1) * sum_block), nullptr,
+                            [&acc](size_t, double const *values, size_t n) {
+                                for (size_t i = 0; i < n; ++i)
+                                    acc += values[i];
+                            });
+                        partial[index] = acc;
+                    }
+                });
+
+            return std::accumulate(partial.begin(), partial.end(), 0.0);
+        }
+    }
+
+    template <expr::Node E>
+    Tensor::Tensor(E const &node)
+    :
+        Tensor(expr::materialize(node))
+    {}
+
+    template <expr::Node E>
+    Tensor &Tensor::operator+=(E const &node)
+    {
+        expr::update<ops::Add>(*this, node);
+        return *this;
+    }
+
+    template <expr::Node E>
+    Tensor &Tensor::operator-=(E const &node)
+    {
+        expr::update<ops::Sub>(*this, node);
+        return *this;
+    }
+
+    template <expr::Node E>
+    Tensor &Tensor::operator*=(E const &node)
+    {
+        expr::update<ops::Mul>(*this, node);
+        return *this;
+    }
+
+    template <expr::Node E>
+    Tensor &Tensor::operator/=(E const &node)
+    {
+        expr::update<ops::Div>(*this, node);
+        return *this;
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator+(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Add>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator-(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Sub>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator*(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Mul>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator/(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Div>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto maximum(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Max>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto minimum(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Min>(lhs, rhs);
+    }
+
+    // Element-wise comparisons: 1.0 where they hold, 0.0 elsewhere. Like
+    // the arithmetic operators they build expressions, so == and != of
+    // tensors do not yield a bool.
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator>(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Greater>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator>=(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::GreaterEqual>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator<(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Less>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator<=(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::LessEqual>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator==(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::Equal>(lhs, rhs);
+    }
+
+    template <typename L, typename R>
+        requires expr::Operands<L, R>
+    auto operator!=(L const &lhs, R const &rhs)
+    {
+        return expr::make<ops::NotEqual>(lhs, rhs);
+    }
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include "tensor.ih"
+#include "basic_tensor.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace autodiff
+{
+    namespace
+    {
+        char const magic[8] = {'A', 'D', 'T', 'E', 'N', 'S', 'O', 'R'};
+        uint32_t const version = 1;
+
+        // element types, one per tensor class
+        enum class DType : uint32_t
+        {
+            float64  = 1,
+            float32  = 2,
+            bfloat16 = 3,
+            float16  = 4,
+            int32    = 5,
+        };
+
+        template <typename T>
+        constexpr DType dtype_of()
+        {
+            if constexpr (is_same_v<T, double>)
+                return DType::float64;
+            else if constexpr (is_same_v<T, float>)
+                return DType::float32;
+            else if constexpr (is_same_v<T, bfloat16>)
+                return DType::bfloat16;
+            else if constexpr (is_same_v<T, float16>)
+                return DType::float16;
+            else
+            {
+                static_assert(is_same_v<T, int32_t>, "no tensor file element type");
+                return DType::int32;
+            }
+        }
+
+        // axes stored in the header, whatever the rank
+        size_t const header_rank = 8;
+        static_assert(Dims::max_rank <= header_rank);
+
+        // offset of the payload is rounded up to this
+        size_t const payload_alignment = 64;
+
+        struct Header
+        {
+            char     magic[8];
+            uint32_t version;
+            DType    dtype;
+            uint64_t rank;
+            uint64_t offset;                    // of the payload, in bytes
+            uint64_t elements;                  // in the payload
+            uint64_t shape[header_rank];
+            uint64_t strides[header_rank];
+        };
+
+        size_t const payload_offset = (sizeof(Header) + payload_alignment - 1)
+                                    / payload_alignment * payload_alignment;
+
+        [[noreturn]] void throw_invalid(string const &path, string const &why)
+        {
+            throw runtime_error(path + " is not a valid tensor file: " + why);
+        }
+
+        // payloads are padded to whole doubles, so every file maps as a
+        // memory::Buffer
+        size_t payload_bytes(size_t elements, size_t element_bytes)
+        {
+            return (elements * element_bytes + sizeof(double) - 1)
+                   / sizeof(double) * sizeof(double);
+        }
+
+        // Writes elements of element_bytes each, laid out by strides
+        void write(string const &path, DType dtype, Dims const &shape, Dims const &strides,
+                   void const *payload, size_t elements, size_t element_bytes)
+        {
+            // load rejects rank 0, so such files would not read back
+            if (shape.size() == 0)
+                throw runtime_error("cannot write tensor file " + path + ": rank 0");
+
+            Header header{};
+            memcpy(header.magic, magic, sizeof magic);
+            header.version  = version;
+            header.dtype    = dtype;
+            header.rank     = shape.size();
+            header.offset   = payload_offset;
+            header.elements = elements;
+            for (size_t axis = 0; axis < shape.size(); ++axis)
+            {
+                header.shape[axis]   = shape[axis];
+                header.strides[axis] = strides[axis];
+            }
+
+            size_t const bytes = elements * element_bytes;
+
+            ofstream out{path, ios::binary | ios::trunc};
+            char const padding[payload_alignment] = {};
+            out.write(reinterpret_cast<char const *>(&header), sizeof header);
+            out.write(padding, payload_offset - sizeof header);
+            out.write(static_cast<char const *>(payload), bytes);
+            out.write(padding, payload_bytes(elements, element_bytes) - bytes);
+
+            if (not out.flush())
+                throw runtime_error("cannot write tensor file " + path);
+        }
+
+        TensorFile parse(char const *data, size_t size, string const &path,
+                         DType dtype, size_t element_bytes)
+        {
+            if (size < sizeof(Header))
+                throw_invalid(path, "too short");
+
+            Header header;
+            memcpy(&header, data, sizeof header);
+
+            if (memcmp(header.magic, magic, sizeof magic) != 0)
+                throw_invalid(path, "bad magic");
+            if (header.version != version)
+                throw_invalid(path, "unsupported version " + to_string(header.version));
+            if (header.dtype < DType::float64 or header.dtype > DType::int32)
+                throw_invalid(path, "unsupported element type");
+            if (header.dtype != dtype)
+                throw_invalid(path, "element type differs from the one requested");
+            if (header.rank == 0 or header.rank > Dims::max_rank)
+                throw_invalid(path, "rank " + to_string(header.rank));
+            if (header.offset % payload_alignment != 0
+                or header.offset > size
+                or header.elements > (size - header.offset) / element_bytes
+                or payload_bytes(header.elements, element_bytes) > size - header.offset)
+                throw_invalid(path, "payload exceeds the file");
+
+            TensorFile result{{}, {}, header.offset, header.elements};
+            size_t elements = 1;
+            size_t last     = 0;                // offset of the last element
+            for (size_t axis = 0; axis < header.rank; ++axis)
+            {
+                // bounded by the payload, so the products below cannot overflow
+                if (header.shape[axis] == 0 or header.shape[axis] > header.elements / elements
+                    or header.strides[axis] > header.elements)
+                    throw_invalid(path, "shape and strides do not match the payload");
+
+                result.shape.push_back(header.shape[axis]);
+                result.strides.push_back(header.strides[axis]);
+                elements *= header.shape[axis];
+                last     += (header.shape[axis] - 1) * header.strides[axis];
+            }
+            if (elements != header.elements or last >= header.elements)
+                throw_invalid(path, "shape and strides do not match the payload");
+
+            return result;
+        }
+    }
+
+    void save(Tensor const &tensor, string const &path)
+    {
+        auto [first, last] = extent(tensor);
+        Tensor const dense = static_cast<size_t>(last - first) == tensor.size()
+                           ? tensor : tensor.contiguous();
+        tie(first, last) = extent(dense);
+
+        write(path, DType::float64, dense.shape(), dense.strides(),
+              first, last - first, sizeof(double));
+    }
+
+    template <typename T>
+    void save(BasicTensor<T> const &tensor, string const &path)
+    {
+        write(path, dtype_of<T>(), tensor.shape(), calculate_strides(tensor.shape()),
+              tensor.data(), tensor.size(), sizeof(T));
+    }
+
+    size_t tensor_header_bytes()
+    {
+        return sizeof(Header);
+    }
+
+    TensorFile parse_tensor_header(char const *data, size_t size, string const &path)
+    {
+        return parse(data, size, path, DType::float64, sizeof(double));
+    }
+
+    Tensor load(string const &path)
+    {
+        auto mapping = make_shared<memory::Mapping>(path);
+        TensorFile const file = parse_tensor_header(mapping->data(), mapping->size(), path);
+
+        return Tensor{file.shape, file.strides,
+                      memory::map(std::move(mapping), file.offset, file.elements),
+                      0, file.elements};
+    }
+
+    template <typename T>
+    BasicTensor<T> load(string const &path)
+    {
+        auto mapping = make_shared<memory::Mapping>(path);
+        TensorFile const file = parse(mapping->data(), mapping->size(), path,
+                                      dtype_of<T>(), sizeof(T));
+
+        // BasicTensor has no strides of its own
+        if (file.strides != calculate_strides(file.shape))
+            throw_invalid(path, "not stored in row-major order");
+
+        return BasicTensor<T>{file.shape,
+                              memory::map(std::move(mapping), file.offset,
+                                          payload_bytes(file.elements, sizeof(T)) / sizeof(double))};
+    }
+
+#define AUTODIFF_INSTANTIATE(T)                                     \
+    template void save(BasicTensor<T> const &, string const &);    \
+    template BasicTensor<T> load(string const &);
+
+    AUTODIFF_INSTANTIATE(float)
+    AUTODIFF_INSTANTIATE(bfloat16)
+    AUTODIFF_INSTANTIATE(float16)
+    AUTODIFF_INSTANTIATE(int32_t)
+
+#undef AUTODIFF_INSTANTIATE
+}
@@ -4,64 +4,176 @@ namespace autodiff
 {
     namespace
     {
-        void throw_concatenation_dim_mismatch_error(size_t dim, size_t lhs_shape, size_t rhs_shape)
+        // elements copied by one task at most
+        size_t const copy_block = 16384;
+
+        void throw_concatenation_dim_mismatch_error(size_t dim, size_t index,
+                                                    size_t first_shape, size_t shape)
         {
             string error_msg = "all the input array dimensions except for the concatenation axis must "
                                 "match exactly, but along dimension " + to_string(dim) +
-                                ", the array at index 0 has size " + to_string(lhs_shape) +
-                                " and the array at index 1 has size " + to_string(rhs_shape);
+                                ", the array at index 0 has size " + to_string(first_shape) +
+                                " and the array at index " + to_string(index) + " has size " +
+                                to_string(shape);
             throw runtime_error(error_msg);
         }
 
-        void throw_rank_mismatch_error(size_t lhs_rank, size_t rhs_rank) {
+        void throw_rank_mismatch_error(size_t index, size_t first_rank, size_t rank) {
             string error_msg = "all the input arrays must have same number of dimensions, "
-                                "the array at index 0 has " + to_string(lhs_rank) + " dimension(s), "
-                                "the array at index 1 has " + to_string(rhs_rank) + " dimension(s)";
+                                "the array at index 0 has " + to_string(first_rank) + " dimension(s), "
+                                "the array at index " + to_string(index) + " has " +
+                                to_string(rank) + " dimension(s)";
             throw runtime_error(error_msg);
         }
-    }
 
-    Tensor maximum(Tensor const &lhs, Tensor const &rhs)
-    {
-        return operation(lhs, rhs, [](double a, double b){
-            return a > b ? a : b;
-        });
-    }
+        Dims concatenated_shape(span<Tensor const> tensors, size_t axis)
+        {
+            Dims const &first = tensors[0].shape();
+            if (axis >= first.size())
+                throw invalid_argument("axis " + to_string(axis)
+                                       + " out of range for rank " + to_string(first.size()));
 
-    Tensor concatenate(Tensor const &lhs, Tensor const &rhs, optional<size_t> axis)
-    {
-        if (lhs.rank() != rhs.rank())
-            throw_rank_mismatch_error(lhs.rank(), rhs.rank());
+            Dims result = first;
+            for (size_t index = 1; index < tensors.size(); ++index)
+            {
+                Dims const &shape = tensors[index].shape();
+                if (shape.size() != first.size())
+                    throw_rank_mismatch_error(index, first.size(), shape.size());
+
+                for (size_t dim = 0; dim < shape.size(); ++dim)
+                    if (dim == axis)
+                        result[dim] += shape[dim];
+                    else if (shape[dim] != first[dim])
+                        throw_concatenation_dim_mismatch_error(dim, index, first[dim], shape[dim]);
+            }
+            return result;
+        }
 
-        auto const &lhs_shape = lhs.shape();
-        auto const &rhs_shape = rhs.shape();
+        // One input walked in the runs of its own strides, each cut into
+        // blocks of at most copy_block elements: tasks [first, first +
+        // runs * blocks) of the copy
+        struct Part
+        {
+            BroadcastIterator iter;             // res: destination, lhs: input
+            double const     *src;
+            double           *dst;
+            size_t            blocks;           // per run
+            size_t            first;
+        };
 
-        vector<size_t> res_shape;
+        void copy_run(double const *src, size_t src_step, double *dst, size_t dst_step,
+                      size_t size)
+        {
+            if (src_step == 1 and dst_step == 1)
+                copy_n(src, size, dst);
+            else
+                for (size_t i = 0; i < size; ++i)
+                    dst[i * dst_step] = src[i * src_step];
+        }
 
-        if (axis.has_value())
+        // tasks [first, last) of part
+        void copy_part(Part const &part, size_t first, size_t last)
         {
-            res_shape.reserve(lhs.rank());
-            for (size_t dim = 0; dim < lhs.rank(); ++dim)
+            size_t const length = part.iter.length();
+
+            BroadcastIterator iter = part.iter;
+            size_t run = (first - part.first) / part.blocks;
+            iter.seek(run);
+
+            for (size_t task = first; task < last; ++task)
             {
-                if (dim == axis.value())
-                    res_shape.push_back(lhs_shape[dim] + rhs_shape[dim]);
-                else
-                {
-                    if (lhs_shape[dim] != rhs_shape[dim])
-                        throw_concatenation_dim_mismatch_error(dim, lhs_shape[dim], rhs_shape[dim]);
+                for (; run < (task - part.first) / part.blocks; ++run)
+                    iter.next();
 
-                    res_shape.push_back(lhs.shape()[dim]);
-                }
+                size_t const start = (task - part.first) % part.blocks * copy_block;
+                copy_run(part.src + iter.lhs() + start * iter.lhs_step(), iter.lhs_step(),
+                         part.dst + iter.res() + start * iter.res_step(), iter.res_step(),
+                         std::min(copy_block, length - start));
             }
         }
-        else
-            res_shape = {lhs.size() + rhs.size()};
+    }
+
+    // Every input is copied into its slice of the result (its stretch of
+    // the flat result without an axis), reading it through its own
+    // strides. The blocks of all inputs are copied by one parallel_for.
+    Tensor concatenate(span<Tensor const> tensors, optional<size_t> axis)
+    {
+        if (tensors.empty())
+            throw invalid_argument("need at least one tensor to concatenate");
+
+        profile::Record record{"concatenate"};
 
-        vector<double> res(lhs.size() + rhs.size());
+        size_t total = 0;
+        for (Tensor const &tensor : tensors)
+            total += tensor.size();
 
-        copy(lhs.cbegin(), lhs.cend(), res.begin());
-        copy(rhs.cbegin(), rhs.cend(), res.begin() + lhs.size());
+        Dims const res_shape = axis.has_value() ? concatenated_shape(tensors, *axis) : Dims{total};
+
+        Tensor res{res_shape, uninitialized};
+        if (record)
+            record.describe({tensors[0].shape(), res_shape}, {
+                .elements      = total,
+                .bytes_read    = total * sizeof(double),
+                .bytes_written = total * sizeof(double),
+            });
+
+        vector<Part> parts;
+        parts.reserve(tensors.size());
+        size_t offset = 0;
+        size_t tasks  = 0;
+        for (Tensor const &tensor : tensors)
+        {
+            Tensor const src = tensor.rank() == 0 ? tensor.unsqueeze(0) : tensor;
+            size_t const dim = axis.has_value() ? src.shape()[*axis] : src.size();
+            Tensor dst = axis.has_value()
+                         ? res.slice(*axis, offset, offset + dim)
+                         : res.slice(0, offset, offset + dim).reshape(src.shape());
+
+            BroadcastIterator const iter{src.shape(), dst.strides(), src.strides(), src.strides()};
+            size_t const blocks = (iter.length() + copy_block - 1) / copy_block;
+            parts.push_back({iter, src.data(), dst.data(), blocks, tasks});
+
+            tasks  += iter.runs() * blocks;
+            offset += dim;
+        }
+
+        parallel::parallel_for(0, tasks, parallel::grain_size(tasks, total / tasks),
+            [&parts](size_t first, size_t last) {
+                auto part = prev(upper_bound(parts.begin(), parts.end(), first,
+                    [](size_t task, Part const &part) { return task < part.first; }));
+
+                for (; first < last; ++part)
+                {
+                    size_t const end
+                        = std::min(last, part->first + part->iter.runs() * part->blocks);
+                    copy_part(*part, first, end);
+                    first = end;
+                }
+            });
+
+        return res;
+    }
+
+    Tensor concatenate(Tensor const &lhs, Tensor const &rhs, optional<size_t> axis)
+    {
+        Tensor const pair[] = {lhs, rhs};
+        return concatenate(pair, axis);
+    }
+
+    Tensor stack(span<Tensor const> tensors, size_t axis)
+    {
+        if (tensors.empty())
+            throw invalid_argument("need at least one tensor to stack");
+
+        vector<Tensor> expanded;
+        expanded.reserve(tensors.size());
+        for (Tensor const &tensor : tensors)
+        {
+            if (tensor.shape() != tensors[0].shape())
+                throw invalid_argument("all the input arrays must have the same shape to stack");
+            expanded.push_back(tensor.unsqueeze(axis));
+        }
 
-        return Tensor{move(res_shape), move(res)};
+        return concatenate(expanded, axis);
     }
 }
@@ -0,0 +1,188 @@
+#include "tensor.ih"
+#include "reader.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace autodiff
+{
+    namespace
+    {
+        bool is_row_major(TensorFile const &file)
+        {
+            Dims const expected = calculate_strides(file.shape);
+            for (size_t axis = 0; axis < file.shape.size(); ++axis)
+                if (file.shape[axis] != 1 and file.strides[axis] != expected[axis])
+                    return false;
+            return true;
+        }
+    }
+
+    BatchReader::BatchReader(string const &path, size_t batch_size, size_t prefetch)
+    :
+        d_batch_size(batch_size),
+        d_prefetch(max<size_t>(prefetch, 1))
+    {
+        if (batch_size == 0)
+            throw invalid_argument("batch size must be positive");
+
+        if (filesystem::is_directory(path))
+        {
+            vector<string> files;
+            for (auto const &entry : filesystem::directory_iterator{path})
+                if (entry.is_regular_file())
+                    files.push_back(entry.path().string());
+
+            sort(files.begin(), files.end());
+            for (string const &file : files)
+                add_shard(file);
+        }
+        else
+            add_shard(path);
+
+        if (d_shards.empty())
+            throw runtime_error("no tensor files in " + path);
+
+        d_thread = thread{&BatchReader::read, this};
+    }
+
+    BatchReader::~BatchReader()
+    {
+        {
+            lock_guard lock{d_mutex};
+            d_stop = true;
+        }
+        d_changed.notify_all();
+        d_thread.join();
+    }
+
+    // Only the header is read here; the rows are left to the thread
+    void BatchReader::add_shard(string const &path)
+    {
+        ifstream in{path, ios::binary};
+        if (not in)
+            throw runtime_error("cannot open " + path);
+
+        size_t const size = filesystem::file_size(path);
+        string header(min(size, tensor_header_bytes()), '\0');
+        in.read(header.data(), header.size());
+
+        TensorFile const file = parse_tensor_header(header.data(), size, path);
+        if (not is_row_major(file))
+            throw runtime_error(path + " is not stored in row-major order");
+
+        Dims row_shape = file.shape;
+        row_shape.erase(row_shape.begin());
+        if (d_shards.empty())
+        {
+            d_row_shape = row_shape;
+            d_row_size  = file.elements / file.shape[0];
+        }
+        else if (row_shape != d_row_shape)
+            throw runtime_error("rows of " + path + " do not match those of "
+                                + d_shards.front().path);
+
+        d_shards.push_back({path, file.offset, file.shape[0]});
+        d_rows += file.shape[0];
+    }
+
+    void BatchReader::read()
+    {
+        try
+        {
+            size_t const row_bytes = d_row_size * sizeof(double);
+            size_t shard = 0;
+            size_t row   = 0;                   // next row of the shard
+            ifstream in;
+
+            for (size_t first = 0; first < d_rows; first += d_batch_size)
+            {
+                size_t const count = min(d_batch_size, d_rows - first);
+
+                Dims shape = d_row_shape;
+                shape.insert(shape.begin(), count);
+                Tensor batch{shape, uninitialized};
+                char *out = reinterpret_cast<char *>(batch.data());
+
+                // a batch may span the end of one shard and the start of the next
+                for (size_t filled = 0; filled < count;)
+                {
+                    if (row == d_shards[shard].rows)
+                    {
+                        ++shard;
+                        row = 0;
+                        in.close();
+                    }
+                    Shard const &current = d_shards[shard];
+                    if (not in.is_open())
+                    {
+                        in.open(current.path, ios::binary);
+                        in.seekg(current.offset);
+                    }
+
+                    size_t const take = min(count - filled, current.rows - row);
+                    in.read(out + filled * row_bytes, take * row_bytes);
+                    if (not in)
+                        throw runtime_error("cannot read rows of " + current.path);
+
+                    filled += take;
+                    row    += take;
+                }
+
+                unique_lock lock{d_mutex};
+                d_changed.wait(lock, [this] { return d_stop or d_ready.size() < d_prefetch; });
+                if (d_stop)
+                    return;
+
+                d_ready.push_back(batch);
+                lock.unlock();
+                d_changed.notify_all();
+            }
+        }
+        catch (...)
+        {
+            lock_guard lock{d_mutex};
+            d_error = current_exception();
+        }
+
+        {
+            lock_guard lock{d_mutex};
+            d_done = true;
+        }
+        d_changed.notify_all();
+    }
+
+    optional<Tensor> BatchReader::next()
+    {
+        unique_lock lock{d_mutex};
+        d_changed.wait(lock, [this] { return not d_ready.empty() or d_done; });
+
+        if (d_ready.empty())
+        {
+            if (d_error)
+                rethrow_exception(exchange(d_error, nullptr));
+            return nullopt;
+        }
+
+        Tensor batch = d_ready.front();
+        d_ready.pop_front();
+        lock.unlock();
+        d_changed.notify_all();
+        return batch;
+    }
+
+    Dims const &BatchReader::row_shape() const
+    {
+        return d_row_shape;
+    }
+
+    size_t BatchReader::rows() const
+    {
+        return d_rows;
+    }
+
+    size_t BatchReader::batches() const
+    {
+        return (d_rows + d_batch_size - 1) / d_batch_size;
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef INCLUDED_READER
+#define INCLUDED_READER
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tensor.h"
+
+namespace autodiff
+{
+    // Streams mini-batches of rows (slices along axis 0) out of tensor
+    // files written by save(): a single file, or every file of a directory
+    // in name order, read as one sequence of rows. The shards must be
+    // contiguous and agree on every dimension but the first.
+    //
+    // A background thread reads the next batches with plain file reads
+    // while the caller computes on the current one. It holds at most
+    // prefetch + 1 batches, so memory stays bounded whatever the size of
+    // the data set. Every batch has batch_size rows except possibly the
+    // last; a new reader starts a new epoch.
+    class BatchReader
+    {
+        struct Shard
+        {
+            std::string path;
+            size_t      offset;                 // of the payload, in bytes
+            size_t      rows;
+        };
+
+        std::vector<Shard> d_shards;
+        Dims               d_row_shape;
+        size_t             d_row_size = 1;      // elements per row
+        size_t             d_rows     = 0;
+        size_t             d_batch_size;
+        size_t             d_prefetch;
+
+        std::mutex              d_mutex;
+        std::condition_variable d_changed;
+        std::deque<Tensor>      d_ready;
+        std::exception_ptr      d_error;
+        bool                    d_done = false;     // the thread has finished
+        bool                    d_stop = false;
+        std::thread             d_thread;           // started last
+
+    public:
+        // Throws runtime_error when a shard is not a contiguous tensor file
+        // or does not match the first
+        BatchReader(std::string const &path, size_t batch_size, size_t prefetch = 2);
+        ~BatchReader();
+
+        BatchReader(BatchReader const &) = delete;
+        BatchReader &operator=(BatchReader const &) = delete;
+
+        // The next batch, or nullopt after the last one. Errors met by the
+        // reading thread are rethrown here once the batches before them
+        // have been returned.
+        std::optional<Tensor> next();
+
+        Dims const &row_shape() const;
+        size_t rows() const;                    // in all shards
+        size_t batches() const;
+
+    private:
+        void add_shard(std::string const &path);
+        void read();
+    };
+}
+
+#endif
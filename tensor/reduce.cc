@@ -0,0 +1,446 @@
+#include "tensor.ih"
+
+namespace autodiff
+{
+    namespace
+    {
+        // runs up to this length are summed by the SIMD kernel directly
+        size_t const pairwise_block = 256;
+
+        // elements reduced serially into one partial of a long run
+        size_t const run_block = 4096;
+
+        // columns combined at once when the kept axes are innermost
+        size_t const column_block = 256;
+
+        // error grows with log(size) instead of size
+        double pairwise_sum(double const *x, size_t size)
+        {
+            if (size <= pairwise_block)
+                return simd::sum(x, size);
+
+            size_t const half = size / 2;
+            return pairwise_sum(x, half) + pairwise_sum(x + half, size - half);
+        }
+
+        // A reduction: combine() folds two values, run() a contiguous run
+        // and rows() a row into an accumulator row, element-wise.
+        struct Sum
+        {
+            static double combine(double x, double y) { return x + y; }
+
+            static double run(double const *x, size_t size)
+            {
+                return pairwise_sum(x, size);
+            }
+
+            static void rows(double const *x, double *acc, size_t size)
+            {
+                simd::add(acc, x, acc, size);
+            }
+        };
+
+        struct Prod
+        {
+            static double combine(double x, double y) { return x * y; }
+
+            static double run(double const *x, size_t size)
+            {
+                return accumulate(x, x + size, 1.0, multiplies<double>());
+            }
+
+            static void rows(double const *x, double *acc, size_t size)
+            {
+                simd::mul(acc, x, acc, size);
+            }
+        };
+
+        struct Max
+        {
+            static double combine(double x, double y) { return x > y ? x : y; }
+
+            static double run(double const *x, size_t size)
+            {
+                return simd::max(x, size);
+            }
+
+            static void rows(double const *x, double *acc, size_t size)
+            {
+                simd::max(acc, x, acc, size);
+            }
+        };
+
+        struct Min
+        {
+            static double combine(double x, double y) { return x < y ? x : y; }
+
+            static double run(double const *x, size_t size)
+            {
+                return simd::min(x, size);
+            }
+
+            static void rows(double const *x, double *acc, size_t size)
+            {
+                simd::min(acc, x, acc, size);
+            }
+        };
+
+        // Axes of a strided walk, outermost first. Adjacent axes that are
+        // contiguous with each other are merged and size-1 axes dropped.
+        struct Axes
+        {
+            Dims shape;
+            Dims strides;
+
+            void push(size_t dim, size_t stride)
+            {
+                if (dim == 1)
+                    return;
+
+                if (not shape.empty() and strides.back() == stride * dim)
+                {
+                    shape.back()  *= dim;
+                    strides.back() = stride;
+                    return;
+                }
+
+                shape.push_back(dim);
+                strides.push_back(stride);
+            }
+
+            size_t size() const
+            {
+                return elements(shape);
+            }
+
+            // offset of the index-th element in row-major order
+            size_t offset(size_t index) const
+            {
+                size_t result = 0;
+                for (size_t axis = shape.size(); axis-- > 0;)
+                {
+                    result += index % shape[axis] * strides[axis];
+                    index  /= shape[axis];
+                }
+                return result;
+            }
+        };
+
+        // An odometer over Axes, advanced by addition
+        class Cursor
+        {
+            Axes const &d_axes;
+            Dims        d_coord;
+            size_t      d_offset = 0;
+
+        public:
+            Cursor(Axes const &axes, size_t index)
+            :
+                d_axes(axes),
+                d_coord(axes.shape.size()),
+                d_offset(axes.offset(index))
+            {
+                for (size_t axis = axes.shape.size(); axis-- > 0;)
+                {
+                    d_coord[axis] = index % axes.shape[axis];
+                    index /= axes.shape[axis];
+                }
+            }
+
+            size_t offset() const
+            {
+                return d_offset;
+            }
+
+            void next()
+            {
+                for (size_t axis = d_coord.size(); axis-- > 0;)
+                {
+                    d_offset += d_axes.strides[axis];
+                    if (++d_coord[axis] < d_axes.shape[axis])
+                        return;
+
+                    d_offset -= d_coord[axis] * d_axes.strides[axis];
+                    d_coord[axis] = 0;
+                }
+            }
+        };
+
+        struct Layout
+        {
+            Axes kept;
+            Axes reduced;
+            Dims shape;                 // of the result
+        };
+
+        Layout layout(Tensor const &tensor, Dims const &axes, bool keepdims)
+        {
+            size_t const rank = tensor.rank();
+            vector<bool> reduce(rank, axes.empty());
+            for (size_t axis : axes)
+            {
+                if (axis >= rank)
+                    throw invalid_argument("axis " + to_string(axis)
+                                           + " out of range for rank " + to_string(rank));
+                if (reduce[axis])
+                    throw invalid_argument("axis " + to_string(axis) + " reduced twice");
+                reduce[axis] = true;
+            }
+
+            Layout result;
+            for (size_t axis = 0; axis < rank; ++axis)
+            {
+                size_t const dim    = tensor.shape()[axis];
+                size_t const stride = tensor.strides()[axis];
+                if (reduce[axis])
+                {
+                    result.reduced.push(dim, stride);
+                    if (keepdims)
+                        result.shape.push_back(1);
+                }
+                else
+                {
+                    result.kept.push(dim, stride);
+                    result.shape.push_back(dim);
+                }
+            }
+
+            if (result.shape.empty())
+                result.shape.push_back(1);
+            return result;
+        }
+
+        // The reduced elements of each output form one contiguous run.
+        // Long runs are split into fixed blocks whose partials are reduced
+        // again, so every output is computed the same way whatever the
+        // thread count, and the blocks of all runs are spread over the pool.
+        template <typename Op>
+        void reduce_runs(double const *in, Layout const &lay, double *out)
+        {
+            size_t const outputs = lay.kept.size();
+            size_t const length  = lay.reduced.shape[0];
+            size_t const blocks  = (length + run_block - 1) / run_block;
+
+            if (blocks == 1)
+            {
+                parallel::parallel_for(0, outputs, parallel::grain_size(outputs, length),
+                    [in, out, length, &lay](size_t first, size_t last) {
+                        for (size_t index = first; index < last; ++index)
+                            out[index] = Op::run(in + lay.kept.offset(index), length);
+                    });
+                return;
+            }
+
+            size_t const tasks = outputs * blocks;
+            vector<double> partial(tasks);
+            parallel::parallel_for(0, tasks, parallel::grain_size(tasks, run_block),
+                [&](size_t first, size_t last) {
+                    for (size_t task = first; task < last; ++task)
+                    {
+                        size_t const start = task % blocks * run_block;
+                        double const *run  = in + lay.kept.offset(task / blocks);
+                        partial[task] = Op::run(run + start, std::min(length, start + run_block) - start);
+                    }
+                });
+
+            for (size_t index = 0; index < outputs; ++index)
+                out[index] = Op::run(partial.data() + index * blocks, blocks);
+        }
+
+        // Sums rows [first, first + count) of the reduced walk into acc,
+        // pairwise so that the error grows with log(count)
+        template <typename Op>
+        void fold_rows(double const *in, Axes const &rows, size_t first, size_t count,
+                       double *acc, size_t width)
+        {
+            if (count <= 8)
+            {
+                Cursor row{rows, first};
+                copy(in + row.offset(), in + row.offset() + width, acc);
+                for (size_t index = 1; index < count; ++index)
+                {
+                    row.next();
+                    Op::rows(in + row.offset(), acc, width);
+                }
+                return;
+            }
+
+            size_t const half = count / 2;
+            double rest[column_block];
+            fold_rows<Op>(in, rows, first, half, acc, width);
+            fold_rows<Op>(in, rows, first + half, count - half, rest, width);
+            Op::rows(rest, acc, width);
+        }
+
+        // The innermost kept axis is contiguous: whole rows of it are
+        // combined element-wise, in parallel over blocks of columns.
+        template <typename Op>
+        void reduce_columns(double const *in, Layout const &lay, double *out)
+        {
+            Axes outer = lay.kept;
+            size_t const columns = outer.shape.back();
+            outer.shape.pop_back();
+            outer.strides.pop_back();
+
+            size_t const rows    = lay.reduced.size();
+            size_t const blocks  = (columns + column_block - 1) / column_block;
+            size_t const tasks   = outer.size() * blocks;
+
+            parallel::parallel_for(0, tasks, parallel::grain_size(tasks, column_block * rows),
+                [&](size_t first, size_t last) {
+                    for (size_t task = first; task < last; ++task)
+                    {
+                        size_t const index = task / blocks;
+                        size_t const start = task % blocks * column_block;
+                        size_t const width = std::min(columns, start + column_block) - start;
+
+                        fold_rows<Op>(in + outer.offset(index) + start, lay.reduced, 0, rows,
+                                      out + index * columns + start, width);
+                    }
+                });
+        }
+
+        // Any other layout: each output walks its reduced elements
+        template <typename Op>
+        void reduce_strided(double const *in, Layout const &lay, double *out)
+        {
+            size_t const outputs = lay.kept.size();
+            size_t const count   = lay.reduced.size();
+
+            parallel::parallel_for(0, outputs, parallel::grain_size(outputs, count),
+                [&](size_t first, size_t last) {
+                    for (size_t index = first; index < last; ++index)
+                    {
+                        double const *base = in + lay.kept.offset(index);
+                        Cursor element{lay.reduced, 0};
+                        double acc = base[element.offset()];
+                        for (size_t step = 1; step < count; ++step)
+                        {
+                            element.next();
+                            acc = Op::combine(acc, base[element.offset()]);
+                        }
+                        out[index] = acc;
+                    }
+                });
+        }
+
+        // Kahan summation for strided sums, which cannot be blocked
+        template <>
+        void reduce_strided<Sum>(double const *in, Layout const &lay, double *out)
+        {
+            size_t const outputs = lay.kept.size();
+            size_t const count   = lay.reduced.size();
+
+            parallel::parallel_for(0, outputs, parallel::grain_size(outputs, count),
+                [&](size_t first, size_t last) {
+                    for (size_t index = first; index < last; ++index)
+                    {
+                        double const *base = in + lay.kept.offset(index);
+                        Cursor element{lay.reduced, 0};
+                        double acc          = 0;
+                        double compensation = 0;
+                        for (size_t step = 0; step < count; ++step, element.next())
+                        {
+                            double const y = base[element.offset()] - compensation;
+                            double const t = acc + y;
+                            compensation   = (t - acc) - y;
+                            acc            = t;
+                        }
+                        out[index] = acc;
+                    }
+                });
+        }
+
+        template <typename Op>
+        Tensor reduce(char const *name, Tensor const &tensor, Dims const &axes, bool keepdims)
+        {
+            profile::Record record{name};
+
+            Layout const lay = layout(tensor, axes, keepdims);
+            Tensor result{lay.shape, uninitialized};
+            if (record)
+                record.describe({tensor.shape(), result.shape()}, {
+                    .elements      = result.size(),
+                    .flops         = tensor.size(),
+                    .bytes_read    = tensor.size() * sizeof(double),
+                    .bytes_written = result.size() * sizeof(double),
+                });
+
+            double const *in = tensor.data();
+            double *out      = result.data();
+
+            if (lay.reduced.shape.size() == 1 and lay.reduced.strides[0] == 1)
+                reduce_runs<Op>(in, lay, out);
+            else if (not lay.reduced.shape.empty() and not lay.kept.shape.empty()
+                     and lay.kept.strides.back() == 1)
+                reduce_columns<Op>(in, lay, out);
+            else
+                reduce_strided<Op>(in, lay, out);
+
+            return result;
+        }
+    }
+
+    Tensor Tensor::sum(Dims const &axes, bool keepdims) const
+    {
+        return reduce<Sum>("sum axes", *this, axes, keepdims);
+    }
+
+    Tensor Tensor::mean(Dims const &axes, bool keepdims) const
+    {
+        Tensor result = reduce<Sum>("mean", *this, axes, keepdims);
+        result /= static_cast<double>(size() / result.size());
+        return result;
+    }
+
+    Tensor Tensor::prod(Dims const &axes, bool keepdims) const
+    {
+        return reduce<Prod>("prod", *this, axes, keepdims);
+    }
+
+    Tensor Tensor::max(Dims const &axes, bool keepdims) const
+    {
+        return reduce<Max>("max", *this, axes, keepdims);
+    }
+
+    Tensor Tensor::min(Dims const &axes, bool keepdims) const
+    {
+        return reduce<Min>("min", *this, axes, keepdims);
+    }
+
+    Tensor Tensor::argmax(size_t axis, bool keepdims) const
+    {
+        profile::Record record{"argmax"};
+
+        Layout const lay = layout(*this, {axis}, keepdims);
+        Tensor result{lay.shape, uninitialized};
+        if (record)
+            record.describe({d_shape, result.shape()}, {
+                .elements      = result.size(),
+                .flops         = size(),
+                .bytes_read    = size() * sizeof(double),
+                .bytes_written = result.size() * sizeof(double),
+            });
+
+        double const *in    = data();
+        double *out         = result.data();
+        size_t const length = d_shape[axis];
+        size_t const stride = d_strides[axis];
+        size_t const outputs = lay.kept.size();
+
+        parallel::parallel_for(0, outputs, parallel::grain_size(outputs, length),
+            [&](size_t first, size_t last) {
+                for (size_t index = first; index < last; ++index)
+                {
+                    double const *base = in + lay.kept.offset(index);
+                    size_t best = 0;
+                    for (size_t step = 1; step < length; ++step)
+                        if (base[step * stride] > base[best * stride])
+                            best = step;
+                    out[index] = static_cast<double>(best);
+                }
+            });
+
+        return result;
+    }
+}
@@ -14,73 +14,68 @@ namespace autodiff
 
             throw invalid_argument(error_msg);
         }
+    }
 
-        vector<size_t> calculate_strides(vector<size_t> const &shape, size_t start_ix = 0)
-        {
-            size_t size = shape.size() - start_ix;
-            vector<size_t> strides(size);
-
-            size_t acc = 1;
-            for (size_t dim = size; dim-- > 0;)
-            {
-                strides[dim] = acc;
-                acc *= shape[start_ix + dim];
-            }
+    Dims calculate_strides(Dims const &shape, size_t start_ix)
+    {
+        size_t size = shape.size() - start_ix;
+        Dims strides(size);
 
-            return strides;
+        size_t acc = 1;
+        for (size_t dim = size; dim-- > 0;)
+        {
+            strides[dim] = acc;
+            acc *= shape[start_ix + dim];
         }
+
+        return strides;
     }
 
-    Tensor::Tensor(vector<size_t> &&shape, double value)
+    Tensor::Tensor(Dims const &shape, double value)
     :
-        d_data(make_shared<vector<double>>(
-            accumulate(shape.begin(), shape.end(), 1, multiplies<size_t>()),
-            value
-        )),
-        d_strides(calculate_strides(shape)),
-        d_shape(std::move(shape)),
-        d_length(d_data->size())
+        Tensor(shape, uninitialized)
     {
-        assert(not d_shape.empty() and "shape cannot be empty");
-        assert(find(d_shape.begin(), d_shape.end(), 0) == d_shape.end() and "invalid dimension 0");
+        fill(begin(), end(), value);
     }
 
-    Tensor::Tensor(vector<size_t> const &shape, double value)
+    Tensor::Tensor(Dims const &shape)
     :
-        Tensor(vector<size_t>(shape), value)
+        Tensor(shape, 0.0)
     {}
 
-    Tensor::Tensor(vector<size_t> &&shape)
+    Tensor::Tensor(Dims const &shape, vector<double> &&data)
     :
-        Tensor(std::move(shape), 0.0)
-    {}
-
-    Tensor::Tensor(vector<size_t> const &shape)
-    :
-        Tensor(vector<size_t>(shape))
-    {}
+        Tensor(shape, uninitialized)
+    {
+        assert(data.size() == d_length and "data does not match shape");
+        copy(data.begin(), data.end(), begin());
+    }
 
-    Tensor::Tensor(vector<size_t> &&shape, vector<double> &&data)
+    Tensor::Tensor(Dims const &shape, Uninitialized)
     :
-        d_data(make_shared<vector<double>>(std::move(data))),
+        d_data(memory::allocate(elements(shape))),
         d_strides(calculate_strides(shape)),
-        d_shape(std::move(shape)),
+        d_shape(shape),
         d_length(d_data->size())
     {
         assert(not d_shape.empty() and "shape cannot be empty");
         assert(find(d_shape.begin(), d_shape.end(), 0) == d_shape.end() and "invalid dimension 0");
-        assert(accumulate(d_shape.begin(), d_shape.end(), 1, multiplies<size_t>()) and
-            "invalid shape");
     }
 
-    Tensor::Tensor(vector<size_t> const &shape, vector<double> &&data)
+    Tensor::Tensor(Dims const &shape, DataPtr buffer, size_t offset)
     :
-        Tensor(vector<size_t>(shape), std::move(data))
-    {}
+        d_data(std::move(buffer)),
+        d_strides(calculate_strides(shape)),
+        d_shape(shape),
+        d_offset(offset),
+        d_length(elements(shape))
+    {
+        assert(d_offset + d_length <= d_data->size() and "view exceeds buffer");
+    }
 
     Tensor::Tensor(
-        vector<size_t> &&shape,
-        vector<size_t> &&strides,
+        Dims const &shape,
+        Dims const &strides,
         DataPtr data,
         size_t offset,
         size_t length)
@@ -103,8 +98,8 @@ namespace autodiff
             throw_out_of_bound_error(0, d_shape[0] - 1, idx);
 
         return Tensor{
-            vector<size_t>(d_shape.begin() + 1, d_shape.end()),
-            vector<size_t>(d_strides.begin() + 1, d_strides.end()),
+            Dims(d_shape.begin() + 1, d_shape.end()),
+            Dims(d_strides.begin() + 1, d_strides.end()),
             d_data,
             d_offset + d_strides[0] * idx,
             d_length / d_shape[0]
@@ -118,9 +113,10 @@ namespace autodiff
 
     Tensor &Tensor::operator=(double val)
     {
-        for_each(begin(), end(), [val](double &old) {
-            old = val;
-        });
+        if (is_contiguous())
+            fill_n(data(), d_length, val);
+        else
+            fill(begin(), end(), val);
 
         return *this;
     }
@@ -136,7 +132,8 @@ namespace autodiff
             if (t.d_shape[ix++] != dim) throw invalid_argument("incompatible shape");
         });
 
-        copy(t.cbegin(), t.cend(), begin());
+        expr::check_writable(*this);
+        copy_elements(t, *this);
 
         return *this;
     }
@@ -151,17 +148,18 @@ namespace autodiff
             if (t.d_shape[ix++] != dim) throw invalid_argument("incompatible shape");
         });
 
-        copy(t.cbegin(), t.cend(), begin());
+        expr::check_writable(*this);
+        copy_elements(t, *this);
 
         return *this;
     }
 
-    vector<size_t> const &Tensor::shape() const
+    Dims const &Tensor::shape() const
     {
         return d_shape;
     }
 
-    vector<size_t> const &Tensor::strides() const
+    Dims const &Tensor::strides() const
     {
         return d_strides;
     }
@@ -190,22 +188,32 @@ namespace autodiff
 
     Tensor::DataConstIter Tensor::cbegin() const
     {
-        return d_data->cbegin() + d_offset;
+        return {data(), d_shape, d_strides, 0, is_contiguous()};
     }
 
     Tensor::DataConstIter Tensor::cend() const
     {
-        return d_data->cbegin() + d_offset + d_length;
+        return {data(), d_shape, d_strides, d_length, is_contiguous()};
+    }
+
+    double *Tensor::data()
+    {
+        return d_data->data() + d_offset;
+    }
+
+    double const *Tensor::data() const
+    {
+        return d_data->data() + d_offset;
     }
 
     Tensor::DataIter Tensor::begin()
     {
-        return d_data->begin() + d_offset;
+        return {data(), d_shape, d_strides, 0, is_contiguous()};
     }
 
     Tensor::DataIter Tensor::end()
     {
-        return d_data->begin() + d_offset + d_length;
+        return {data(), d_shape, d_strides, d_length, is_contiguous()};
     }
 
     void swap(Tensor& a, Tensor& b) noexcept
@@ -217,46 +225,30 @@ namespace autodiff
         std::swap(a.d_length,  b.d_length);
     }
 
+    // Walked on the calling thread: callbacks may keep state and need not
+    // be safe to call concurrently
     Tensor operation(Tensor const &lhs, Tensor const &rhs, function<double(double, double)> operator_)
     {
-        BroadcastPlan plan = prepare_broadcast(lhs, rhs);
-
-        auto const &lhs_strides = plan.lhs_strides;
-        auto const &rhs_strides = plan.rhs_strides;
-        auto const &res_strides = plan.res_strides;
-
-        auto &res_shape   = plan.res_shape;
-
-        auto const &lhs_data = lhs.cbegin();
-        auto const &rhs_data = rhs.cbegin();
-
-        size_t rank = res_shape.size();
-        size_t res_size = accumulate(res_shape.begin(), res_shape.end(), 1, multiplies<size_t>());
+        profile::Record record{"operation"};
 
-        vector<double> res(res_size);
-
-        size_t i_lhs = 0;
-        size_t i_rhs = 0;
-
-        for (size_t i = 0; i < res_size; ++i)
-        {
-            i_lhs = 0;
-            i_rhs = 0;
-
-            size_t j = i;
-            for (size_t axis = 0; axis < rank; ++axis)
-            {
-                size_t coord = j / res_strides[axis];
-                j = j % res_strides[axis];
-
-                i_lhs += coord * lhs_strides[axis];
-                i_rhs += coord * rhs_strides[axis];
-            }
-
-            res[i] = operator_(lhs_data[i_lhs], rhs_data[i_rhs]);
-        }
-
-        return Tensor{std::move(res_shape), std::move(res)};
+        BroadcastPlan plan = prepare_broadcast(lhs, rhs);
+        BroadcastIterator iter{plan};
+
+        Tensor res{plan.res_shape, uninitialized};
+        if (record)
+            record.describe({lhs.shape(), rhs.shape()}, {
+                .elements      = res.size(),
+                .flops         = res.size(),
+                .bytes_read    = (lhs.size() + rhs.size()) * sizeof(double),
+                .bytes_written = res.size() * sizeof(double),
+            });
+
+        for (size_t run = 0; run < iter.runs(); ++run, iter.next())
+            detail::apply_run(operator_, res.data() + iter.res(),
+                              lhs.data() + iter.lhs(), rhs.data() + iter.rhs(),
+                              iter.length(), iter.res_step(), iter.lhs_step(), iter.rhs_step());
+
+        return res;
     }
 
     ostream &operator<<(ostream &out, Tensor const &t)
@@ -272,28 +264,31 @@ namespace autodiff
         out << ")\n[";
         if (t.rank() > 1) out << "\n";
 
+        // row boundaries follow the printed order, not the memory layout
+        Dims const strides = calculate_strides(t.shape());
+
         size_t ix = 0;
-        for_each(t.cbegin(), t.cend(), [&ix, &t, &out](double val) {
+        for_each(t.cbegin(), t.cend(), [&ix, &t, &strides, &out](double val) {
             size_t rem = ix;
             string open, close;
             for (size_t dim = 0; dim < t.rank() - 1; ++dim)
             {
                 size_t dim_inv = t.rank() - 2 - dim;
-                if (ix > 0 and rem % t.strides()[dim_inv] == 0)
+                if (ix > 0 and rem % strides[dim_inv] == 0)
                 {
                     if (dim_inv != t.rank() - 2)
                         close += string(3 * (dim_inv + 1), ' ');
                     close += "]\n";
                 }
 
-                if (rem % t.strides()[dim] == 0)
+                if (rem % strides[dim] == 0)
                 {
                     open += string(3 * (dim + 1), ' ') + "[";
                     if (dim != t.rank() - 2)
                         open += "\n";
                 }
 
-                rem %= t.strides()[dim];
+                rem %= strides[dim];
             }
 
             out << close << open << val;
@@ -2,62 +2,189 @@
 #define INCLUDED_TENSOR
 
 #include <cstddef>
+#include <cmath>
 #include <tuple>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
 #include <functional>
+#include <iterator>
+#include <numeric>
+
+#include "dims.h"
+
+#include "../simd/simd.h"
+#include "../parallel/parallel.h"
+#include "../memory/memory.h"
+#include "../profile/profile.h"
 
 namespace autodiff
 {
+    // Selects the Tensor constructor that leaves the elements unset, for
+    // kernels that write every element of their result.
+    struct Uninitialized {};
+    inline constexpr Uninitialized uninitialized{};
+
+    namespace expr
+    {
+        // A node of a lazy element-wise expression, see expr.h
+        template <typename T>
+        concept Node = requires { typename T::ExprNode; };
+    }
+
+    // Random-access iterator over the elements of a tensor in row-major
+    // order. Contiguous tensors are walked by index; other views map each
+    // index through their strides. Valid while the tensor is alive and
+    // unchanged.
+    template <typename T>
+    class ElementIterator
+    {
+        T          *d_base    = nullptr;
+        Dims const *d_shape   = nullptr;
+        Dims const *d_strides = nullptr;
+        size_t      d_index   = 0;
+        bool        d_contiguous = true;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = std::remove_const_t<T>;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = T *;
+        using reference         = T &;
+
+        ElementIterator() = default;
+        ElementIterator(T *base, Dims const &shape, Dims const &strides,
+                        size_t index, bool contiguous)
+        :
+            d_base(base),
+            d_shape(&shape),
+            d_strides(&strides),
+            d_index(index),
+            d_contiguous(contiguous)
+        {}
+
+        reference operator*() const
+        {
+            if (d_contiguous)
+                return d_base[d_index];
+
+            size_t offset = 0;
+            size_t index  = d_index;
+            for (size_t axis = d_shape->size(); axis-- > 0;)
+            {
+                offset += index % (*d_shape)[axis] * (*d_strides)[axis];
+                index  /= (*d_shape)[axis];
+            }
+            return d_base[offset];
+        }
+
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        ElementIterator &operator++()   { ++d_index; return *this; }
+        ElementIterator &operator--()   { --d_index; return *this; }
+        ElementIterator operator++(int) { ElementIterator old = *this; ++d_index; return old; }
+        ElementIterator operator--(int) { ElementIterator old = *this; --d_index; return old; }
+
+        ElementIterator &operator+=(difference_type n) { d_index += n; return *this; }
+        ElementIterator &operator-=(difference_type n) { d_index -= n; return *this; }
+
+        friend ElementIterator operator+(ElementIterator it, difference_type n) { return it += n; }
+        friend ElementIterator operator+(difference_type n, ElementIterator it) { return it += n; }
+        friend ElementIterator operator-(ElementIterator it, difference_type n) { return it -= n; }
+
+        friend difference_type operator-(ElementIterator const &lhs, ElementIterator const &rhs)
+        {
+            return static_cast<difference_type>(lhs.d_index)
+                 - static_cast<difference_type>(rhs.d_index);
+        }
+
+        friend bool operator==(ElementIterator const &lhs, ElementIterator const &rhs)
+        {
+            return lhs.d_index == rhs.d_index;
+        }
+
+        friend auto operator<=>(ElementIterator const &lhs, ElementIterator const &rhs)
+        {
+            return lhs.d_index <=> rhs.d_index;
+        }
+    };
+
     class Tensor
     {
-        using DataPtr       = std::shared_ptr<std::vector<double>>;
-        using DataIter      = std::vector<double>::iterator;
-        using DataConstIter = std::vector<double>::const_iterator;
+        using DataPtr       = std::shared_ptr<memory::Buffer>;
+        using DataIter      = ElementIterator<double>;
+        using DataConstIter = ElementIterator<double const>;
 
         DataPtr             d_data;
-        std::vector<size_t> d_strides;
-        std::vector<size_t> d_shape;
+        Dims                d_strides;
+        Dims                d_shape;
         size_t              d_offset = 0;
         size_t              d_length;
 
     public:
         Tensor(Tensor const &t) = default;
 
-        Tensor(std::vector<size_t> &&shape);
-        Tensor(std::vector<size_t> const &shape);
-        Tensor(std::vector<size_t> &&shape, double value);
-        Tensor(std::vector<size_t> const &shape, double value);
-        Tensor(std::vector<size_t> &&shape, std::vector<double> &&data);
-        Tensor(std::vector<size_t> const &shape, std::vector<double> &&data);
+        Tensor(Dims const &shape);
+        Tensor(Dims const &shape, double value);
+        Tensor(Dims const &shape, std::vector<double> &&data);
+        Tensor(Dims const &shape, Uninitialized);
+        template <expr::Node E>
+        Tensor(E const &node);                  // evaluates node
+        // contiguous view of shape over buffer, starting at offset
+        Tensor(Dims const &shape, DataPtr buffer, size_t offset);
         ~Tensor();
 
     private:
         Tensor(
-            std::vector<size_t> &&shape,
-            std::vector<size_t> &&strides,
+            Dims const &shape,
+            Dims const &strides,
             DataPtr data,
             size_t  offset,
             size_t  length);
 
     public:
 
-        std::vector<size_t> const &shape()      const;
-        std::vector<size_t> const &strides()    const;
+        Dims const &shape()      const;
+        Dims const &strides()    const;
 
         size_t rank() const;
         size_t size() const;
 
+        // True when the elements are laid out densely in row-major order
+        bool is_contiguous() const;
+        // This tensor if it is contiguous, otherwise a contiguous copy
+        Tensor contiguous() const;
+
+        // Views: the result shares this tensor's buffer, writes through it
+        // are visible in both. Axes out of range throw invalid_argument.
+        Tensor slice(size_t axis, size_t start, size_t stop, size_t step = 1) const;
+        Tensor transpose() const;                       // reverses the axes
+        Tensor transpose(size_t axis1, size_t axis2) const;
+        Tensor permute(Dims const &axes) const;         // axis i of the result is axes[i]
+        Tensor expand(Dims const &shape) const;         // broadcast to shape, stride 0
+        Tensor squeeze() const;                         // drops every size-1 axis
+        Tensor squeeze(size_t axis) const;
+        Tensor unsqueeze(size_t axis) const;            // inserts a size-1 axis
+        // A view when the strides allow it, otherwise a copy
+        Tensor reshape(Dims const &shape) const;
+
         double scalar() const;
         double &scalar();
 
         DataConstIter cbegin()   const;
         DataConstIter cend()     const;
 
+        // first element; further elements are at the offsets given by
+        // strides(), which are only row-major when is_contiguous()
+        double       *data();
+        double const *data()     const;
+
         Tensor operator[](size_t idx) &;
         Tensor operator[](size_t idx) &&;
-        Tensor operator()(size_t idx1, size_t idx2, ...);
+        template <std::convertible_to<size_t> ...Idx>
+        Tensor operator()(size_t idx, Idx ...rest);
 
         Tensor &operator=(double value);
         Tensor &operator=(Tensor &&t) & = default;
@@ -66,18 +193,44 @@ namespace autodiff
 
         Tensor &operator+=(Tensor const &rhs);
         Tensor &operator+=(double number);
+        template <expr::Node E>
+        Tensor &operator+=(E const &node);
 
         Tensor &operator-=(Tensor const &rhs);
         Tensor &operator-=(double number);
+        template <expr::Node E>
+        Tensor &operator-=(E const &node);
 
         Tensor &operator*=(Tensor const &rhs);
         Tensor &operator*=(double number);
+        template <expr::Node E>
+        Tensor &operator*=(E const &node);
 
         Tensor &operator/=(Tensor const &rhs);
         Tensor &operator/=(double number);
+        template <expr::Node E>
+        Tensor &operator/=(E const &node);
+
+        // Fused updates: one pass that reads x and *this and writes *this.
+        // x must have the same shape; if it partially overlaps *this it is
+        // read from a copy.
+        Tensor &axpy(double alpha, Tensor const &x);                        // *this += alpha * x
+        Tensor &scale_add(double alpha, double beta, Tensor const &x);      // *this = alpha * *this + beta * x
 
         double sum() const;
 
+        // Reductions over axes, or over every axis when axes is empty. The
+        // reduced axes are dropped, or kept with size 1 with keepdims; with
+        // every axis dropped the result has shape {1}. Sums are pairwise.
+        Tensor sum(Dims const &axes, bool keepdims = false) const;
+        Tensor mean(Dims const &axes = {}, bool keepdims = false) const;
+        Tensor prod(Dims const &axes = {}, bool keepdims = false) const;
+        Tensor max(Dims const &axes = {}, bool keepdims = false) const;
+        Tensor min(Dims const &axes = {}, bool keepdims = false) const;
+
+        // Index of the first maximum along axis
+        Tensor argmax(size_t axis, bool keepdims = false) const;
+
         // -- check
         Tensor &power(double num);
 
@@ -88,43 +241,457 @@ namespace autodiff
         void compatible(Tensor const &other) const;
 
         friend void swap(Tensor& a, Tensor& b) noexcept;
+        friend Tensor load(std::string const &path);
     };
 
     std::ostream &operator<<(std::ostream &out, autodiff::Tensor const &t);
 
+    // Applies op element-wise over the broadcast of a and b. The template is
+    // preferred for lambdas and functors so op can be inlined into the inner
+    // loop; it splits large tensors over the pool, so op is called from
+    // several threads at once. The std::function overload remains for
+    // type-erased callbacks and calls them serially on the calling thread.
+    template <typename Op>
+    Tensor operation(Tensor const &a, Tensor const &b, Op op);
+
+    template <typename Op>
+    concept VectorizedOp = requires(double const *x, double const *y, double *res, size_t size) {
+        Op::run(x, y, res, size);
+        Op::run(x, *y, res, size);
+    };
+
     autodiff::Tensor operation(autodiff::Tensor const &a,
                                autodiff::Tensor const &b,
                                std::function<double(double, double)> op);
 
-    // --- arithmetic.cc
-    Tensor operator+(Tensor const &lhs, Tensor const &rhs);
-    Tensor operator+(Tensor const &lhs, double rhs);
-
-    Tensor operator-(Tensor const &lhs, Tensor const &rhs);
-    Tensor operator-(Tensor const &lhs, double rhs);
-
-    Tensor operator*(Tensor const &lhs, Tensor const &rhs);
-    Tensor operator*(Tensor const &lhs, double rhs);
-
-    Tensor operator/(Tensor const &lhs, Tensor const &rhs);
-    Tensor operator/(Tensor const &lhs, double rhs);
-    // /-- arithmetic.cc
+    // Built-in element-wise ops. run() dispatches contiguous runs to the
+    // SIMD kernel for the host (see simd/simd.h).
+    namespace ops
+    {
+        struct Add
+        {
+            double operator()(double x, double y) const { return x + y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::add(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::add(x, y, res, size);
+            }
+        };
+
+        struct Sub
+        {
+            double operator()(double x, double y) const { return x - y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::sub(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::sub(x, y, res, size);
+            }
+        };
+
+        struct Mul
+        {
+            double operator()(double x, double y) const { return x * y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::mul(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::mul(x, y, res, size);
+            }
+        };
+
+        struct Div
+        {
+            double operator()(double x, double y) const { return x / y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::div(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::div(x, y, res, size);
+            }
+        };
+
+        struct Pow
+        {
+            double operator()(double x, double y) const { return std::pow(x, y); }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = std::pow(x[i], y[i]);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                if (y == 2)
+                    return simd::mul(x, x, res, size);
+
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = std::pow(x[i], y);
+            }
+        };
+
+        struct Max
+        {
+            double operator()(double x, double y) const { return x > y ? x : y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::max(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::max(x, y, res, size);
+            }
+        };
+
+        struct Min
+        {
+            double operator()(double x, double y) const { return x < y ? x : y; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                simd::min(x, y, res, size);
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                simd::min(x, y, res, size);
+            }
+        };
+
+        // 1.0 where Pred holds, 0.0 elsewhere; the loops vectorise
+        template <typename Pred>
+        struct Compare
+        {
+            double operator()(double x, double y) const { return Pred{}(x, y) ? 1.0 : 0.0; }
+
+            static void run(double const *x, double const *y, double *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = Pred{}(x[i], y[i]) ? 1.0 : 0.0;
+            }
+
+            static void run(double const *x, double y, double *res, size_t size)
+            {
+                for (size_t i = 0; i < size; ++i)
+                    res[i] = Pred{}(x[i], y) ? 1.0 : 0.0;
+            }
+        };
+
+        using Greater      = Compare<std::greater<>>;
+        using GreaterEqual = Compare<std::greater_equal<>>;
+        using Less         = Compare<std::less<>>;
+        using LessEqual    = Compare<std::less_equal<>>;
+        using Equal        = Compare<std::equal_to<>>;
+        using NotEqual     = Compare<std::not_equal_to<>>;
+    }
+
+    // operator+, -, *, /, maximum, minimum and the comparisons build lazy
+    // expressions, see expr.h
 
     // --- ops.cc
-    Tensor maximum(Tensor const &lhs, Tensor const &rhs);
+    // Joins tensors along an existing axis; every other dimension must
+    // match. Without an axis the tensors are flattened and joined into one
+    // row. The result is allocated once and filled by a single parallel
+    // pass of block copies, whatever the number of inputs.
+    Tensor concatenate(std::span<Tensor const> tensors, std::optional<size_t> axis = 0);
     Tensor concatenate(Tensor const &lhs, Tensor const &rhs, std::optional<size_t> axis = 0);
+
+    // Joins tensors of equal shape along a new axis inserted at axis
+    Tensor stack(std::span<Tensor const> tensors, size_t axis = 0);
     // /-- ops.cc
 
+    // --- io.cc
+    // Binary tensor files: a fixed header with the element type, shape and
+    // strides, then the elements in native byte order at a 64-byte aligned
+    // offset, padded to a multiple of 8 bytes. Views that cover their
+    // elements without gaps (transposes, permutations) are written as they
+    // are laid out; others are made contiguous first. Throws runtime_error
+    // for rank-0 tensors and when the file cannot be written.
+    void save(Tensor const &tensor, std::string const &path);
+
+    // Maps the file and returns a tensor over its elements without copying
+    // or parsing them; see memory::Mapping. Throws runtime_error for files
+    // that are not tensor files or whose header does not fit the payload.
+    Tensor load(std::string const &path);
+    // /-- io.cc
+
+    // --- update.cc
+    // Optimizer steps fused into a single pass over the parameters and
+    // their state. All tensors must have the shape of weights. A grad that
+    // partially overlaps the state is read from a copy; state tensors that
+    // partially overlap each other throw invalid_argument.
+    void momentum_step(Tensor &weights, Tensor const &grad, Tensor &velocity,
+                       double lr, double mu);
+
+    struct AdamOptions
+    {
+        double lr    = 1e-3;
+        double beta1 = 0.9;
+        double beta2 = 0.999;
+        double eps   = 1e-8;
+    };
+
+    // step counts from 1 and drives the bias correction of m and v
+    void adam_step(Tensor &weights, Tensor const &grad, Tensor &m, Tensor &v,
+                   size_t step, AdamOptions const &options = {});
+    // /-- update.cc
+
     struct BroadcastPlan
     {
-        std::vector<size_t> lhs_strides;
-        std::vector<size_t> rhs_strides;
-        std::vector<size_t> res_strides;
-        std::vector<size_t> res_shape;
+        Dims lhs_strides;
+        Dims rhs_strides;
+        Dims res_strides;
+        Dims res_shape;
     };
 
     BroadcastPlan prepare_broadcast(Tensor const &lhs, Tensor const &rhs);
+
+    // Walks a broadcast result in contiguous runs. Size-1 axes are dropped
+    // and trailing axes that are contiguous for every operand are collapsed
+    // into one inner run; the remaining outer axes are advanced as an
+    // odometer, so offsets are updated by addition instead of div/mod.
+    class BroadcastIterator
+    {
+        Dims d_shape;
+        Dims d_res_strides;
+        Dims d_lhs_strides;
+        Dims d_rhs_strides;
+        Dims d_coord;
+
+        size_t d_runs     = 1;
+        size_t d_length   = 1;
+        size_t d_res_step = 0;
+        size_t d_lhs_step = 0;
+        size_t d_rhs_step = 0;
+
+        size_t d_res = 0;
+        size_t d_lhs = 0;
+        size_t d_rhs = 0;
+
+    public:
+        explicit BroadcastIterator(BroadcastPlan const &plan);
+        BroadcastIterator(Dims const &shape,
+                          Dims const &res_strides,
+                          Dims const &lhs_strides,
+                          Dims const &rhs_strides);
+
+        size_t runs()     const;   // number of inner runs
+        size_t length()   const;   // elements per run
+
+        size_t res_step() const;   // inner strides
+        size_t lhs_step() const;
+        size_t rhs_step() const;
+
+        size_t res()      const;   // offsets of the current run
+        size_t lhs()      const;
+        size_t rhs()      const;
+
+        void next();
+        void seek(size_t run);     // jump to the start of a run
+    };
+
+    template <std::convertible_to<size_t> ...Idx>
+    Tensor Tensor::operator()(size_t idx, Idx ...rest)
+    {
+        Tensor view = (*this)[idx];
+        ((view = view[static_cast<size_t>(rest)]), ...);
+        return view;
+    }
+
+    inline size_t BroadcastIterator::runs() const
+    {
+        return d_runs;
+    }
+
+    inline size_t BroadcastIterator::length() const
+    {
+        return d_length;
+    }
+
+    inline size_t BroadcastIterator::res_step() const
+    {
+        return d_res_step;
+    }
+
+    inline size_t BroadcastIterator::lhs_step() const
+    {
+        return d_lhs_step;
+    }
+
+    inline size_t BroadcastIterator::rhs_step() const
+    {
+        return d_rhs_step;
+    }
+
+    inline size_t BroadcastIterator::res() const
+    {
+        return d_res;
+    }
+
+    inline size_t BroadcastIterator::lhs() const
+    {
+        return d_lhs;
+    }
+
+    inline size_t BroadcastIterator::rhs() const
+    {
+        return d_rhs;
+    }
+
+    inline void BroadcastIterator::seek(size_t run)
+    {
+        d_res = d_lhs = d_rhs = 0;
+        for (size_t axis = d_shape.size(); axis-- > 0;)
+        {
+            d_coord[axis] = run % d_shape[axis];
+            run /= d_shape[axis];
+
+            d_res += d_coord[axis] * d_res_strides[axis];
+            d_lhs += d_coord[axis] * d_lhs_strides[axis];
+            d_rhs += d_coord[axis] * d_rhs_strides[axis];
+        }
+    }
+
+    inline void BroadcastIterator::next()
+    {
+        for (size_t axis = d_shape.size(); axis-- > 0;)
+        {
+            if (++d_coord[axis] < d_shape[axis])
+            {
+                d_res += d_res_strides[axis];
+                d_lhs += d_lhs_strides[axis];
+                d_rhs += d_rhs_strides[axis];
+                return;
+            }
+
+            d_coord[axis] = 0;
+            d_res -= d_res_strides[axis] * (d_shape[axis] - 1);
+            d_lhs -= d_lhs_strides[axis] * (d_shape[axis] - 1);
+            d_rhs -= d_rhs_strides[axis] * (d_shape[axis] - 1);
+        }
+    }
+
+    namespace detail
+    {
+        // out[i * res_step] = op(lhs[i * lhs_step], rhs[i * rhs_step]) for
+        // i < length; unit and zero steps get their own loops so they vectorize
+        template <typename Op>
+        void apply_run(Op &op, double *out, double const *lhs, double const *rhs,
+                       size_t length, size_t res_step, size_t lhs_step, size_t rhs_step)
+        {
+            if (res_step != 1)
+            {
+                for (size_t i = 0; i < length; ++i)
+                    out[i * res_step] = op(lhs[i * lhs_step], rhs[i * rhs_step]);
+                return;
+            }
+
+            if constexpr (VectorizedOp<Op>)
+            {
+                if (lhs_step == 1 and rhs_step == 1)
+                    return Op::run(lhs, rhs, out, length);
+                if (lhs_step == 1 and rhs_step == 0)
+                    return Op::run(lhs, *rhs, out, length);
+            }
+
+            if (lhs_step == 1 and rhs_step == 1)
+                for (size_t i = 0; i < length; ++i)
+                    out[i] = op(lhs[i], rhs[i]);
+            else if (lhs_step == 1 and rhs_step == 0)
+            {
+                double const value = *rhs;
+                for (size_t i = 0; i < length; ++i)
+                    out[i] = op(lhs[i], value);
+            }
+            else if (lhs_step == 0 and rhs_step == 1)
+            {
+                double const value = *lhs;
+                for (size_t i = 0; i < length; ++i)
+                    out[i] = op(value, rhs[i]);
+            }
+            else
+                for (size_t i = 0; i < length; ++i)
+                    out[i] = op(lhs[i * lhs_step], rhs[i * rhs_step]);
+        }
+
+        // Applies op over every run of iter on the pool. res may alias lhs
+        // as long as both are walked with the same strides.
+        template <typename Op>
+        void apply_broadcast(BroadcastIterator const &iter, Op &op, double *res_data,
+                             double const *lhs_data, double const *rhs_data)
+        {
+            size_t const length   = iter.length();
+            size_t const res_step = iter.res_step();
+            size_t const lhs_step = iter.lhs_step();
+            size_t const rhs_step = iter.rhs_step();
+
+            // a single run (same-shape contiguous operands) is split by element,
+            // otherwise whole runs are handed out
+            if (iter.runs() == 1)
+                parallel::parallel_for(0, length, parallel::grain_size(length),
+                    [&](size_t first, size_t last) {
+                        apply_run(op, res_data + iter.res() + first * res_step,
+                                  lhs_data + iter.lhs() + first * lhs_step,
+                                  rhs_data + iter.rhs() + first * rhs_step,
+                                  last - first, res_step, lhs_step, rhs_step);
+                    });
+            else
+                parallel::parallel_for(0, iter.runs(), parallel::grain_size(iter.runs(), length),
+                    [&](size_t first, size_t last) {
+                        BroadcastIterator chunk = iter;
+                        chunk.seek(first);
+
+                        for (size_t run = first; run < last; ++run, chunk.next())
+                            apply_run(op, res_data + chunk.res(),
+                                      lhs_data + chunk.lhs(), rhs_data + chunk.rhs(),
+                                      length, res_step, lhs_step, rhs_step);
+                    });
+        }
+    }
+
+    template <typename Op>
+    Tensor operation(Tensor const &lhs, Tensor const &rhs, Op op)
+    {
+        profile::Record record{"operation"};
+
+        BroadcastPlan plan = prepare_broadcast(lhs, rhs);
+        BroadcastIterator const iter{plan};
+
+        Tensor res{plan.res_shape, uninitialized};
+        if (record)
+            record.describe({lhs.shape(), rhs.shape()}, {
+                .elements      = res.size(),
+                .flops         = res.size(),
+                .bytes_read    = (lhs.size() + rhs.size()) * sizeof(double),
+                .bytes_written = res.size() * sizeof(double),
+            });
+
+        detail::apply_broadcast(iter, op, res.data(), lhs.data(), rhs.data());
+
+        return res;
+    }
 }
 
+#include "expr.h"
 
 #endif
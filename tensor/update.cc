@@ -0,0 +1,155 @@
+#include "tensor.ih"
+
+namespace autodiff
+{
+    namespace
+    {
+        // element operations of one Adam update, for the grain size
+        size_t const adam_cost = 8;
+
+        void check_same_shape(Tensor const &lhs, Tensor const &rhs)
+        {
+            if (lhs.shape() != rhs.shape())
+                throw invalid_argument("update operands must have the same shape");
+        }
+
+        // True if grad must be read from a copy: a state tensor partially
+        // overlapping it is written before all of grad is read. State
+        // tensors are all written, so no copy orders two overlapping ones.
+        bool overlaps_state(Tensor const &grad, initializer_list<Tensor const *> state)
+        {
+            bool overlaps = false;
+            for (Tensor const *tensor : state)
+            {
+                overlaps = overlaps or expr::partially_overlaps(grad, *tensor);
+                for (Tensor const *other : state)
+                    if (other != tensor and expr::partially_overlaps(*tensor, *other))
+                        throw invalid_argument("update state tensors must not overlap");
+            }
+            return overlaps;
+        }
+
+        Tensor copy_of(Tensor const &tensor)
+        {
+            Tensor copy{tensor.shape(), uninitialized};
+            copy_elements(tensor, copy);
+            return copy;
+        }
+
+        // Runs step on contiguous stand-ins for the tensors and copies the
+        // updated ones back into strided views, which must be writable
+        template <typename Step>
+        void on_contiguous(Step step, Tensor const &grad, initializer_list<Tensor *> state)
+        {
+            for (Tensor *tensor : state)
+                expr::check_writable(*tensor);
+
+            vector<Tensor> dense;
+            for (Tensor *tensor : state)
+                dense.push_back(tensor->contiguous());
+
+            step(grad.contiguous(), dense);
+
+            size_t index = 0;
+            for (Tensor *tensor : state)
+            {
+                if (not tensor->is_contiguous())
+                    copy_elements(dense[index], *tensor);
+                ++index;
+            }
+        }
+    }
+
+    Tensor &Tensor::axpy(double alpha, Tensor const &x)
+    {
+        return scale_add(1.0, alpha, x);
+    }
+
+    Tensor &Tensor::scale_add(double alpha, double beta, Tensor const &x)
+    {
+        check_same_shape(*this, x);
+
+        // chunks would read elements of x that others have already written
+        if (expr::partially_overlaps(x, *this))
+            return scale_add(alpha, beta, copy_of(x));
+
+        // the fused kernel walks flat buffers; views take the lazy path
+        if (not is_contiguous() or not x.is_contiguous())
+        {
+            expr::check_writable(*this);
+            Tensor view = *this;
+            std::move(view) = Tensor{*this * alpha + x * beta};
+            return *this;
+        }
+
+        double *y         = data();
+        double const *src = x.data();
+        parallel::parallel_for(0, size(), parallel::grain_size(size()),
+            [y, src, alpha, beta](size_t first, size_t last) {
+                simd::axpby(beta, src + first, alpha, y + first, last - first);
+            });
+
+        return *this;
+    }
+
+    void momentum_step(Tensor &weights, Tensor const &grad, Tensor &velocity,
+                       double lr, double mu)
+    {
+        check_same_shape(weights, grad);
+        check_same_shape(weights, velocity);
+
+        if (overlaps_state(grad, {&weights, &velocity}))
+            return momentum_step(weights, copy_of(grad), velocity, lr, mu);
+
+        if (not (weights.is_contiguous() and grad.is_contiguous() and velocity.is_contiguous()))
+            return on_contiguous([lr, mu](Tensor const &g, vector<Tensor> &dense) {
+                momentum_step(dense[0], g, dense[1], lr, mu);
+            }, grad, {&weights, &velocity});
+
+        double *w       = weights.data();
+        double *vel     = velocity.data();
+        double const *g = grad.data();
+        size_t const size = weights.size();
+        parallel::parallel_for(0, size, parallel::grain_size(size),
+            [w, vel, g, lr, mu](size_t first, size_t last) {
+                simd::momentum(g + first, vel + first, w + first, lr, mu, last - first);
+            });
+    }
+
+    void adam_step(Tensor &weights, Tensor const &grad, Tensor &m, Tensor &v,
+                   size_t step, AdamOptions const &options)
+    {
+        check_same_shape(weights, grad);
+        check_same_shape(weights, m);
+        check_same_shape(weights, v);
+        assert(step > 0 and "adam steps count from 1");
+
+        if (overlaps_state(grad, {&weights, &m, &v}))
+            return adam_step(weights, copy_of(grad), m, v, step, options);
+
+        if (not (weights.is_contiguous() and grad.is_contiguous()
+                 and m.is_contiguous() and v.is_contiguous()))
+            return on_contiguous([step, &options](Tensor const &g, vector<Tensor> &dense) {
+                adam_step(dense[0], g, dense[1], dense[2], step, options);
+            }, grad, {&weights, &m, &v});
+
+        double const t = static_cast<double>(step);
+        simd::AdamStep const params{
+            options.lr / (1 - std::pow(options.beta1, t)),
+            options.beta1,
+            options.beta2,
+            options.eps,
+            1 / std::sqrt(1 - std::pow(options.beta2, t)),
+        };
+
+        double *w       = weights.data();
+        double *mom     = m.data();
+        double *var     = v.data();
+        double const *g = grad.data();
+        size_t const size = weights.size();
+        parallel::parallel_for(0, size, parallel::grain_size(size, adam_cost),
+            [w, mom, var, g, &params](size_t first, size_t last) {
+                simd::adam(g + first, mom + first, var + first, w + first, params, last - first);
+            });
+    }
+}
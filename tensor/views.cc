@@ -0,0 +1,252 @@
+#include "tensor.ih"
+
+namespace autodiff
+{
+    namespace
+    {
+        struct Copy
+        {
+            double operator()(double, double value) const { return value; }
+        };
+
+        void check_axis(size_t axis, size_t rank)
+        {
+            if (axis >= rank)
+                throw invalid_argument("axis " + to_string(axis)
+                                       + " out of range for rank " + to_string(rank));
+        }
+
+        // Strides that walk a tensor of shape/strides in the row-major order
+        // of new_shape, if the old axes merged into each new axis are
+        // contiguous with each other (NumPy's no-copy reshape).
+        optional<Dims> reshape_strides(Dims const &shape, Dims const &strides,
+                                       Dims const &new_shape)
+        {
+            Dims old_shape;
+            Dims old_strides;
+            for (size_t axis = 0; axis < shape.size(); ++axis)
+                if (shape[axis] != 1)
+                {
+                    old_shape.push_back(shape[axis]);
+                    old_strides.push_back(strides[axis]);
+                }
+
+            Dims result(new_shape.size(), 1);
+            size_t oi = 0, oj = 1;
+            size_t ni = 0, nj = 1;
+            while (ni < new_shape.size() and oi < old_shape.size())
+            {
+                size_t np = new_shape[ni];
+                size_t op = old_shape[oi];
+                while (np != op)
+                {
+                    if (np < op)
+                        np *= new_shape[nj++];
+                    else
+                        op *= old_shape[oj++];
+                }
+
+                for (size_t ok = oi; ok + 1 < oj; ++ok)
+                    if (old_strides[ok] != old_shape[ok + 1] * old_strides[ok + 1])
+                        return nullopt;
+
+                result[nj - 1] = old_strides[oj - 1];
+                for (size_t nk = nj - 1; nk > ni; --nk)
+                    result[nk - 1] = result[nk] * new_shape[nk];
+
+                ni = nj++;
+                oi = oj++;
+            }
+
+            return result;
+        }
+    }
+
+    void copy_elements(Tensor const &src, Tensor &dst)
+    {
+        assert(src.shape() == dst.shape() and "copy between different shapes");
+
+        BroadcastIterator const iter{src.shape(), dst.strides(), src.strides(), src.strides()};
+        Copy op;
+        detail::apply_broadcast(iter, op, dst.data(), src.data(), src.data());
+    }
+
+    pair<double const *, double const *> extent(Tensor const &t)
+    {
+        size_t last = 0;
+        for (size_t axis = 0; axis < t.rank(); ++axis)
+            last += (t.shape()[axis] - 1) * t.strides()[axis];
+
+        return {t.data(), t.data() + last + 1};
+    }
+
+    bool Tensor::is_contiguous() const
+    {
+        size_t expected = 1;
+        for (size_t axis = rank(); axis-- > 0;)
+        {
+            if (d_shape[axis] != 1 and d_strides[axis] != expected)
+                return false;
+            expected *= d_shape[axis];
+        }
+
+        return true;
+    }
+
+    Tensor Tensor::contiguous() const
+    {
+        if (is_contiguous())
+            return *this;
+
+        Tensor result{d_shape, uninitialized};
+        copy_elements(*this, result);
+        return result;
+    }
+
+    Tensor Tensor::slice(size_t axis, size_t start, size_t stop, size_t step) const
+    {
+        check_axis(axis, rank());
+        if (start >= stop or stop > d_shape[axis] or step == 0)
+            throw invalid_argument("invalid slice [" + to_string(start) + ", " + to_string(stop)
+                                   + ") step " + to_string(step) + " of axis with size "
+                                   + to_string(d_shape[axis]));
+
+        Dims shape   = d_shape;
+        Dims strides = d_strides;
+        shape[axis]   = (stop - start + step - 1) / step;
+        strides[axis] = d_strides[axis] * step;
+
+        return Tensor{shape, strides, d_data, d_offset + start * d_strides[axis], elements(shape)};
+    }
+
+    Tensor Tensor::transpose() const
+    {
+        Dims shape(rank());
+        Dims strides(rank());
+        for (size_t axis = 0; axis < rank(); ++axis)
+        {
+            shape[axis]   = d_shape[rank() - 1 - axis];
+            strides[axis] = d_strides[rank() - 1 - axis];
+        }
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::transpose(size_t axis1, size_t axis2) const
+    {
+        check_axis(axis1, rank());
+        check_axis(axis2, rank());
+
+        Dims shape   = d_shape;
+        Dims strides = d_strides;
+        std::swap(shape[axis1], shape[axis2]);
+        std::swap(strides[axis1], strides[axis2]);
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::permute(Dims const &axes) const
+    {
+        if (axes.size() != rank())
+            throw invalid_argument("permute needs one entry per axis");
+
+        Dims shape(rank());
+        Dims strides(rank());
+        vector<bool> seen(rank(), false);
+        for (size_t axis = 0; axis < rank(); ++axis)
+        {
+            check_axis(axes[axis], rank());
+            if (seen[axes[axis]])
+                throw invalid_argument("axis " + to_string(axes[axis]) + " repeated in permute");
+            seen[axes[axis]] = true;
+
+            shape[axis]   = d_shape[axes[axis]];
+            strides[axis] = d_strides[axes[axis]];
+        }
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::expand(Dims const &shape) const
+    {
+        if (shape.size() < rank())
+            throw invalid_argument("expand cannot drop axes");
+
+        size_t const skip = shape.size() - rank();
+        Dims strides(shape.size());
+        for (size_t axis = skip; axis < shape.size(); ++axis)
+        {
+            size_t const dim = d_shape[axis - skip];
+            if (dim == shape[axis])
+                strides[axis] = d_strides[axis - skip];
+            else if (dim != 1)
+                throw invalid_argument("cannot expand axis " + to_string(axis - skip)
+                                       + " of size " + to_string(dim)
+                                       + " to " + to_string(shape[axis]));
+        }
+        assert(find(shape.begin(), shape.end(), 0) == shape.end() and "invalid dimension 0");
+
+        return Tensor{shape, strides, d_data, d_offset, elements(shape)};
+    }
+
+    Tensor Tensor::squeeze() const
+    {
+        Dims shape;
+        Dims strides;
+        for (size_t axis = 0; axis < rank(); ++axis)
+            if (d_shape[axis] != 1)
+            {
+                shape.push_back(d_shape[axis]);
+                strides.push_back(d_strides[axis]);
+            }
+
+        if (shape.empty())
+            return Tensor{{1}, {1}, d_data, d_offset, 1};
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::squeeze(size_t axis) const
+    {
+        check_axis(axis, rank());
+        if (d_shape[axis] != 1)
+            throw invalid_argument("cannot squeeze axis " + to_string(axis)
+                                   + " of size " + to_string(d_shape[axis]));
+        if (rank() == 1)
+            throw invalid_argument("cannot squeeze the only axis");
+
+        Dims shape   = d_shape;
+        Dims strides = d_strides;
+        shape.erase(shape.begin() + axis);
+        strides.erase(strides.begin() + axis);
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::unsqueeze(size_t axis) const
+    {
+        check_axis(axis, rank() + 1);
+
+        size_t const stride = axis < rank() ? d_strides[axis] * d_shape[axis] : 1;
+
+        Dims shape   = d_shape;
+        Dims strides = d_strides;
+        shape.insert(shape.begin() + axis, 1);
+        strides.insert(strides.begin() + axis, stride);
+
+        return Tensor{shape, strides, d_data, d_offset, d_length};
+    }
+
+    Tensor Tensor::reshape(Dims const &shape) const
+    {
+        if (shape.empty() or elements(shape) != d_length)
+            throw invalid_argument("cannot reshape " + to_string(d_length)
+                                   + " elements to " + to_string(elements(shape)));
+
+        if (optional<Dims> strides = reshape_strides(d_shape, d_strides, shape))
+            return Tensor{shape, *strides, d_data, d_offset, d_length};
+
+        Tensor const dense = contiguous();
+        return Tensor{shape, calculate_strides(shape), dense.d_data, dense.d_offset, d_length};
+    }
+}
@@ -177,3 +177,347 @@ TEST(Tensor, TensorAddBroadcast_Case6) {
 ////////////////
 // / Addition //
 ////////////////
+
+TEST(Tensor, OperationTemplateMatchesFunction) {
+    Tensor t1{{2, 3}, {1.5, -2.0, 3.25, 4.0, -5.5, 6.0}};
+    Tensor t2{{3}, {2.0, 0.5, -1.0}};
+
+    function<double(double, double)> callback = [](double x, double y) { return x * y - 1.0; };
+
+    Tensor res_fn  = operation(t1, t2, callback);
+    Tensor res_tpl = operation(t1, t2, [](double x, double y) { return x * y - 1.0; });
+
+    EXPECT_THAT(res_tpl.shape(), ::testing::ContainerEq(res_fn.shape()));
+    EXPECT_TRUE(equal(res_fn.cbegin(), res_fn.cend(), res_tpl.cbegin()));
+}
+
+TEST(Tensor, OperationFunctionCallsBackSerially) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(4);
+
+    size_t calls = 0;
+    function<double(double, double)> counter = [&calls](double x, double y) {
+        ++calls;
+        return x + y;
+    };
+    Tensor const t{{1000, 1000}, 1.0};
+    operation(t, t, counter);
+    EXPECT_EQ(t.size(), calls);
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(TensorMath, SumKeepsFractions) {
+    Tensor t1{{2, 2}, vector<double>{0.5, 0.25, 1.5, -0.125}};
+
+    EXPECT_DOUBLE_EQ(2.125, t1.sum());
+}
+
+TEST(TensorMath, ParallelOpsMatchSerial) {
+    size_t const n = 300'000;
+    vector<double> values(n);
+    for (size_t i = 0; i < n; ++i)
+        values[i] = static_cast<double>(i % 1000) * 0.001;
+
+    Tensor t1{{n}, vector<double>(values)};
+    Tensor t2{{3, n / 3}, vector<double>(values)};
+    Tensor row{{n / 3}, vector<double>(values.begin(), values.begin() + n / 3)};
+
+    size_t const previous = parallel::num_threads();
+
+    parallel::set_num_threads(1);
+    double serial_sum = t1.sum();
+    Tensor serial_add = t2 + row;
+
+    parallel::set_num_threads(4);
+    double parallel_sum = t1.sum();
+    Tensor parallel_add = t2 + row;
+    t1 *= 2.0;
+
+    parallel::set_num_threads(previous);
+
+    EXPECT_EQ(serial_sum, parallel_sum);
+    EXPECT_TRUE(equal(serial_add.cbegin(), serial_add.cend(), parallel_add.cbegin()));
+    EXPECT_DOUBLE_EQ(2 * values[n - 1], *(t1.cend() - 1));
+}
+
+TEST(TensorMath, CompoundOpsBroadcastInPlace) {
+    Tensor t1{{2, 3}, vector<double>{
+        1.0, 2.0, 3.0,
+        4.0, 5.0, 6.0,
+    }};
+    Tensor row{{3}, vector<double>{2.0, 4.0, 8.0}};
+
+    double const *storage = t1.data();
+
+    t1 *= row;
+    t1 /= Tensor{{2, 1}, vector<double>{2.0, 4.0}};
+
+    vector<double> result{
+        1.0, 4.0, 12.0,
+        2.0, 5.0, 12.0,
+    };
+
+    EXPECT_EQ(storage, t1.data());
+    EXPECT_TRUE(equal(result.begin(), result.end(), t1.cbegin()));
+    EXPECT_THROW(row += t1, invalid_argument);
+}
+
+TEST(TensorMath, CompoundOpOnViewUpdatesParent) {
+    Tensor weights{{2, 2}, vector<double>{1.0, 2.0, 3.0, 4.0}};
+    Tensor grad{{2}, vector<double>{10.0, 20.0}};
+
+    weights[1] -= grad * 0.1;
+    weights[0] += weights[0];
+
+    vector<double> result{2.0, 4.0, 2.0, 2.0};
+    EXPECT_TRUE(equal(result.begin(), result.end(), weights.cbegin()));
+}
+
+TEST(TensorMath, FusedUpdatesMatchUnfused) {
+    Tensor weights{{2, 3}, vector<double>{1.0, 2.0, 3.0, 4.0, 5.0, 6.0}};
+    Tensor grad{{2, 3}, vector<double>{0.5, -1.0, 2.0, 0.0, 4.0, -2.0}};
+
+    Tensor expected = weights - grad * 0.1;
+    weights.axpy(-0.1, grad);
+
+    for (size_t i = 0; i < weights.size(); ++i)
+        EXPECT_DOUBLE_EQ(expected.cbegin()[i], weights.cbegin()[i]);
+
+    EXPECT_THROW(weights.axpy(1.0, Tensor{{3}}), invalid_argument);
+}
+
+TEST(TensorMath, FusedUpdatesRefuseBroadcastTargets) {
+    Tensor row{{1, 3}, vector<double>{1.0, 2.0, 3.0}};
+    Tensor grad{{2, 3}, 1.0};
+    Tensor state{{2, 3}, 0.0};
+    Tensor m{{2, 3}, 0.0};
+
+    EXPECT_THROW(row.expand({2, 3}).axpy(1.0, grad), invalid_argument);
+
+    Tensor weights = row.expand({2, 3});
+    EXPECT_THROW(momentum_step(weights, grad, state, 0.1, 0.9), invalid_argument);
+
+    Tensor velocity = row.expand({2, 3});
+    EXPECT_THROW(momentum_step(state, grad, velocity, 0.1, 0.9), invalid_argument);
+    EXPECT_THROW(adam_step(state, grad, m, velocity, 1), invalid_argument);
+
+    vector<double> unchanged{1.0, 2.0, 3.0};
+    EXPECT_TRUE(equal(unchanged.begin(), unchanged.end(), row.cbegin()));
+}
+
+TEST(TensorMath, FusedUpdatesReadOverlappingOperandsFromACopy) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(4);
+
+    size_t const n = 1 << 18;
+    Tensor t{{n + 1}, uninitialized};
+    for (size_t i = 0; i < t.size(); ++i)
+        t.data()[i] = static_cast<double>(i % 7);
+
+    // y and x share all but one element, shifted by one
+    Tensor y = t.slice(0, 0, n);
+    Tensor const x = t.slice(0, 1, n + 1);
+    Tensor const expected = x + y;
+    y.axpy(1.0, x);
+    EXPECT_TRUE(equal(expected.cbegin(), expected.cend(), y.cbegin()));
+
+    Tensor u{{n + 1}, 1.0};
+    Tensor weights = u.slice(0, 0, n);
+    Tensor const grad = u.slice(0, 1, n + 1);
+    Tensor velocity{{n}, 0.0};
+    momentum_step(weights, grad, velocity, 0.5, 0.9);
+    EXPECT_TRUE(all_of(weights.cbegin(), weights.cend(), [](double w) { return w == 0.5; }));
+
+    // two state tensors that overlap have no order to read them in
+    Tensor state{{n + 1}, 0.0};
+    Tensor m = state.slice(0, 0, n);
+    Tensor v = state.slice(0, 1, n + 1);
+    EXPECT_THROW(adam_step(weights, grad, m, v, 1), invalid_argument);
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(TensorMath, AdamStepMovesAgainstGradient) {
+    Tensor weights{{4}, 1.0};
+    Tensor grad{{4}, vector<double>{1.0, -1.0, 0.5, -0.5}};
+    Tensor m{{4}}, v{{4}};
+
+    adam_step(weights, grad, m, v, 1, AdamOptions{.lr = 0.1});
+
+    // the first bias-corrected step is lr * sign(grad), up to eps
+    vector<double> result{0.9, 1.1, 0.9, 1.1};
+    for (size_t i = 0; i < weights.size(); ++i)
+        EXPECT_NEAR(result[i], weights.cbegin()[i], 1e-6);
+}
+
+TEST(TensorMath, LazyExpressionMatchesEagerOperations) {
+    Tensor t1{{2, 3}, vector<double>{1.5, -2.0, 3.25, 4.0, -5.5, 6.0}};
+    Tensor t2{{3}, vector<double>{2.0, 0.5, -1.0}};
+    Tensor col{{2, 1}, vector<double>{0.25, 3.0}};
+
+    auto lazy = maximum((t1 - t2) * col + 1.0, 0.0).power(2);
+
+    Tensor eager = operation(
+        operation(operation(operation(t1, t2, ops::Sub{}), col, ops::Mul{}),
+                  Tensor{{1}, 1.0}, ops::Add{}),
+        Tensor{{1}, 0.0}, ops::Max{});
+    eager.power(2);
+
+    Tensor res = lazy;
+
+    EXPECT_THAT(res.shape(), ::testing::ContainerEq(vector<size_t>{2, 3}));
+    EXPECT_TRUE(equal(eager.cbegin(), eager.cend(), res.cbegin()));
+    EXPECT_EQ(eager.sum(), lazy.sum());
+    EXPECT_THROW(t1 + Tensor{{2}}, runtime_error);
+}
+
+TEST(TensorMath, ScalarAndBroadcastOperandsMatchEagerOperations) {
+    Tensor t{{2, 3}, vector<double>{1.5, -2.0, 0.5, 4.0, 0.5, -6.0}};
+    Tensor row{{3}, vector<double>{1.0, 0.5, -1.0}};
+    Tensor col{{2, 1}, vector<double>{0.5, 4.0}};
+    Tensor half{{1}, 0.5};
+
+    auto expect_same = [](Tensor const &eager, Tensor const &lazy) {
+        EXPECT_EQ(eager.shape(), lazy.shape());
+        EXPECT_TRUE(equal(eager.cbegin(), eager.cend(), lazy.cbegin()));
+    };
+
+    expect_same(operation(t, half, ops::Min{}), Tensor{minimum(t, 0.5)});
+    expect_same(operation(t, row, ops::Min{}), Tensor{minimum(t, row)});
+    expect_same(operation(t, row, ops::Greater{}), Tensor{t > row});
+    expect_same(operation(t, half, ops::LessEqual{}), Tensor{t <= 0.5});
+    expect_same(operation(half, t, ops::Less{}), Tensor{0.5 < t});
+    expect_same(operation(t, col, ops::Equal{}), Tensor{t == col});
+    expect_same(operation(t, col, ops::NotEqual{}), Tensor{t != col});
+    EXPECT_EQ(4.0, (t >= 0.5).sum());
+
+    // the scalar side is never materialised: one buffer for the result
+    size_t const before = memory::thread_allocations().count;
+    Tensor relu = maximum(t, 0.0);
+    EXPECT_EQ(before + 1, memory::thread_allocations().count);
+    EXPECT_EQ(6.5, relu.sum());
+}
+
+TEST(TensorMath, LazyCompoundHandlesAliasing) {
+    Tensor weights{{2, 2}, vector<double>{1.0, 2.0, 3.0, 4.0}};
+
+    weights -= weights * 0.5;
+    weights += weights[0] * 2.0;   // row 0 is read while it is updated
+
+    vector<double> result{1.5, 3.0, 2.5, 4.0};
+    EXPECT_TRUE(equal(result.begin(), result.end(), weights.cbegin()));
+}
+
+TEST(TensorMath, ScalarCompoundUpdatesViewsWithoutAllocating) {
+    Tensor t{{3, 4}, vector<double>{
+        0.0, 1.0,  2.0,  3.0,
+        4.0, 5.0,  6.0,  7.0,
+        8.0, 9.0, 10.0, 11.0,
+    }};
+    Tensor columns = t.slice(1, 1, 4, 2);  // columns 1 and 3
+    Tensor column  = t.slice(1, 2, 3);
+
+    size_t const before = memory::thread_allocations().count;
+    profile::enable();
+    columns += 2.0;
+    column  *= -1.0;
+    t.transpose() -= 1.0;
+    profile::disable();
+    EXPECT_EQ(before, memory::thread_allocations().count);
+
+    // one record per call, not one wrapping a broadcast "compound"
+    vector<profile::Event> const events = profile::events();
+    ASSERT_EQ(3, events.size());
+    for (profile::Event const &event : events)
+        EXPECT_EQ("compound scalar", event.name);
+
+    vector<double> result{
+        -1.0,  2.0,  -3.0,  4.0,
+         3.0,  6.0,  -7.0,  8.0,
+         7.0, 10.0, -11.0, 12.0,
+    };
+    EXPECT_TRUE(equal(result.begin(), result.end(), t.cbegin()));
+}
+
+TEST(TensorMath, InPlaceWritesRefuseBroadcastTargets) {
+    Tensor t{{1, 4}, vector<double>{1.0, 2.0, 3.0, 4.0}};
+    Tensor expanded = t.expand({3, 4});
+
+    EXPECT_THROW(expanded += 1.0, invalid_argument);
+    EXPECT_THROW(expanded *= (Tensor{{4}, 2.0}), invalid_argument);
+    EXPECT_THROW(expanded -= t * 2.0, invalid_argument);
+    EXPECT_THROW(expanded.power(2), invalid_argument);
+
+    Tensor other{{4, 4}, 1.0};
+    EXPECT_THROW(t.expand({4, 4}) = other, invalid_argument);
+    EXPECT_THROW(t.expand({4, 4}) = (Tensor{{4, 4}, 2.0}), invalid_argument);
+
+    vector<double> unchanged{1.0, 2.0, 3.0, 4.0};
+    EXPECT_TRUE(equal(unchanged.begin(), unchanged.end(), t.cbegin()));
+
+    // size-1 axes of stride 0 alias nothing
+    Tensor row = t.expand({1, 4});
+    row += 1.0;
+    EXPECT_DOUBLE_EQ(14.0, t.sum());
+}
+
+TEST(TensorMath, ReductionsAlongAxes) {
+    Tensor t{{2, 3, 2}, vector<double>{
+        1.0,  2.0,   3.0, -4.0,   5.0, 6.0,
+        7.0, -8.0,   9.0, 10.0,  11.0, 0.5,
+    }};
+
+    Tensor inner = t.sum({2});
+    EXPECT_THAT(inner.shape(), ::testing::ContainerEq(vector<size_t>{2, 3}));
+    EXPECT_THAT(vector<double>(inner.cbegin(), inner.cend()),
+                ::testing::ElementsAre(3.0, -1.0, 11.0, -1.0, 19.0, 11.5));
+
+    Tensor outer = t.max({0}, true);
+    EXPECT_THAT(outer.shape(), ::testing::ContainerEq(vector<size_t>{1, 3, 2}));
+    EXPECT_THAT(vector<double>(outer.cbegin(), outer.cend()),
+                ::testing::ElementsAre(7.0, 2.0, 9.0, 10.0, 11.0, 6.0));
+
+    Tensor middle = t.min({1});
+    EXPECT_THAT(vector<double>(middle.cbegin(), middle.cend()),
+                ::testing::ElementsAre(1.0, -4.0, 7.0, -8.0));
+
+    Tensor both = t.prod({0, 2});
+    EXPECT_THAT(vector<double>(both.cbegin(), both.cend()),
+                ::testing::ElementsAre(-112.0, -1080.0, 165.0));
+
+    Tensor all = t.mean();
+    EXPECT_THAT(all.shape(), ::testing::ContainerEq(vector<size_t>{1}));
+    EXPECT_DOUBLE_EQ(t.sum() / 12, all.data()[0]);
+
+    Tensor arg = t.argmax(1);
+    EXPECT_THAT(vector<double>(arg.cbegin(), arg.cend()),
+                ::testing::ElementsAre(2.0, 2.0, 2.0, 1.0));
+
+    EXPECT_THROW(t.sum({3}), invalid_argument);
+    EXPECT_THROW(t.sum({1, 1}), invalid_argument);
+}
+
+TEST(TensorMath, AxisSumsAreStableAndThreadIndependent) {
+    // one large value followed by many small ones loses them in a serial sum
+    size_t const rows = 3, cols = 200'001;
+    vector<double> values(rows * cols, 1e-8);
+    for (size_t row = 0; row < rows; ++row)
+        values[row * cols] = 1e8;
+    Tensor t{{rows, cols}, vector<double>(values)};
+
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(1);
+    Tensor serial = t.sum({1});
+    Tensor columns_serial = t.sum({0});
+    parallel::set_num_threads(4);
+    Tensor threaded = t.sum({1});
+    Tensor columns_threaded = t.sum({0});
+    parallel::set_num_threads(previous);
+
+    for (size_t row = 0; row < rows; ++row)
+        EXPECT_NEAR(1e8 + 2e-3, serial.data()[row], 1e-7);
+    EXPECT_TRUE(equal(serial.cbegin(), serial.cend(), threaded.cbegin()));
+    EXPECT_TRUE(equal(columns_serial.cbegin(), columns_serial.cend(), columns_threaded.cbegin()));
+    EXPECT_DOUBLE_EQ(3e-8, columns_serial.data()[1]);
+}
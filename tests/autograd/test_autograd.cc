@@ -0,0 +1,203 @@
+#include "../test.h"
+
+using namespace autodiff;
+using namespace autodiff::autograd;
+
+namespace
+{
+    // central differences of f with respect to every element of x
+    template <typename F>
+    Tensor numeric_grad(Tensor const &x, F f)
+    {
+        Tensor grad{x.shape(), 0.0};
+        double const h = 1e-6;
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            Tensor up{x.shape(), vector<double>(x.cbegin(), x.cend())};
+            Tensor down{x.shape(), vector<double>(x.cbegin(), x.cend())};
+            up.data()[i]   += h;
+            down.data()[i] -= h;
+            grad.data()[i] = (f(up) - f(down)) / (2 * h);
+        }
+        return grad;
+    }
+
+    void expect_near(Tensor const &actual, Tensor const &expected)
+    {
+        ASSERT_EQ(actual.shape(), expected.shape());
+        for (size_t i = 0; i < actual.size(); ++i)
+            EXPECT_NEAR(actual.data()[i], expected.data()[i], 1e-5) << "at " << i;
+    }
+
+    // two layer perceptron with squared error, bias broadcast over rows
+    template <typename T>
+    auto mlp(T const &x, T const &w1, T const &b1, T const &w2)
+    {
+        auto hidden = maximum(matmul(x, w1) + b1, 0.0);
+        auto out    = matmul(hidden, w2);
+        return sum(power(out - 1.0, 2.0)) / 2.0;
+    }
+}
+
+TEST(Autograd, MlpMatchesFiniteDifferences) {
+    Tensor const x{{3, 2}, {0.5, -1.0, 1.5, 2.0, -0.3, 0.8}};
+    Tensor const w1{{2, 4}, {0.1, -0.2, 0.3, 0.4, -0.5, 0.6, 0.7, -0.8}};
+    Tensor const b1{{4}, {0.05, -0.1, 0.2, 0.0}};
+    Tensor const w2{{4, 1}, {0.3, -0.6, 0.9, 0.2}};
+
+    Tape tape;
+    Var vx  = tape.constant(x);
+    Var vw1 = tape.variable(w1);
+    Var vb1 = tape.variable(b1);
+    Var vw2 = tape.variable(w2);
+    tape.backward(mlp(vx, vw1, vb1, vw2));
+
+    auto loss = [&](Tensor const &a, Tensor const &b, Tensor const &c) {
+        Tape t;
+        return mlp(t.constant(x), t.constant(a), t.constant(b), t.constant(c)).value().data()[0];
+    };
+
+    expect_near(vw1.grad(), numeric_grad(w1, [&](Tensor const &w) { return loss(w, b1, w2); }));
+    expect_near(vb1.grad(), numeric_grad(b1, [&](Tensor const &b) { return loss(w1, b, w2); }));
+    expect_near(vw2.grad(), numeric_grad(w2, [&](Tensor const &w) { return loss(w1, b1, w); }));
+}
+
+TEST(Autograd, ElementwiseRules) {
+    Tensor const a{{3}, {1.0, 2.0, 4.0}};
+    Tensor const b{{3}, {2.0, 2.5, 0.5}};
+
+    Tape tape;
+    Var va = tape.variable(a);
+    Var vb = tape.variable(b);
+    tape.backward(sum(va * vb + va / vb - 3.0 / va) + sum(concatenate(va, vb)));
+
+    // d/da = b + 1/b + 3/a^2 + 1, d/db = a - a/b^2 + 1
+    expect_near(va.grad(), Tensor{{3}, {2.0 + 0.5 + 3.0 + 1, 2.5 + 0.4 + 0.75 + 1, 0.5 + 2.0 + 0.1875 + 1}});
+    expect_near(vb.grad(), Tensor{{3}, {1.0 - 0.25 + 1, 2.0 - 0.32 + 1, 4.0 - 16.0 + 1}});
+}
+
+TEST(Autograd, MinimumAndMaximumGiveTiesToTheSecondOperand) {
+    Tape tape;
+    Var va = tape.variable(Tensor{{3}, {1.0, 2.0, 3.0}});
+    Var vb = tape.variable(Tensor{{3}, {2.0, 2.0, 1.0}});
+    tape.backward(sum(minimum(va, vb)) + sum(maximum(va, 2.0)) + sum(minimum(2.0, vb)));
+
+    expect_near(va.grad(), Tensor{{3}, {1.0, 0.0, 1.0}});
+    expect_near(vb.grad(), Tensor{{3}, {1.0, 2.0, 2.0}});
+}
+
+TEST(Autograd, ConcatenateAlongInnerAxis) {
+    Tape tape;
+    Var va = tape.variable(Tensor{{2, 2}, {1.0, 2.0, 3.0, 4.0}});
+    Var vb = tape.variable(Tensor{{2, 1}, {5.0, 6.0}});
+    Var weights = tape.constant(Tensor{{2, 3}, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0}});
+
+    Var joined = concatenate(va, vb, 1);
+    expect_near(joined.value(), Tensor{{2, 3}, {1.0, 2.0, 5.0, 3.0, 4.0, 6.0}});
+
+    tape.backward(sum(joined * weights));
+    expect_near(va.grad(), Tensor{{2, 2}, {1.0, 2.0, 4.0, 5.0}});
+    expect_near(vb.grad(), Tensor{{2, 1}, {3.0, 6.0}});
+}
+
+TEST(Autograd, BatchedMatmulIsRefusedWhenRecorded) {
+    Tape tape;
+    Var const a = tape.variable(Tensor{{2, 2, 3}, 1.0});
+    Var const b = tape.variable(Tensor{{3, 2}, 1.0});
+
+    EXPECT_THROW(matmul(a, b), invalid_argument);
+    EXPECT_THROW(matmul(b, a), invalid_argument);
+    EXPECT_EQ(tape.size(), 2u);
+}
+
+TEST(Autograd, PlannerReusesMemory) {
+    vector<Interval> chain;
+    for (size_t step = 0; step < 10; ++step)
+        chain.push_back({step, step + 1, 64});
+
+    GradientPlan const plan = plan_gradients(chain);
+    EXPECT_EQ(plan.size, 2 * 64u);
+    for (size_t step = 0; step + 1 < chain.size(); ++step)
+        EXPECT_NE(plan.offsets[step], plan.offsets[step + 1]);
+}
+
+TEST(Autograd, SlabSurvivesClear) {
+    Tape tape;
+    Tensor const x{{256}, 0.5};
+
+    auto run = [&tape, &x] {
+        Var v = tape.variable(x);
+        Var y = v;
+        for (size_t layer = 0; layer < 8; ++layer)
+            y = y * 1.5 + 1.0;
+        tape.backward(sum(y));
+        return v;
+    };
+
+    run();
+    size_t const slab = tape.plan().size;
+    EXPECT_LT(slab, 17 * 256u);               // 17 intermediate gradients
+
+    tape.clear();
+    Var v = run();
+    EXPECT_EQ(tape.plan().size, slab);
+    EXPECT_NEAR(v.grad().data()[0], std::pow(1.5, 8), 1e-12);
+}
+
+namespace
+{
+    // gradients of a deep ReLU stack sharing one weight matrix
+    struct Deep
+    {
+        Tensor grad_w;
+        Tensor grad_b;
+        size_t resident;
+    };
+
+    template <typename Mark>
+    Deep deep_stack(Tape &tape, Mark mark)
+    {
+        Tensor w{{16, 16}};
+        for (size_t i = 0; i < w.size(); ++i)
+            w.data()[i] = 0.02 * double(i % 7) - 0.05;
+
+        Var vw = tape.variable(w);
+        Var vb = tape.variable(Tensor{{16}, 0.1});
+        Var h  = tape.constant(Tensor{{16}, 1.0});
+        for (size_t layer = 0; layer < 32; ++layer)
+        {
+            h = maximum(matmul(vw, h) + vb, 0.0);
+            mark(h);
+        }
+        Var loss = sum(h * h);
+
+        size_t const resident = tape.resident();
+        tape.backward(loss);
+        return {vw.grad(), vb.grad(), resident};
+    }
+}
+
+TEST(Autograd, CheckpointingRecomputesReleasedValues) {
+    Tape plain;
+    Deep const expected = deep_stack(plain, [](Var const &) {});
+
+    Tape automatic;
+    automatic.checkpoint_automatically();
+    Deep const sqrt_n = deep_stack(automatic, [](Var const &) {});
+
+    Tape manual;
+    Deep const marked = deep_stack(manual, [&manual](Var const &h) { manual.checkpoint(h); });
+
+    expect_near(sqrt_n.grad_w, expected.grad_w);
+    expect_near(sqrt_n.grad_b, expected.grad_b);
+    expect_near(marked.grad_w, expected.grad_w);
+    expect_near(marked.grad_b, expected.grad_b);
+
+    // leaves: 256 + 16 + 16; every layer holds three values of 16
+    EXPECT_EQ(expected.resident, 288 + 32 * 3 * 16 + 16 + 1);
+    EXPECT_EQ(marked.resident,   288 + 32 * 16 + 16 + 1);
+    EXPECT_LT(sqrt_n.resident,   expected.resident / 2);
+
+    // backward leaves nothing recomputed behind
+    EXPECT_EQ(manual.resident(), marked.resident);
+}
@@ -82,3 +82,134 @@ TEST(LinearAlgebra, Matmul_BroadcastedBatched) {
         EXPECT_NEAR(expected[i++], val, kAbsTol);
     });
 }
+
+TEST(LinearAlgebra, Matmul_BlockedMatchesNaiveOnEveryIsa) {
+    // sizes straddle the register tiles and the kc block on every ISA
+    size_t const m = 37, k = 301, n = 45;
+
+    vector<double> lhs_data(m * k), rhs_data(k * n);
+    for (size_t i = 0; i < lhs_data.size(); ++i)
+        lhs_data[i] = static_cast<double>(i % 17) * 0.25 - 2.0;
+    for (size_t i = 0; i < rhs_data.size(); ++i)
+        rhs_data[i] = static_cast<double>(i % 13) * -0.5 + 3.0;
+
+    vector<double> expected(m * n, 0.0);
+    for (size_t i = 0; i < m; ++i)
+        for (size_t p = 0; p < k; ++p)
+            for (size_t j = 0; j < n; ++j)
+                expected[i * n + j] += lhs_data[i * k + p] * rhs_data[p * n + j];
+
+    Tensor t1{{m, k}, vector<double>(lhs_data)};
+    Tensor t2{{k, n}, vector<double>(rhs_data)};
+
+    simd::Isa const previous = simd::isa();
+    for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::Avx2, simd::Isa::Avx512})
+    {
+        if (isa > simd::detected_isa())
+            continue;
+
+        simd::use_isa(isa);
+        Tensor res = matmul(t1, t2);
+
+        EXPECT_THAT(res.shape(), ::testing::ContainerEq(std::vector<size_t>{m, n}));
+        size_t i = 0;
+        std::for_each(res.cbegin(), res.cend(), [&i, &expected](double val) {
+            EXPECT_NEAR(expected[i++], val, 1e-9);
+        });
+    }
+    simd::use_isa(previous);
+}
+
+TEST(LinearAlgebra, Matmul_BatchedSingleElementResult) {
+    Tensor t1{{3, 1, 2}, {1, 2, 3, 4, 5, 6}};
+    Tensor t2{{2, 1}, {10, 100}};
+
+    Tensor res = matmul(t1, t2);
+
+    EXPECT_THAT(res.shape(), ::testing::ContainerEq(std::vector<size_t>{3, 1, 1}));
+
+    std::vector<double> expected{210, 430, 650};
+    size_t i = 0;
+    std::for_each(res.cbegin(), res.cend(), [&i, &expected](double val) {
+        EXPECT_DOUBLE_EQ(expected[i++], val);
+    });
+}
+
+TEST(LinearAlgebra, Matmul_ParallelIsBitIdenticalToSerial) {
+    vector<double> lhs_data(2 * 3 * 70 * 90), rhs_data(3 * 90 * 110);
+    for (size_t i = 0; i < lhs_data.size(); ++i)
+        lhs_data[i] = std::sin(static_cast<double>(i));
+    for (size_t i = 0; i < rhs_data.size(); ++i)
+        rhs_data[i] = std::cos(static_cast<double>(i));
+
+    // many batches, and a single large product split over row blocks
+    Tensor t1{{2, 3, 70, 90}, vector<double>(lhs_data)};
+    Tensor t2{{3, 90, 110}, vector<double>(rhs_data)};
+    Tensor t3{{420, 90}, vector<double>(lhs_data)};
+
+    size_t const previous = parallel::num_threads();
+
+    parallel::set_num_threads(1);
+    Tensor serial_batched = matmul(t1, t2);
+    Tensor serial_rows    = matmul(t3, t2[0]);
+
+    parallel::set_num_threads(5);
+    Tensor parallel_batched = matmul(t1, t2);
+    Tensor parallel_rows    = matmul(t3, t2[0]);
+
+    parallel::set_num_threads(previous);
+
+    EXPECT_TRUE(std::equal(serial_batched.cbegin(), serial_batched.cend(), parallel_batched.cbegin()));
+    EXPECT_TRUE(std::equal(serial_rows.cbegin(), serial_rows.cend(), parallel_rows.cbegin()));
+}
+
+// batches run in parallel and each splits its rows over the pool too, so
+// threads waiting in one product pick up chunks of another
+TEST(LinearAlgebra, Matmul_NestedBatchesMatchSerial) {
+    vector<double> lhs_data(32 * 200 * 300), rhs_data(32 * 300 * 200);
+    for (size_t i = 0; i < lhs_data.size(); ++i)
+        lhs_data[i] = std::sin(static_cast<double>(i));
+    for (size_t i = 0; i < rhs_data.size(); ++i)
+        rhs_data[i] = std::cos(static_cast<double>(i));
+
+    Tensor lhs{{32, 200, 300}, std::move(lhs_data)};
+    Tensor rhs{{32, 300, 200}, std::move(rhs_data)};
+
+    size_t const previous = parallel::num_threads();
+
+    parallel::set_num_threads(1);
+    Tensor serial = matmul(lhs, rhs);
+
+    parallel::set_num_threads(8);
+    Tensor threaded = matmul(lhs, rhs);
+
+    parallel::set_num_threads(previous);
+
+    EXPECT_TRUE(std::equal(serial.cbegin(), serial.cend(), threaded.cbegin()));
+}
+
+TEST(LinearAlgebra, Matmul_StridedOperandsMatchContiguous) {
+    // large enough for the packed path and the parallel vector paths
+    size_t const m = 150, k = 130, n = 170;
+    vector<double> data(2 * k * n);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = std::sin(static_cast<double>(i));
+
+    Tensor a{{k, m}, vector<double>(data.begin(), data.begin() + m * k)};
+    Tensor b{{n, 2 * k}, vector<double>(data.begin(), data.begin() + 2 * k * n)};
+    Tensor x{{k}, vector<double>(data.begin() + 7, data.begin() + 7 + k)};
+
+    Tensor const at = a.transpose();                        // column-major
+    Tensor const bt = b.slice(1, 0, 2 * k, 2).transpose();  // strided rows and columns
+
+    auto expect_equal = [](Tensor const &actual, Tensor const &expected) {
+        ASSERT_EQ(actual.shape(), expected.shape());
+        EXPECT_TRUE(std::equal(actual.cbegin(), actual.cend(), expected.cbegin(),
+                               [](double lhs, double rhs) { return std::abs(lhs - rhs) < 1e-9; }));
+    };
+
+    expect_equal(matmul(at, bt), matmul(at.contiguous(), bt.contiguous()));
+    expect_equal(matmul(at, x), matmul(at.contiguous(), x));
+    expect_equal(matmul(x, bt), matmul(x, bt.contiguous()));
+    expect_equal(matmul(x, a.transpose().transpose()), matmul(x, a));
+}
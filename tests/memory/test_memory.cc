@@ -0,0 +1,140 @@
+#include "../test.h"
+
+TEST(Memory, PoolReusesReleasedBlocks) {
+    auto pool = make_shared<memory::PoolAllocator>();
+    memory::Scope scope{pool};
+
+    {
+        Tensor t1{{64, 64}, 1.0};
+    }
+    Tensor t2{{64, 64}, 2.0};
+
+    memory::Stats stats = pool->stats();
+    EXPECT_EQ(2, stats.fresh_allocations);    // data and control block
+    EXPECT_EQ(2, stats.reused_allocations);
+    EXPECT_GE(stats.reused_bytes, 64 * 64 * sizeof(double));
+}
+
+TEST(Memory, ArenaRewindsOnceEveryBlockIsReleased) {
+    auto arena = make_shared<memory::Arena>(size_t{1} << 16);
+    Tensor weights{{16}, 1.0};
+
+    for (size_t step = 0; step < 3; ++step)
+    {
+        memory::Scope scope{arena};
+
+        Tensor update = weights * 0.5;
+        Tensor total  = weights + update;
+        EXPECT_DOUBLE_EQ(1.5, total.sum() / 16);
+        EXPECT_EQ(4, arena->live());
+    }
+
+    // the first step carves its blocks out of a new chunk, the others
+    // reuse it
+    memory::Stats stats = arena->stats();
+    EXPECT_EQ(0, arena->live());
+    EXPECT_EQ(4, stats.fresh_allocations);
+    EXPECT_EQ(8, stats.reused_allocations);
+    EXPECT_EQ(size_t{1} << 16, stats.fresh_bytes);
+}
+
+TEST(Memory, TensorKeepsItsAllocatorAlive) {
+    Tensor t1{{4}, 0.0};
+    {
+        memory::Scope scope{make_shared<memory::Arena>()};
+        t1 = Tensor{{4}, 3.0};
+    }
+
+    EXPECT_DOUBLE_EQ(12.0, t1.sum());
+}
+
+TEST(Memory, BuffersAreAlignedToTheAllocatorsAlignment) {
+    auto aligned = [](Tensor const &t, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(t.data()) % alignment == 0;
+    };
+
+    vector<pair<shared_ptr<memory::Allocator>, size_t>> const allocators{
+        {make_shared<memory::HeapAllocator>(), memory::default_alignment},
+        {make_shared<memory::PoolAllocator>(), memory::default_alignment},
+        {make_shared<memory::Arena>(), memory::default_alignment},
+        {make_shared<memory::PoolAllocator>(size_t{1} << 20, 256), 256},
+    };
+
+    for (auto const &[allocator, alignment] : allocators)
+    {
+        memory::Scope scope{allocator};
+        for (size_t size : {1, 3, 7, 33})
+        {
+            Tensor const t{{size}, 1.0};
+            EXPECT_TRUE(aligned(t, alignment)) << "size " << size << ", alignment " << alignment;
+        }
+    }
+
+    EXPECT_THROW(memory::HeapAllocator{48}, invalid_argument);
+    EXPECT_THROW(memory::PoolAllocator(1024, 4), invalid_argument);
+}
+
+TEST(Memory, PlacedBuffersHoldTheirValues) {
+    for (memory::Placement where : {memory::Placement::first_touch, memory::Placement::local})
+    {
+        memory::set_placement(where);
+        EXPECT_EQ(where, memory::placement());
+
+        memory::Scope scope{make_shared<memory::HeapAllocator>()};
+        Tensor const t{{1 << 18}, 0.5};
+        Tensor const u = t + t;
+        EXPECT_DOUBLE_EQ(1 << 18, u.sum());
+
+        // arena chunks are placed without holding the arena's lock
+        {
+            memory::Scope chunks{make_shared<memory::Arena>(size_t{1} << 20)};
+            Tensor const a{{1 << 18}, 0.25};
+            Tensor const b = a + a;
+            EXPECT_DOUBLE_EQ(1 << 17, b.sum());
+        }
+
+        // mapped on their own, so wider than a page alignments still hold
+        memory::Scope wide{make_shared<memory::HeapAllocator>(size_t{1} << 16)};
+        Tensor const v{{1 << 16}, 1.0};
+        EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(v.data()) % (size_t{1} << 16));
+    }
+
+    memory::set_placement(memory::Placement::any);
+}
+
+TEST(Memory, UsageCountsLiveAndPeakBytes) {
+    memory::Usage const before = memory::usage();
+    memory::reset_peak();
+    {
+        Tensor big{{1000}, 1.0};                // 8000 bytes, the 8 KiB bucket
+        Tensor view = big.slice(0, 0, 10);      // views add nothing
+
+        memory::Usage const during = memory::usage();
+        EXPECT_EQ(before.current_bytes + 8000, during.current_bytes);
+        EXPECT_EQ(before.live_buffers + 1, during.live_buffers);
+        EXPECT_EQ(before.histogram[13] + 1, during.histogram[13]);
+    }
+
+    memory::Usage const after = memory::usage();
+    EXPECT_EQ(before.current_bytes, after.current_bytes);
+    EXPECT_EQ(before.total_bytes + 8000, after.total_bytes);
+    EXPECT_GE(after.peak_bytes, before.current_bytes + 8000);
+}
+
+TEST(Memory, TrackedBuffersRememberTheirOp) {
+    Tensor a{{32, 16}, 1.0};
+    Tensor b{{16, 8}, 1.0};
+
+    memory::track_origins();
+    Tensor scaled  = a * 2.0;
+    Tensor product = matmul(a, b);
+    Tensor loose{{4}, 0.0};
+    memory::track_origins(false);
+
+    vector<memory::Origin> const origins = memory::live_origins();
+    ASSERT_EQ(3, origins.size());
+    EXPECT_EQ("expression", origins[0].op);
+    EXPECT_EQ("matmul", origins[1].op);
+    EXPECT_EQ(32 * 8 * sizeof(double), origins[1].bytes);
+    EXPECT_EQ("unlabelled", origins[2].op);
+}
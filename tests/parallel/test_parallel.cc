@@ -0,0 +1,105 @@
+#include "../test.h"
+
+#include <atomic>
+
+TEST(Parallel, ParallelForVisitsEveryIndexOnce) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(4);
+
+    vector<atomic<int>> visits(1000);
+    parallel::parallel_for(0, visits.size(), 7, [&visits](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            ++visits[i];
+    });
+
+    for (auto const &count : visits)
+        EXPECT_EQ(1, count.load());
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(Parallel, NestedParallelForCompletes) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(3);
+
+    atomic<size_t> total{0};
+    parallel::parallel_for(0, 8, 1, [&total](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            parallel::parallel_for(0, 10, 1, [&total](size_t inner_first, size_t inner_last) {
+                total += inner_last - inner_first;
+            });
+    });
+
+    EXPECT_EQ(80, total.load());
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(Parallel, ParallelForRethrowsExceptions) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(2);
+
+    EXPECT_THROW(parallel::parallel_for(0, 100, 1, [](size_t first, size_t) {
+        if (first == 0)
+            throw runtime_error("chunk failed");
+    }), runtime_error);
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(Parallel, ConcurrentCallersShareThePool) {
+    size_t const previous = parallel::num_threads();
+    parallel::set_num_threads(4);
+
+    vector<size_t> totals(6, 0);
+    vector<thread> callers;
+    for (size_t caller = 0; caller < totals.size(); ++caller)
+        callers.emplace_back([&totals, caller] {
+            atomic<size_t> total{0};
+            for (size_t round = 0; round < 20; ++round)
+                parallel::parallel_for(0, 5000, 16, [&total](size_t first, size_t last) {
+                    total += last - first;
+                });
+            totals[caller] = total.load();
+        });
+
+    for (thread &caller : callers)
+        caller.join();
+
+    for (size_t total : totals)
+        EXPECT_EQ(20 * 5000, total);
+
+    parallel::set_num_threads(previous);
+}
+
+TEST(Parallel, ChunksDoNotDependOnThreadCount) {
+    size_t const previous = parallel::num_threads();
+
+    auto chunks = [](size_t threads) {
+        parallel::set_num_threads(threads);
+
+        mutex guard;
+        vector<pair<size_t, size_t>> ranges;
+        parallel::parallel_for(0, 1000, 30, [&](size_t first, size_t last) {
+            lock_guard lock{guard};
+            ranges.emplace_back(first, last);
+        });
+
+        sort(ranges.begin(), ranges.end());
+        return ranges;
+    };
+
+    auto const serial = chunks(1);
+    EXPECT_EQ(serial, chunks(7));
+
+    size_t covered = 0;
+    for (auto [first, last] : serial)
+    {
+        EXPECT_EQ(covered, first);
+        EXPECT_GE(last - first, 30);
+        covered = last;
+    }
+    EXPECT_EQ(1000, covered);
+
+    parallel::set_num_threads(previous);
+}
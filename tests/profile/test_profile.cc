@@ -0,0 +1,61 @@
+#include "../test.h"
+
+#include <sstream>
+
+namespace
+{
+    profile::Summary const *find(vector<profile::Summary> const &totals, string const &name)
+    {
+        auto it = find_if(totals.begin(), totals.end(), [&name](profile::Summary const &total) {
+            return total.name == name;
+        });
+        return it == totals.end() ? nullptr : &*it;
+    }
+}
+
+TEST(Profile, AggregatesOpsByNameAndShape) {
+    Tensor a{{16, 8}, 1.0};
+    Tensor b{{8, 4}, 2.0};
+
+    profile::enable();
+    for (size_t step = 0; step < 3; ++step)
+    {
+        Tensor c = matmul(a, b);
+        Tensor d = c * 2.0 + c;
+        c += d;
+        EXPECT_EQ(64.0 * 16 * 4, c.sum());
+    }
+    Tensor joined = concatenate(a, a, 1);
+    Tensor rows   = joined.sum({1});
+    profile::disable();
+
+    Tensor untracked = matmul(a, b);
+
+    vector<profile::Summary> const totals = profile::summary();
+    profile::Summary const *product = find(totals, "matmul");
+    ASSERT_NE(nullptr, product);
+    EXPECT_EQ(3, product->calls);
+    EXPECT_EQ("[16,8] [8,4]", product->signature);
+    EXPECT_EQ(3 * 2 * 16 * 8 * 4, product->counters.flops);
+    EXPECT_EQ(3, product->allocations);
+
+    profile::Summary const *expression = find(totals, "expression");
+    ASSERT_NE(nullptr, expression);
+    EXPECT_EQ(3 * 2 * 64, expression->counters.flops);
+
+    ASSERT_NE(nullptr, find(totals, "compound"));
+    ASSERT_NE(nullptr, find(totals, "sum"));
+    ASSERT_NE(nullptr, find(totals, "sum axes"));
+    ASSERT_NE(nullptr, find(totals, "concatenate"));
+    EXPECT_EQ(16 * 16, find(totals, "concatenate")->counters.elements);
+
+    ostringstream trace;
+    profile::write_trace(trace);
+    EXPECT_EQ(0, trace.str().find("{\"traceEvents\":["));
+    EXPECT_NE(string::npos, trace.str().find("\"name\":\"matmul\",\"cat\":\"op\",\"ph\":\"X\""));
+
+    // a new session starts empty
+    profile::enable();
+    profile::disable();
+    EXPECT_TRUE(profile::events().empty());
+}
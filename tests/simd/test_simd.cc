@@ -0,0 +1,185 @@
+#include "../test.h"
+
+namespace
+{
+    vector<simd::Isa> supported_isas()
+    {
+        vector<simd::Isa> isas{simd::Isa::Scalar};
+        if (simd::detected_isa() >= simd::Isa::Avx2)
+            isas.push_back(simd::Isa::Avx2);
+        if (simd::detected_isa() >= simd::Isa::Avx512)
+            isas.push_back(simd::Isa::Avx512);
+        return isas;
+    }
+
+    vector<double> sequence(size_t size, double start, double step)
+    {
+        vector<double> values(size);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = start + step * static_cast<double>(i);
+        return values;
+    }
+}
+
+TEST(Simd, BinaryKernelsMatchScalarOnEveryIsa) {
+    simd::Isa const previous = simd::isa();
+
+    // 37 covers the unrolled body and a partial tail for every width
+    vector<double> lhs = sequence(37, -4.5, 0.25);
+    vector<double> rhs = sequence(37, 3.0, -0.125);
+
+    for (simd::Isa isa : supported_isas())
+    {
+        simd::use_isa(isa);
+
+        vector<double> res(lhs.size());
+
+        simd::add(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_DOUBLE_EQ(lhs[i] + rhs[i], res[i]);
+
+        simd::sub(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_DOUBLE_EQ(lhs[i] - rhs[i], res[i]);
+
+        simd::div(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_DOUBLE_EQ(lhs[i] / rhs[i], res[i]);
+
+        simd::max(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_DOUBLE_EQ(max(lhs[i], rhs[i]), res[i]);
+
+        simd::min(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_DOUBLE_EQ(min(lhs[i], rhs[i]), res[i]);
+    }
+
+    simd::use_isa(previous);
+}
+
+TEST(Simd, ReductionKernelsMatchScalarOnEveryIsa) {
+    simd::Isa const previous = simd::isa();
+
+    // 37 covers the unrolled body, single vectors and a serial tail
+    vector<double> values = sequence(37, -4.5, 0.25);
+    values[17] = 9.0;
+    values[29] = -8.0;
+
+    for (simd::Isa isa : supported_isas())
+    {
+        simd::use_isa(isa);
+
+        for (size_t size : {1, 3, 8, 37})
+        {
+            EXPECT_DOUBLE_EQ(accumulate(values.begin(), values.begin() + size, 0.0),
+                             simd::sum(values.data(), size));
+            EXPECT_EQ(*max_element(values.begin(), values.begin() + size),
+                      simd::max(values.data(), size));
+            EXPECT_EQ(*min_element(values.begin(), values.begin() + size),
+                      simd::min(values.data(), size));
+        }
+        EXPECT_EQ(0.0, simd::sum(values.data(), 0));
+    }
+
+    simd::use_isa(previous);
+}
+
+TEST(Simd, UpdateKernelsMatchScalarOnEveryIsa) {
+    simd::Isa const previous = simd::isa();
+
+    vector<double> grad = sequence(37, -2.0, 0.125);
+    simd::AdamStep const step{0.01, 0.9, 0.999, 1e-8, 1.5};
+
+    for (simd::Isa isa : supported_isas())
+    {
+        simd::use_isa(isa);
+
+        vector<double> y = sequence(37, 1.0, 0.5);
+        simd::axpby(-0.5, grad.data(), 2.0, y.data(), y.size());
+        for (size_t i = 0; i < y.size(); ++i)
+            EXPECT_DOUBLE_EQ(2.0 * (1.0 + 0.5 * i) - 0.5 * grad[i], y[i]);
+
+        vector<double> velocity(37, 1.0);
+        vector<double> weights(37, 0.0);
+        simd::momentum(grad.data(), velocity.data(), weights.data(), 0.1, 0.9, weights.size());
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            EXPECT_DOUBLE_EQ(0.9 + grad[i], velocity[i]);
+            EXPECT_NEAR(-0.1 * (0.9 + grad[i]), weights[i], 1e-15);
+        }
+
+        vector<double> m(37, 0.0), v(37, 0.0);
+        weights.assign(37, 0.0);
+        simd::adam(grad.data(), m.data(), v.data(), weights.data(), step, weights.size());
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            double const mi = 0.1 * grad[i];
+            double const vi = 0.001 * grad[i] * grad[i];
+            EXPECT_NEAR(mi, m[i], 1e-15);
+            EXPECT_NEAR(vi, v[i], 1e-15);
+            EXPECT_NEAR(-0.01 * mi / (sqrt(vi) * 1.5 + 1e-8), weights[i], 1e-12);
+        }
+    }
+
+    simd::use_isa(previous);
+}
+
+TEST(Simd, Float32KernelsMatchScalarOnEveryIsa) {
+    simd::Isa const previous = simd::isa();
+
+    // 77 covers the unrolled body and a partial tail of 16 lanes
+    vector<float> lhs(77), rhs(77);
+    for (size_t i = 0; i < lhs.size(); ++i)
+    {
+        lhs[i] = -4.5f + 0.25f * static_cast<float>(i);
+        rhs[i] = 3.0f - 0.125f * static_cast<float>(i);
+    }
+
+    for (simd::Isa isa : supported_isas())
+    {
+        simd::use_isa(isa);
+
+        vector<float> res(lhs.size());
+
+        simd::add(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_FLOAT_EQ(lhs[i] + rhs[i], res[i]);
+
+        simd::mul(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_FLOAT_EQ(lhs[i] * rhs[i], res[i]);
+
+        simd::div(lhs.data(), rhs.data(), res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_FLOAT_EQ(lhs[i] / rhs[i], res[i]);
+
+        // multiples of 1/4 sum exactly in any order
+        EXPECT_EQ(accumulate(lhs.begin(), lhs.end(), 0.0f), simd::sum(lhs.data(), lhs.size()));
+
+        res = rhs;
+        simd::axpby(-0.5f, lhs.data(), 2.0f, res.data(), res.size());
+        for (size_t i = 0; i < res.size(); ++i)
+            EXPECT_FLOAT_EQ(2.0f * rhs[i] - 0.5f * lhs[i], res[i]);
+    }
+
+    simd::use_isa(previous);
+}
+
+TEST(Simd, ScalarKernelsWorkInPlace) {
+    simd::Isa const previous = simd::isa();
+
+    for (simd::Isa isa : supported_isas())
+    {
+        simd::use_isa(isa);
+
+        vector<double> values = sequence(21, 1.0, 1.0);
+        simd::mul(values.data(), 2.0, values.data(), values.size());
+        simd::sub(values.data(), 1.0, values.data(), values.size());
+
+        for (size_t i = 0; i < values.size(); ++i)
+            EXPECT_DOUBLE_EQ(2.0 * static_cast<double>(i + 1) - 1.0, values[i]);
+    }
+
+    simd::use_isa(previous);
+}
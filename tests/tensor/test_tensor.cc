@@ -1,5 +1,10 @@
 #include "../test.h"
 
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
 TEST(Tensor, CostructorInitializesDataVectorCorrectly) {
     Tensor const t{{5, 4}, 2.0};
 
@@ -42,6 +47,25 @@ TEST(Tensor, TensorIndex) {
     });
 }
 
+TEST(Tensor, TensorMultiIndex) {
+    Tensor t1{{2, 3, 2}, {
+        0.0, 1.0,   2.0, 3.0,   4.0, 5.0,
+        6.0, 7.0,   8.0, 9.0,  10.0, 11.0,
+    }};
+
+    auto t2 = t1(1, 2);
+
+    EXPECT_THAT(t2.shape(), ::testing::ContainerEq(vector<size_t>{2}));
+    EXPECT_EQ(10.0, *t2.cbegin());
+    EXPECT_EQ(11.0, *(t2.cbegin() + 1));
+}
+
+TEST(Tensor, DimsRejectRankAboveMax) {
+    vector<size_t> shape(Dims::max_rank + 1, 1);
+
+    EXPECT_THROW(Tensor{shape}, length_error);
+}
+
 // TEST(Tensor, TensorOperationDimensionsIncompatible) {
 //     Tensor t1{{3, 2, 3}};
 //     Tensor t2{{3, 3}};
@@ -113,3 +137,406 @@ TEST(Tensor, TensorIndex) {
 //     EXPECT_THAT(strides_b, ::testing::ContainerEq(vector<size_t>{0, 3, 1}));
 //     EXPECT_THAT(strides_res, ::testing::ContainerEq(vector<size_t>{6, 3, 1}));
 // }
+
+TEST(Tensor, BroadcastIteratorCollapsesContiguousAxes) {
+    Tensor t1{{2, 3, 4}};
+    Tensor t2{{2, 3, 4}};
+
+    BroadcastIterator iter{prepare_broadcast(t1, t2)};
+
+    EXPECT_EQ(1, iter.runs());
+    EXPECT_EQ(24, iter.length());
+    EXPECT_EQ(1, iter.lhs_step());
+    EXPECT_EQ(1, iter.rhs_step());
+}
+
+TEST(Tensor, BroadcastIteratorWalksBroadcastAxes) {
+    Tensor t1{{2, 3, 4}};
+    Tensor t2{{1, 3, 1}};
+
+    BroadcastIterator iter{prepare_broadcast(t1, t2)};
+
+    EXPECT_EQ(6, iter.runs());
+    EXPECT_EQ(4, iter.length());
+    EXPECT_EQ(0, iter.rhs_step());
+
+    vector<size_t> expected_rhs{0, 1, 2, 0, 1, 2};
+    for (size_t run = 0; run < iter.runs(); ++run, iter.next())
+    {
+        EXPECT_EQ(run * 4, iter.res());
+        EXPECT_EQ(run * 4, iter.lhs());
+        EXPECT_EQ(expected_rhs[run], iter.rhs());
+    }
+}
+
+namespace
+{
+    vector<double> elements(Tensor const &t)
+    {
+        return vector<double>(t.cbegin(), t.cend());
+    }
+}
+
+TEST(Tensor, ViewsShareStorage) {
+    Tensor t{{2, 3}, {
+        0.0, 1.0, 2.0,
+        3.0, 4.0, 5.0,
+    }};
+
+    Tensor tr = t.transpose();
+    EXPECT_THAT(tr.shape(), ::testing::ContainerEq(vector<size_t>{3, 2}));
+    EXPECT_FALSE(tr.is_contiguous());
+    EXPECT_THAT(elements(tr), ::testing::ElementsAre(0.0, 3.0, 1.0, 4.0, 2.0, 5.0));
+
+    Tensor cols = t.slice(1, 0, 3, 2);
+    EXPECT_THAT(elements(cols), ::testing::ElementsAre(0.0, 2.0, 3.0, 5.0));
+
+    cols += 10.0;
+    tr[1] = Tensor{{2}, {-1.0, -4.0}};
+    EXPECT_THAT(elements(t), ::testing::ElementsAre(10.0, -1.0, 12.0, 13.0, -4.0, 15.0));
+
+    Tensor cube{{2, 3, 4}};
+    Tensor perm = cube.permute({2, 0, 1});
+    EXPECT_THAT(perm.shape(), ::testing::ContainerEq(vector<size_t>{4, 2, 3}));
+    EXPECT_THAT(perm.strides(), ::testing::ContainerEq(vector<size_t>{1, 12, 4}));
+
+    Tensor row = Tensor{{3}, {1.0, 2.0, 3.0}}.unsqueeze(0);
+    Tensor wide = row.expand({2, 3});
+    EXPECT_THAT(wide.strides(), ::testing::ContainerEq(vector<size_t>{0, 1}));
+    EXPECT_THAT(elements(wide), ::testing::ElementsAre(1.0, 2.0, 3.0, 1.0, 2.0, 3.0));
+    EXPECT_THAT(wide.slice(0, 0, 1).squeeze().shape(), ::testing::ContainerEq(vector<size_t>{3}));
+
+    EXPECT_THROW(t.slice(1, 2, 2), invalid_argument);
+    EXPECT_THROW(t.permute({0, 0}), invalid_argument);
+    EXPECT_THROW(t.expand({2, 4}), invalid_argument);
+    EXPECT_THROW(t.squeeze(0), invalid_argument);
+}
+
+TEST(Tensor, ReshapeCopiesOnlyWhenStridesRequire) {
+    Tensor t{{4, 6}};
+    for (size_t i = 0; i < t.size(); ++i)
+        t.data()[i] = static_cast<double>(i);
+
+    Tensor flat = t.reshape({24});
+    EXPECT_EQ(t.data(), flat.data());
+
+    // rows 1 and 2 keep their columns contiguous, so splitting them is free
+    Tensor rows = t.slice(0, 1, 3).reshape({2, 2, 3});
+    EXPECT_EQ(t.data() + 6, rows.data());
+    EXPECT_THAT(rows.strides(), ::testing::ContainerEq(vector<size_t>{6, 3, 1}));
+
+    Tensor merged = t.transpose().reshape({24});
+    EXPECT_NE(t.data(), merged.data());
+    EXPECT_EQ(6.0, merged.data()[1]);
+
+    EXPECT_THROW(t.reshape({5, 5}), invalid_argument);
+}
+
+TEST(Tensor, ConcatenateAndStackAlongAnyAxis) {
+    Tensor a{{2, 2}, {1.0, 2.0, 3.0, 4.0}};
+    Tensor b{{2, 1}, {5.0, 6.0}};
+    Tensor c{{2, 3}, {7.0, 8.0, 9.0, 10.0, 11.0, 12.0}};
+
+    vector<Tensor> const columns{a, b, a.transpose()};
+    Tensor joined = concatenate(columns, 1);
+    EXPECT_THAT(joined.shape(), ::testing::ElementsAre(2, 5));
+    EXPECT_THAT(elements(joined), ::testing::ElementsAre(1.0, 2.0, 5.0, 1.0, 3.0,
+                                                         3.0, 4.0, 6.0, 2.0, 4.0));
+
+    EXPECT_THAT(elements(concatenate(a, c, 1)),
+                ::testing::ElementsAre(1.0, 2.0, 7.0, 8.0, 9.0, 3.0, 4.0, 10.0, 11.0, 12.0));
+    EXPECT_EQ(8, concatenate(b, c, nullopt).size());
+    EXPECT_THAT(elements(concatenate(a.transpose(), b, nullopt)),
+                ::testing::ElementsAre(1.0, 3.0, 2.0, 4.0, 5.0, 6.0));
+
+    // strided inputs are read in place: the result is the only allocation
+    size_t const before = memory::thread_allocations().count;
+    Tensor const rows = concatenate(columns, 1);
+    EXPECT_EQ(before + 1, memory::thread_allocations().count);
+    EXPECT_THAT(elements(rows), ::testing::ContainerEq(elements(joined)));
+
+    vector<Tensor> const pair{a, a.transpose()};
+    Tensor stacked = stack(pair, 1);
+    EXPECT_THAT(stacked.shape(), ::testing::ElementsAre(2, 2, 2));
+    EXPECT_THAT(elements(stacked), ::testing::ElementsAre(1.0, 2.0, 1.0, 3.0, 3.0, 4.0, 2.0, 4.0));
+
+    EXPECT_THROW(concatenate(a, c, 0), std::runtime_error);
+    EXPECT_THROW(concatenate(a, c, 2), std::invalid_argument);
+    EXPECT_THROW(stack(vector<Tensor>{a, b}), std::invalid_argument);
+}
+
+TEST(Tensor, SavedTensorsMapBackWithoutCopying) {
+    string const path = ::testing::TempDir() + "tensor_io.bin";
+    Tensor t{{3, 4}};
+    for (size_t i = 0; i < t.size(); ++i)
+        t.data()[i] = 0.25 * static_cast<double>(i);
+
+    save(t, path);
+    Tensor loaded = load(path);
+    EXPECT_THAT(loaded.shape(), ::testing::ElementsAre(3, 4));
+    EXPECT_THAT(elements(loaded), ::testing::ContainerEq(elements(t)));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(loaded.data()) % 64);
+
+    // writes stay private to the mapping
+    loaded.data()[0] = -1.0;
+    EXPECT_EQ(0.0, load(path).data()[0]);
+
+    // a transpose keeps its layout, a strided slice is compacted
+    save(t.transpose(), path);
+    Tensor transposed = load(path);
+    EXPECT_THAT(transposed.strides(), ::testing::ElementsAre(1, 4));
+    EXPECT_THAT(elements(transposed), ::testing::ContainerEq(elements(t.transpose())));
+
+    save(t.slice(1, 0, 4, 3), path);
+    EXPECT_THAT(elements(load(path)), ::testing::ElementsAre(0.0, 0.75, 1.0, 1.75, 2.0, 2.75));
+
+    EXPECT_THROW(save(t(1, 2), path), runtime_error);
+    EXPECT_THAT(load(path).shape(), ::testing::ElementsAre(3, 2));
+
+    ofstream{path} << t;
+    EXPECT_THROW(load(path), runtime_error);
+    EXPECT_THROW(load(path + ".missing"), system_error);
+    remove(path.c_str());
+}
+
+TEST(Tensor, SavedBasicTensorsKeepTheirElementType) {
+    string const path = ::testing::TempDir() + "basic_tensor_io.bin";
+
+    Float32Tensor const f{{3}, {0.5f, -1.25f, 3.0f}};
+    save(f, path);
+    Float32Tensor const loaded = load<float>(path);
+    EXPECT_THAT(loaded.shape(), ::testing::ElementsAre(3));
+    EXPECT_THAT(vector<float>(loaded.cbegin(), loaded.cend()), ::testing::ElementsAre(0.5f, -1.25f, 3.0f));
+    EXPECT_THROW(load<bfloat16>(path), runtime_error);
+    EXPECT_THROW(load(path), runtime_error);
+
+    BFloat16Tensor const b = astype<bfloat16>(Float32Tensor{{2, 3}, {1, 2, 3, 4, 5, 6}});
+    save(b, path);
+    BFloat16Tensor const back = load<bfloat16>(path);
+    EXPECT_THAT(back.shape(), ::testing::ElementsAre(2, 3));
+    EXPECT_FLOAT_EQ(21.0f, back.sum());
+    EXPECT_THROW(load<float>(path), runtime_error);
+
+    save(Tensor{{2}, 1.0}, path);
+    EXPECT_THROW(load<float>(path), runtime_error);
+    remove(path.c_str());
+}
+
+TEST(Tensor, BatchReaderStreamsRowsAcrossShards) {
+    string const dir = ::testing::TempDir() + "tensor_shards";
+    filesystem::create_directories(dir);
+
+    // shards of 5, 3 and 4 rows numbered 0..11 by row
+    size_t first = 0;
+    for (size_t rows : {5, 3, 4})
+    {
+        Tensor shard{{rows, 2}};
+        for (size_t row = 0; row < rows; ++row)
+            shard(row) = static_cast<double>(first + row);
+        save(shard, dir + "/part" + to_string(first));
+        first += rows;
+    }
+
+    BatchReader reader{dir, 5, 1};
+    EXPECT_EQ(12, reader.rows());
+    EXPECT_EQ(3, reader.batches());
+    EXPECT_THAT(reader.row_shape(), ::testing::ElementsAre(2));
+
+    vector<double> seen;
+    vector<size_t> sizes;
+    while (optional<Tensor> batch = reader.next())
+    {
+        sizes.push_back(batch->shape()[0]);
+        for (size_t row = 0; row < batch->shape()[0]; ++row)
+            seen.push_back((*batch)(row, 1).scalar());
+    }
+    EXPECT_THAT(sizes, ::testing::ElementsAre(5, 5, 2));
+    EXPECT_THAT(seen, ::testing::ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11));
+    EXPECT_FALSE(reader.next());
+
+    save(Tensor{{2, 3}}, dir + "/wide");
+    EXPECT_THROW(BatchReader(dir, 4), runtime_error);
+    save(Tensor{{2, 3}}.transpose(), dir + "/wide");
+    EXPECT_THROW(BatchReader(dir + "/wide", 4), runtime_error);
+
+    filesystem::remove_all(dir);
+}
+
+TEST(Tensor, KernelsRespectStrides) {
+    Tensor a{{3, 2}, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0}};
+    Tensor b{{3, 4}};
+    for (size_t i = 0; i < b.size(); ++i)
+        b.data()[i] = 0.5 * static_cast<double>(i) - 2.0;
+
+    Tensor at = a.transpose();
+    Tensor dense = at.contiguous();
+    EXPECT_TRUE(dense.is_contiguous());
+
+    Tensor expected = matmul(dense, b);
+    Tensor product  = matmul(at, b);
+    EXPECT_THAT(elements(product), ::testing::ContainerEq(elements(expected)));
+
+    Tensor vec = matmul(b.transpose(), Tensor{{3}, {1.0, 0.0, -1.0}});
+    EXPECT_THAT(elements(vec), ::testing::ElementsAre(-4.0, -4.0, -4.0, -4.0));
+
+    Tensor lazy = at * 2.0 + at;
+    EXPECT_THAT(elements(lazy), ::testing::ElementsAre(3.0, 9.0, 15.0, 6.0, 12.0, 18.0));
+    EXPECT_THAT(elements(at.sum({1})), ::testing::ElementsAre(9.0, 12.0));
+    EXPECT_EQ(21.0, at.sum());
+
+    at *= Tensor{{3}, {1.0, 10.0, 100.0}};
+    EXPECT_THAT(elements(a), ::testing::ElementsAre(1.0, 2.0, 30.0, 40.0, 500.0, 600.0));
+
+    stringstream printed;
+    printed << Tensor{{2, 2}, {1.0, 2.0, 3.0, 4.0}}.transpose();
+    EXPECT_EQ("(2, 2)\n[\n   [1, 3]\n   [2, 4]\n]\n", printed.str());
+}
+
+TEST(BasicTensor, HalfFormatsRoundToNearestEven) {
+    auto bits16 = [](float value) { return float16{value}.bits; };
+    auto bitsbf = [](float value) { return bfloat16{value}.bits; };
+
+    EXPECT_EQ(0x3c00, bits16(1.0f));
+    EXPECT_EQ(0x7bff, bits16(65519.0f));                // rounds down to 65504
+    EXPECT_EQ(0x7c00, bits16(65520.0f));                // halfway to 65536: inf
+    EXPECT_EQ(0x0001, bits16(0x1p-24f));                // smallest subnormal
+    EXPECT_EQ(0x0000, bits16(0x1p-25f));                // tie to even
+    EXPECT_EQ(0x0002, bits16(0x1.8p-24f));
+    EXPECT_EQ(0x8000, bits16(-0.0f));
+    EXPECT_TRUE(std::isnan(static_cast<float>(float16{NAN})));
+
+    EXPECT_EQ(0x3f80, bitsbf(1.0f));
+    EXPECT_EQ(0x3f80, bitsbf(1.0f + 0x1p-8f));          // tie to even
+    EXPECT_EQ(0x3f82, bitsbf(1.0f + 0x1.8p-7f));
+    EXPECT_TRUE(std::isnan(static_cast<float>(bfloat16{NAN})));
+
+    // every finite half survives a round trip through float
+    for (uint32_t bits = 0; bits < 0x10000; ++bits)
+    {
+        float16 half;
+        half.bits = static_cast<uint16_t>(bits);
+        if ((bits & 0x7c00) != 0x7c00)
+        {
+            EXPECT_EQ(bits, float16{static_cast<float>(half)}.bits);
+        }
+    }
+}
+
+TEST(BasicTensor, ComputesInTheAccumulateType) {
+    size_t const m = 33, k = 300, n = 40;
+    Tensor a{{m, k}, uninitialized};
+    Tensor b{{k, n}, uninitialized};
+    for (size_t i = 0; i < a.size(); ++i)
+        a.data()[i] = std::sin(static_cast<double>(i));
+    for (size_t i = 0; i < b.size(); ++i)
+        b.data()[i] = std::cos(static_cast<double>(i));
+
+    auto close = [](Tensor const &actual, Tensor const &expected, double tolerance) {
+        ASSERT_EQ(actual.shape(), expected.shape());
+        for (size_t i = 0; i < actual.size(); ++i)
+            EXPECT_NEAR(expected.data()[i], actual.data()[i], tolerance);
+    };
+
+    // float32 against the double result of the same (rounded) inputs, on
+    // the micro-kernel of every ISA
+    Float32Tensor const fa = astype<float>(a);
+    Float32Tensor const fb = astype<float>(b);
+    simd::Isa const previous = simd::isa();
+    for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::Avx2, simd::Isa::Avx512})
+    {
+        if (isa > simd::detected_isa())
+            continue;
+
+        simd::use_isa(isa);
+        close(to_tensor(matmul(fa, fb)), matmul(to_tensor(fa), to_tensor(fb)), 1e-4);
+    }
+    simd::use_isa(previous);
+    close(to_tensor(matmul(fa, astype<float>(b.slice(1, 0, 1).squeeze()))),
+          matmul(to_tensor(fa), to_tensor(fb).slice(1, 0, 1).squeeze()), 1e-4);
+
+    // bf16 storage: products accumulate in float and round once
+    BFloat16Tensor const ha = astype<bfloat16>(a);
+    BFloat16Tensor const hb = astype<bfloat16>(b);
+    Tensor const exact = matmul(to_tensor(ha), to_tensor(hb));
+    close(to_tensor(matmul(ha, hb)), to_tensor(astype<bfloat16>(exact)), 0.07);
+    EXPECT_NEAR(to_tensor(ha).sum(), ha.sum(), 1e-3);
+
+    // broadcasting element-wise ops
+    Float16Tensor row{{3}, {float16{1.0f}, float16{2.0f}, float16{3.0f}}};
+    Float16Tensor grid{{2, 3}, float16{0.5f}};
+    grid += row;
+    EXPECT_THAT(to_tensor(grid * row).shape(), ::testing::ElementsAre(2, 3));
+    EXPECT_EQ(1.5f * 1 + 2.5f * 2 + 3.5f * 3, static_cast<float>((grid * row).sum()) / 2);
+    EXPECT_THROW(row += grid, std::invalid_argument);
+
+    // int32 accumulates in int64
+    Int32Tensor big{{2, 2}, int32_t{1} << 30};
+    EXPECT_EQ(int64_t{1} << 32, big.sum());
+    Int32Tensor lhs{{2, 3}, {1, 2, 3, 4, 5, 6}};
+    Int32Tensor rhs{{3}, {1, 0, -1}};
+    Int32Tensor product = matmul(lhs, rhs);
+    EXPECT_THAT(vector<int32_t>(product.cbegin(), product.cend()), ::testing::ElementsAre(-2, -2));
+    Int32Tensor difference = lhs - rhs;
+    EXPECT_THAT(vector<int32_t>(difference.cbegin(), difference.cend()),
+                ::testing::ElementsAre(0, 2, 4, 3, 5, 7));
+    EXPECT_THROW(lhs / rhs, std::invalid_argument);
+    EXPECT_THROW(lhs /= rhs, std::invalid_argument);
+    EXPECT_THAT(vector<int32_t>(lhs.cbegin(), lhs.cend()), ::testing::ElementsAre(1, 2, 3, 4, 5, 6));
+    Int32Tensor quotient = lhs / Int32Tensor{{3}, {1, 2, -3}};
+    EXPECT_THAT(vector<int32_t>(quotient.cbegin(), quotient.cend()),
+                ::testing::ElementsAre(1, 1, -1, 4, 2, -2));
+}
+
+TEST(BasicTensor, ReducesAxesAndBatchesMatmul) {
+    Tensor t{{2, 3, 4}, uninitialized};
+    for (size_t i = 0; i < t.size(); ++i)
+        t.data()[i] = std::sin(static_cast<double>(i));
+
+    auto values = [](auto const &tensor) {
+        return vector<double>(tensor.cbegin(), tensor.cend());
+    };
+    auto close = [](Tensor const &actual, Tensor const &expected, double tolerance) {
+        ASSERT_EQ(actual.shape(), expected.shape());
+        for (size_t i = 0; i < actual.size(); ++i)
+            EXPECT_NEAR(expected.data()[i], actual.data()[i], tolerance);
+    };
+
+    // float32 against the double reductions of the same inputs
+    Float32Tensor const f = astype<float>(t);
+    Tensor const exact = to_tensor(f);
+    for (Dims const &axes : {Dims{2}, Dims{0}, Dims{0, 2}, Dims{}})
+    {
+        close(to_tensor(f.sum(axes, true)), exact.sum(axes, true), 1e-5);
+        close(to_tensor(f.mean(axes)), exact.mean(axes), 1e-6);
+        close(to_tensor(f.max(axes)), exact.max(axes), 0);
+        close(to_tensor(f.min(axes, true)), exact.min(axes, true), 0);
+    }
+    Int32Tensor const best = f.argmax(1, true);
+    EXPECT_THAT(best.shape(), ::testing::ElementsAre(2, 1, 4));
+    EXPECT_EQ(values(best), values(exact.argmax(1, true)));
+    EXPECT_THROW(f.sum({3}), std::invalid_argument);
+
+    // bf16 sums accumulate in float and round once
+    BFloat16Tensor const h = astype<bfloat16>(BasicTensor<float>{{2, 300}, 0.01f});
+    EXPECT_NEAR(3.0f, static_cast<float>(h.sum({1}).data()[0]), 0.02f);
+
+    // int32 reductions accumulate in int64, means truncate
+    Int32Tensor const ints{{2, 3}, {1, 2, 4, -3, 5, 7}};
+    EXPECT_THAT(values(ints.sum({0})), ::testing::ElementsAre(-2, 7, 11));
+    EXPECT_THAT(values(ints.mean({1})), ::testing::ElementsAre(2, 3));
+    EXPECT_THAT(values(ints.max({1})), ::testing::ElementsAre(4, 7));
+
+    // batches broadcast as for Tensors
+    Tensor w{{4, 5}, uninitialized};
+    for (size_t i = 0; i < w.size(); ++i)
+        w.data()[i] = std::cos(static_cast<double>(i));
+    Float32Tensor const fw = astype<float>(w);
+    close(to_tensor(matmul(f, fw)), matmul(exact, to_tensor(fw)), 1e-5);
+    close(to_tensor(matmul(astype<bfloat16>(t), astype<bfloat16>(w))),
+          to_tensor(astype<bfloat16>(matmul(to_tensor(astype<bfloat16>(t)),
+                                            to_tensor(astype<bfloat16>(w))))),
+          0.02);
+    Int32Tensor const batched = matmul(Int32Tensor{{2, 1, 2}, {1, 2, 3, 4}}, Int32Tensor{{2, 1}, {1, -1}});
+    EXPECT_THAT(batched.shape(), ::testing::ElementsAre(2, 1, 1));
+    EXPECT_THAT(values(batched), ::testing::ElementsAre(-1, -1));
+}
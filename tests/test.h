@@ -1,5 +1,11 @@
 #include "../tensor/tensor.h"
+#include "../tensor/basic_tensor.h"
+#include "../tensor/reader.h"
 #include "../linalg/linalg.h"
+#include "../simd/simd.h"
+#include "../parallel/parallel.h"
+#include "../memory/memory.h"
+#include "../autograd/autograd.h"
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>